@@ -0,0 +1,78 @@
+
+#include "accuraterip.h"
+
+#include <QFile>
+
+#include <KStandardDirs>
+
+
+// every track entry is a confidence byte, the checksum and the checksum of frame 450
+#define TrackEntrySize 9
+#define DiscHeaderSize 13
+
+
+static quint32 readUInt32( const uchar *data )
+{
+    return data[0] | data[1] << 8 | data[2] << 16 | (quint32)data[3] << 24;
+}
+
+
+QString AccurateRipDatabase::directory()
+{
+    return KStandardDirs::locateLocal( "data", "soundkonverter/accuraterip/" );
+}
+
+QString AccurateRipDatabase::fileName( const QList<int>& discOffsets )
+{
+    const int trackCount = discOffsets.count() - 1;
+
+    quint32 id1 = 0;
+    quint32 id2 = 0;
+    quint32 digitSum = 0;
+    for( int i=0; i<=trackCount; i++ )
+    {
+        const quint32 sector = discOffsets.at(i) - 150;
+        id1 += sector;
+        id2 += qMax( sector, (quint32)1 ) * ( i + 1 );
+
+        if( i < trackCount )
+        {
+            for( int seconds = discOffsets.at(i) / 75; seconds > 0; seconds /= 10 )
+                digitSum += seconds % 10;
+        }
+    }
+
+    const quint32 length = discOffsets.last() / 75 - discOffsets.first() / 75;
+    const quint32 cddbId = ( digitSum % 0xFF ) << 24 | length << 8 | trackCount;
+
+    return QString("dBAR-%1-%2-%3-%4.bin").arg(trackCount,3,10,QChar('0')).arg(id1,8,16,QChar('0')).arg(id2,8,16,QChar('0')).arg(cddbId,8,16,QChar('0'));
+}
+
+int AccurateRipDatabase::confidence( const QList<int>& discOffsets, int track, quint32 checksumV1, quint32 checksumV2 )
+{
+    QFile file( directory() + fileName(discOffsets) );
+    if( !file.open(QIODevice::ReadOnly) )
+        return -1;
+
+    const QByteArray content = file.readAll();
+    const uchar *data = (const uchar*)content.constData();
+
+    // the file holds one block per pressing, v1 and v2 checksums are stored in separate blocks
+    int confidence = 0;
+    int position = 0;
+    while( position + DiscHeaderSize <= content.size() )
+    {
+        const int trackCount = data[position];
+        const int entry = position + DiscHeaderSize + ( track - 1 ) * TrackEntrySize;
+        position += DiscHeaderSize + trackCount * TrackEntrySize;
+
+        if( track > trackCount || position > content.size() )
+            continue;
+
+        const quint32 checksum = readUInt32( data + entry + 1 );
+        if( checksum == checksumV1 || checksum == checksumV2 )
+            confidence += data[entry];
+    }
+
+    return confidence;
+}
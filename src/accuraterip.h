@@ -0,0 +1,31 @@
+
+#ifndef ACCURATERIP_H
+#define ACCURATERIP_H
+
+#include <QList>
+#include <QString>
+
+
+/**
+ * @short Looks up the checksums of ripped tracks in a local copy of the AccurateRip database
+ *
+ * The database files (dBAR-*.bin) of the discs need to be imported into the folder
+ * returned by directory(), there is no online lookup.
+ */
+class AccurateRipDatabase
+{
+public:
+    /** Returns the folder with the imported database files */
+    static QString directory();
+
+    /** Returns the name of the database file for the disc with the track start sectors @p discOffsets (+150), the last offset is the lead-out */
+    static QString fileName( const QList<int>& discOffsets );
+
+    /**
+     * Compares the checksums of @p track with all pressings of the disc in the database.
+     * Returns the number of matching rips, 0 if no rip matches and -1 if the disc hasn't been imported.
+     */
+    static int confidence( const QList<int>& discOffsets, int track, quint32 checksumV1, quint32 checksumV2 );
+};
+
+#endif // ACCURATERIP_H
@@ -0,0 +1,131 @@
+
+#include "concurrencycontroller.h"
+#include "logger.h"
+
+#include <KLocale>
+
+#include <QFile>
+#include <QStringList>
+#include <QThread>
+#include <QTimer>
+
+
+// the sample interval in ms, long enough to not react to the start of a single backend
+#define SampleInterval 3000
+// decrease the limit if more than this part of the processor time is spent waiting for I/O
+#define MaxIoWaitRatio 0.20
+// increase the limit only if less than this part of the processor time is spent waiting for I/O
+#define IncreaseIoWaitRatio 0.05
+
+
+ConcurrencyController::ConcurrencyController( Logger *_logger, QObject *parent )
+    : QObject( parent ),
+    logger( _logger )
+{
+    processorCount = QThread::idealThreadCount();
+    if( processorCount < 1 )
+        processorCount = 1;
+
+    minimumLimit = 1;
+    maximumLimit = processorCount * 2; // I/O bound jobs can use more than one job per core
+    currentLimit = processorCount;
+    runningCount = 0;
+
+    lastBusy = 0;
+    lastIdle = 0;
+    lastIoWait = 0;
+
+    sampleTimer = new QTimer( this );
+    connect( sampleTimer, SIGNAL(timeout()), this, SLOT(sample()) );
+}
+
+ConcurrencyController::~ConcurrencyController()
+{}
+
+void ConcurrencyController::start( int initialLimit )
+{
+    currentLimit = qBound( minimumLimit, initialLimit, maximumLimit );
+
+    if( !readProcStat(&lastBusy,&lastIdle,&lastIoWait) )
+    {
+        logger->log( 1000, i18n("Processor statistics are not available, converting %1 files at once",currentLimit) );
+        return;
+    }
+
+    sampleTimer->start( SampleInterval );
+}
+
+void ConcurrencyController::stop()
+{
+    sampleTimer->stop();
+}
+
+bool ConcurrencyController::isRunning() const
+{
+    return sampleTimer->isActive();
+}
+
+bool ConcurrencyController::readProcStat( qint64 *busy, qint64 *idle, qint64 *ioWait )
+{
+    QFile file( "/proc/stat" );
+    if( !file.open(QIODevice::ReadOnly) )
+        return false;
+
+    // cpu  user nice system idle iowait irq softirq steal ...
+    const QStringList fields = QString::fromLatin1( file.readLine() ).simplified().split( ' ' );
+    if( fields.count() < 6 || fields.at(0) != "cpu" )
+        return false;
+
+    *busy = 0;
+    for( int i=1; i<fields.count() && i<=8; i++ )
+    {
+        if( i != 4 && i != 5 )
+            *busy += fields.at(i).toLongLong();
+    }
+    *idle = fields.at(4).toLongLong();
+    *ioWait = fields.at(5).toLongLong();
+
+    return true;
+}
+
+void ConcurrencyController::sample()
+{
+    qint64 busy, idle, ioWait;
+    if( !readProcStat(&busy,&idle,&ioWait) )
+        return;
+
+    const double busyDelta = busy - lastBusy;
+    const double idleDelta = idle - lastIdle;
+    const double ioWaitDelta = ioWait - lastIoWait;
+    const double total = busyDelta + idleDelta + ioWaitDelta;
+
+    lastBusy = busy;
+    lastIdle = idle;
+    lastIoWait = ioWait;
+
+    if( total <= 0 )
+        return;
+
+    const double ioWaitRatio = ioWaitDelta / total;
+    const double idleCores = idleDelta / total * processorCount;
+
+    int newLimit = currentLimit;
+    if( ioWaitRatio > MaxIoWaitRatio )
+    {
+        // the disks can't keep up, more jobs would only make it worse
+        newLimit--;
+    }
+    else if( ioWaitRatio < IncreaseIoWaitRatio && idleCores >= 1.0 && runningCount >= currentLimit )
+    {
+        // at least one core is idle although all slots are in use
+        newLimit++;
+    }
+
+    newLimit = qBound( minimumLimit, newLimit, maximumLimit );
+    if( newLimit != currentLimit )
+    {
+        logger->log( 1000, i18n("Converting %1 files at once (%2% idle, %3% waiting for I/O)",newLimit,(int)(idleDelta/total*100),(int)(ioWaitRatio*100)) );
+        currentLimit = newLimit;
+        emit limitChanged( currentLimit );
+    }
+}
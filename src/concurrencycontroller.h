@@ -0,0 +1,63 @@
+
+#ifndef CONCURRENCYCONTROLLER_H
+#define CONCURRENCYCONTROLLER_H
+
+#include <QObject>
+
+class Logger;
+class QTimer;
+
+
+/**
+ * @short Adjusts the number of files that get converted at once to the load of the system
+ *
+ * While running, the controller samples the processor statistics in /proc/stat.
+ * If there's unused processor time and the disks are keeping up, the limit gets
+ * increased, if the processors are waiting for I/O most of the time (e.g. when
+ * copying files or reading from a network share) it gets decreased.
+ */
+class ConcurrencyController : public QObject
+{
+    Q_OBJECT
+public:
+    ConcurrencyController( Logger *_logger, QObject *parent );
+    ~ConcurrencyController();
+
+    /** Starts sampling, the limit starts at @p initialLimit */
+    void start( int initialLimit );
+    void stop();
+
+    bool isRunning() const;
+
+    /** The number of files that should be converted at once */
+    int limit() const { return currentLimit; }
+
+    /** The number of files that are being converted, the limit is only increased if it's actually used */
+    void setRunningCount( int count ) { runningCount = count; }
+
+signals:
+    /** The limit has been changed to @p limit */
+    void limitChanged( int limit );
+
+private slots:
+    void sample();
+
+private:
+    /** Reads the accumulated busy, idle and iowait jiffies of all processors, returns false if /proc/stat isn't available */
+    static bool readProcStat( qint64 *busy, qint64 *idle, qint64 *ioWait );
+
+    Logger *logger;
+    QTimer *sampleTimer;
+
+    int processorCount;
+    int minimumLimit;
+    int maximumLimit;
+    int currentLimit;
+    int runningCount;
+
+    qint64 lastBusy;
+    qint64 lastIdle;
+    qint64 lastIoWait;
+};
+
+#endif // CONCURRENCYCONTROLLER_H
@@ -20,6 +20,9 @@ Config::Config( Logger *_logger, QObject *parent )
     pPluginLoader = new PluginLoader( logger, this );
     pTagEngine = new TagEngine( this );
     pConversionOptionsManager = new ConversionOptionsManager( pPluginLoader, this );
+    pMirrorManifest = new MirrorManifest( this );
+    pConversionCache = new ConversionCache( this );
+    pTimeModel = new TimeModel( this );
 }
 
 Config::~Config()
@@ -55,11 +58,18 @@ void Config::load()
     data.general.waitForAlbumGain = group.readEntry( "waitForAlbumGain", true );
     data.general.useVFATNames = group.readEntry( "useVFATNames", false );
     data.general.copyIfSameCodec = group.readEntry( "copyIfSameCodec", false );
+    data.general.remuxIfSameCodec = group.readEntry( "remuxIfSameCodec", false );
     data.general.writeLogFiles = group.readEntry( "writeLogFiles", false );
     data.general.conflictHandling = (Config::Data::General::ConflictHandling)group.readEntry( "conflictHandling", 0 );
 //     data.general.priority = group.readEntry( "priority", 10 );
     data.general.numFiles = group.readEntry( "numFiles", 0 );
+    data.general.adaptiveNumFiles = group.readEntry( "adaptiveNumFiles", false );
+    data.general.longestFilesFirst = group.readEntry( "longestFilesFirst", false );
     data.general.numReplayGainFiles = group.readEntry( "numReplayGainFiles", 0 );
+    data.general.mirrorSync = group.readEntry( "mirrorSync", false );
+    data.general.mirrorRemoveOrphans = group.readEntry( "mirrorRemoveOrphans", false );
+    data.general.recordMetrics = group.readEntry( "recordMetrics", false );
+    data.general.metricsPort = group.readEntry( "metricsPort", 0 );
     if( data.general.numFiles == 0 || data.general.numReplayGainFiles == 0 )
     {
         QList<Solid::Device> processors = Solid::Device::listFromType(Solid::DeviceInterface::Processor, QString());
@@ -106,12 +116,16 @@ void Config::load()
     }
     data.advanced.maxSizeForSharedMemoryTempFiles = group.readEntry( "maxSizeForSharedMemoryTempFiles", data.advanced.sharedMemorySize / 4 );
     data.advanced.usePipes = group.readEntry( "usePipes", false );
+    data.advanced.conversionCacheSize = group.readEntry( "conversionCacheSize", 0 );
     data.advanced.ejectCdAfterRip = group.readEntry( "ejectCdAfterRip", true );
 
     group = conf->group( "CoverArt" );
     data.coverArt.writeCovers = group.readEntry( "writeCovers", 1 );
     data.coverArt.writeCoverName = group.readEntry( "writeCoverName", 0 );
     data.coverArt.writeCoverDefaultName = group.readEntry( "writeCoverDefaultName", i18nc("cover file name","cover") );
+    data.coverArt.resizeCovers = group.readEntry( "resizeCovers", false );
+    data.coverArt.maxCoverSize = group.readEntry( "maxCoverSize", 600 );
+    data.coverArt.coverQuality = group.readEntry( "coverQuality", 85 );
 
     group = conf->group( "Backends" );
     formats = group.readEntry( "formats", QStringList() );
@@ -483,11 +497,18 @@ void Config::save()
     group.writeEntry( "waitForAlbumGain", data.general.waitForAlbumGain );
     group.writeEntry( "useVFATNames", data.general.useVFATNames );
     group.writeEntry( "copyIfSameCodec", data.general.copyIfSameCodec );
+    group.writeEntry( "remuxIfSameCodec", data.general.remuxIfSameCodec );
     group.writeEntry( "writeLogFiles", data.general.writeLogFiles );
     group.writeEntry( "conflictHandling", (int)data.general.conflictHandling );
 //     group.writeEntry( "priority", data.general.priority );
     group.writeEntry( "numFiles", data.general.numFiles );
+    group.writeEntry( "adaptiveNumFiles", data.general.adaptiveNumFiles );
+    group.writeEntry( "longestFilesFirst", data.general.longestFilesFirst );
     group.writeEntry( "numReplayGainFiles", data.general.numReplayGainFiles );
+    group.writeEntry( "mirrorSync", data.general.mirrorSync );
+    group.writeEntry( "mirrorRemoveOrphans", data.general.mirrorRemoveOrphans );
+    group.writeEntry( "recordMetrics", data.general.recordMetrics );
+    group.writeEntry( "metricsPort", data.general.metricsPort );
 //     group.writeEntry( "executeUserScript", data.general.executeUserScript );
 //     group.writeEntry( "showToolBar", data.general.showToolBar );
 //     group.writeEntry( "outputFilePermissions", data.general.outputFilePermissions );
@@ -503,12 +524,16 @@ void Config::save()
     group.writeEntry( "useSharedMemoryForTempFiles", data.advanced.useSharedMemoryForTempFiles );
     group.writeEntry( "maxSizeForSharedMemoryTempFiles", data.advanced.maxSizeForSharedMemoryTempFiles );
     group.writeEntry( "usePipes", data.advanced.usePipes );
+    group.writeEntry( "conversionCacheSize", data.advanced.conversionCacheSize );
     group.writeEntry( "ejectCdAfterRip", data.advanced.ejectCdAfterRip );
 
     group = conf->group( "CoverArt" );
     group.writeEntry( "writeCovers", data.coverArt.writeCovers );
     group.writeEntry( "writeCoverName", data.coverArt.writeCoverName );
     group.writeEntry( "writeCoverDefaultName", data.coverArt.writeCoverDefaultName );
+    group.writeEntry( "resizeCovers", data.coverArt.resizeCovers );
+    group.writeEntry( "maxCoverSize", data.coverArt.maxCoverSize );
+    group.writeEntry( "coverQuality", data.coverArt.coverQuality );
 
     group = conf->group( "Backends" );
     group.deleteEntry( "rippers" );
@@ -550,6 +575,7 @@ void Config::save()
     }
 
     emit updateWriteLogFilesSetting( data.general.writeLogFiles );
+    emit updateMetricsSettings();
 }
 
 void Config::writeServiceMenu()
@@ -11,6 +11,9 @@
 #include "metadata/tagengine.h"
 #include "conversionoptionsmanager.h"
 #include "codecoptimizations.h"
+#include "conversioncache.h"
+#include "mirrormanifest.h"
+#include "timemodel.h"
 
 #include <QDomDocument>
 
@@ -63,6 +66,7 @@ public:
             bool waitForAlbumGain;
             bool useVFATNames;
             bool copyIfSameCodec;
+            bool remuxIfSameCodec;
             bool writeLogFiles;
             enum ConflictHandling
             {
@@ -71,7 +75,13 @@ public:
                 Overwrite = 2
             } conflictHandling;
             int numFiles;
+            bool adaptiveNumFiles;
+            bool longestFilesFirst;
             int numReplayGainFiles;
+            bool mirrorSync;
+            bool mirrorRemoveOrphans;
+            bool recordMetrics;
+            int metricsPort; // 0 = don't serve the metrics
 //             bool executeUserScript;
 //             bool showToolBar;
 //             int outputFilePermissions;
@@ -95,6 +105,7 @@ public:
             int maxSizeForSharedMemoryTempFiles; // maximum file size for storing in shared memory [MiB]
             int sharedMemorySize; // the size of the tmpfs [MiB]
             bool usePipes;
+            int conversionCacheSize; // the maximum size of the conversion cache, 0 if disabled [MiB]
             bool ejectCdAfterRip;
         } advanced;
 
@@ -103,6 +114,9 @@ public:
             int writeCovers;
             int writeCoverName;
             QString writeCoverDefaultName;
+            bool resizeCovers;
+            int maxCoverSize; // [px]
+            int coverQuality; // JPEG quality of resized covers
         } coverArt;
 
         struct Backends
@@ -142,6 +156,9 @@ public:
     PluginLoader *pluginLoader() { return pPluginLoader; }
     TagEngine *tagEngine() { return pTagEngine; }
     ConversionOptionsManager *conversionOptionsManager() { return pConversionOptionsManager; }
+    MirrorManifest *mirrorManifest() { return pMirrorManifest; }
+    ConversionCache *conversionCache() { return pConversionCache; }
+    TimeModel *timeModel() { return pTimeModel; }
 
 public slots:
     /// Optimize backend settings according to the user input
@@ -150,6 +167,8 @@ public slots:
 signals:
     /// connected to logger
     void updateWriteLogFilesSetting( bool writeLogFiles );
+    /// connected to JobMetrics
+    void updateMetricsSettings();
 
 private:
     Logger *logger;
@@ -157,6 +176,9 @@ private:
     PluginLoader *pPluginLoader;
     TagEngine *pTagEngine;
     ConversionOptionsManager *pConversionOptionsManager;
+    MirrorManifest *pMirrorManifest;
+    ConversionCache *pConversionCache;
+    TimeModel *pTimeModel;
 
     void writeServiceMenu();
 };
@@ -130,6 +130,30 @@ ConfigAdvancedPage::ConfigAdvancedPage( Config *_config, QWidget *parent )
     ejectCdAfterRipBox->addWidget( cEjectCdAfterRip );
     connect( cEjectCdAfterRip, SIGNAL(toggled(bool)), this, SLOT(somethingChanged()) );
 
+    box->addSpacing( spacingSmall );
+
+    QHBoxLayout *mirrorSyncBox = new QHBoxLayout();
+    mirrorSyncBox->addSpacing( spacingOffset );
+    box->addLayout( mirrorSyncBox );
+    cMirrorSync = new QCheckBox( i18n("Only convert new or changed files when adding directories (mirror mode)"), this );
+    cMirrorSync->setToolTip( i18n("soundKonverter remembers which files have been converted with which options.\nFiles that haven't changed since they have been converted with the same options will be skipped when adding a directory.\nOutdated output files will be overwritten.") );
+    cMirrorSync->setChecked( config->data.general.mirrorSync );
+    mirrorSyncBox->addWidget( cMirrorSync );
+    connect( cMirrorSync, SIGNAL(toggled(bool)), this, SLOT(somethingChanged()) );
+
+    box->addSpacing( spacingSmall );
+
+    QHBoxLayout *mirrorRemoveOrphansBox = new QHBoxLayout();
+    mirrorRemoveOrphansBox->addSpacing( spacingOffset * 2 );
+    box->addLayout( mirrorRemoveOrphansBox );
+    cMirrorRemoveOrphans = new QCheckBox( i18n("Remove output files of deleted or renamed source files"), this );
+    cMirrorRemoveOrphans->setToolTip( i18n("If disabled, output files of deleted source files will only be listed in the log.") );
+    cMirrorRemoveOrphans->setChecked( config->data.general.mirrorRemoveOrphans );
+    cMirrorRemoveOrphans->setEnabled( cMirrorSync->isChecked() );
+    mirrorRemoveOrphansBox->addWidget( cMirrorRemoveOrphans );
+    connect( cMirrorSync, SIGNAL(toggled(bool)), cMirrorRemoveOrphans, SLOT(setEnabled(bool)) );
+    connect( cMirrorRemoveOrphans, SIGNAL(toggled(bool)), this, SLOT(somethingChanged()) );
+
     box->addSpacing( spacingBig );
 
     QLabel *lDebug = new QLabel( i18n("Debug"), this ); // TODO rename
@@ -147,6 +171,39 @@ ConfigAdvancedPage::ConfigAdvancedPage( Config *_config, QWidget *parent )
     writeLogFilesBox->addWidget( cWriteLogFiles );
     connect( cWriteLogFiles, SIGNAL(toggled(bool)), this, SLOT(somethingChanged()) );
 
+    box->addSpacing( spacingSmall );
+
+    QHBoxLayout *recordMetricsBox = new QHBoxLayout();
+    recordMetricsBox->addSpacing( spacingOffset );
+    box->addLayout( recordMetricsBox );
+    cRecordMetrics = new QCheckBox( i18n("Record the resource usage of every conversion"), this );
+    cRecordMetrics->setToolTip( i18n("Records the time, the processor time, the memory usage and the amount of data read and written by the backends for every step of every conversion.\nThe results will be written to %1",KStandardDirs::locateLocal("data","soundkonverter/metrics.jsonl")) );
+    cRecordMetrics->setChecked( config->data.general.recordMetrics );
+    recordMetricsBox->addWidget( cRecordMetrics );
+    connect( cRecordMetrics, SIGNAL(toggled(bool)), this, SLOT(somethingChanged()) );
+
+    box->addSpacing( spacingSmall );
+
+    QHBoxLayout *serveMetricsBox = new QHBoxLayout();
+    serveMetricsBox->addSpacing( spacingOffset * 2 );
+    box->addLayout( serveMetricsBox );
+    cServeMetrics = new QCheckBox( i18n("Serve the metrics in the Prometheus format on local port:"), this );
+    cServeMetrics->setToolTip( i18n("The accumulated values can be fetched from http://localhost:<port>/metrics") );
+    cServeMetrics->setChecked( config->data.general.metricsPort > 0 );
+    cServeMetrics->setEnabled( cRecordMetrics->isChecked() );
+    serveMetricsBox->addWidget( cServeMetrics );
+    iMetricsPort = new KIntSpinBox( 1024, 65535, 1, 9746, this );
+    iMetricsPort->setValue( config->data.general.metricsPort > 0 ? config->data.general.metricsPort : 9746 );
+    iMetricsPort->setEnabled( cRecordMetrics->isChecked() && cServeMetrics->isChecked() );
+    serveMetricsBox->addWidget( iMetricsPort );
+    connect( cRecordMetrics, SIGNAL(toggled(bool)), cServeMetrics, SLOT(setEnabled(bool)) );
+    connect( cRecordMetrics, SIGNAL(toggled(bool)), this, SLOT(metricsToggled()) );
+    connect( cServeMetrics, SIGNAL(toggled(bool)), this, SLOT(metricsToggled()) );
+    connect( cServeMetrics, SIGNAL(toggled(bool)), this, SLOT(somethingChanged()) );
+    connect( iMetricsPort, SIGNAL(valueChanged(int)), this, SLOT(somethingChanged()) );
+    serveMetricsBox->setStretch( 0, 3 );
+    serveMetricsBox->setStretch( 1, 1 );
+
     box->addSpacing( spacingBig );
 
     QLabel *lExperimental = new QLabel( i18n("Experimental"), this );
@@ -191,6 +248,26 @@ ConfigAdvancedPage::ConfigAdvancedPage( Config *_config, QWidget *parent )
     usePipesBox->addWidget( cUsePipes );
     connect( cUsePipes, SIGNAL(toggled(bool)), this, SLOT(somethingChanged()) );
 
+    box->addSpacing( spacingSmall );
+
+    QHBoxLayout *conversionCacheBox = new QHBoxLayout();
+    conversionCacheBox->addSpacing( spacingOffset );
+    box->addLayout( conversionCacheBox );
+    cUseConversionCache = new QCheckBox( i18n("Keep the converted files in a cache of at most:"), this );
+    cUseConversionCache->setToolTip( i18n("Converting the same file with the same options again only copies the cached file.\nThe cache is identified by the content of the file, so it works for other output directories, too.") );
+    cUseConversionCache->setChecked( config->data.advanced.conversionCacheSize > 0 );
+    conversionCacheBox->addWidget( cUseConversionCache );
+    iConversionCacheSize = new KIntSpinBox( 1, 1048576, 256, 4096, this );
+    iConversionCacheSize->setSuffix( " " + i18nc("mega in bytes","MiB") );
+    iConversionCacheSize->setValue( config->data.advanced.conversionCacheSize > 0 ? config->data.advanced.conversionCacheSize : 4096 );
+    iConversionCacheSize->setEnabled( cUseConversionCache->isChecked() );
+    conversionCacheBox->addWidget( iConversionCacheSize );
+    connect( cUseConversionCache, SIGNAL(toggled(bool)), this, SLOT(somethingChanged()) );
+    connect( cUseConversionCache, SIGNAL(toggled(bool)), iConversionCacheSize, SLOT(setEnabled(bool)) );
+    connect( iConversionCacheSize, SIGNAL(valueChanged(int)), this, SLOT(somethingChanged()) );
+    conversionCacheBox->setStretch( 0, 3 );
+    conversionCacheBox->setStretch( 1, 1 );
+
     box->addStretch();
 }
 
@@ -205,10 +282,17 @@ void ConfigAdvancedPage::resetDefaults()
     cPreferredVorbisCommentDiscTotalTag->setCurrentIndex( 0 );
     cUseVFATNames->setChecked( false );
     cEjectCdAfterRip->setChecked( true );
+    cMirrorSync->setChecked( false );
+    cMirrorRemoveOrphans->setChecked( false );
     cWriteLogFiles->setChecked( false );
+    cRecordMetrics->setChecked( false );
+    cServeMetrics->setChecked( false );
+    iMetricsPort->setValue( 9746 );
     cUseSharedMemoryForTempFiles->setChecked( false );
     iMaxSizeForSharedMemoryTempFiles->setValue( config->data.advanced.sharedMemorySize / 4 );
     cUsePipes->setChecked( false );
+    cUseConversionCache->setChecked( false );
+    iConversionCacheSize->setValue( 4096 );
 
     emit configChanged( true );
 }
@@ -221,10 +305,15 @@ void ConfigAdvancedPage::saveSettings()
     config->data.general.preferredVorbisCommentDiscTotalTag = cPreferredVorbisCommentDiscTotalTag->currentText();
     config->data.general.useVFATNames = cUseVFATNames->isChecked();
     config->data.advanced.ejectCdAfterRip = cEjectCdAfterRip->isChecked();
+    config->data.general.mirrorSync = cMirrorSync->isChecked();
+    config->data.general.mirrorRemoveOrphans = cMirrorRemoveOrphans->isChecked();
     config->data.general.writeLogFiles = cWriteLogFiles->isChecked();
+    config->data.general.recordMetrics = cRecordMetrics->isChecked();
+    config->data.general.metricsPort = cServeMetrics->isChecked() ? iMetricsPort->value() : 0;
     config->data.advanced.useSharedMemoryForTempFiles = cUseSharedMemoryForTempFiles->isEnabled() && cUseSharedMemoryForTempFiles->isChecked();
     config->data.advanced.maxSizeForSharedMemoryTempFiles = iMaxSizeForSharedMemoryTempFiles->value();
     config->data.advanced.usePipes = cUsePipes->isChecked();
+    config->data.advanced.conversionCacheSize = cUseConversionCache->isChecked() ? iConversionCacheSize->value() : 0;
 }
 
 void ConfigAdvancedPage::somethingChanged()
@@ -235,11 +324,20 @@ void ConfigAdvancedPage::somethingChanged()
                          cPreferredVorbisCommentDiscTotalTag->currentText() != config->data.general.preferredVorbisCommentDiscTotalTag ||
                          cUseVFATNames->isChecked() != config->data.general.useVFATNames ||
                          cEjectCdAfterRip->isChecked() != config->data.advanced.ejectCdAfterRip ||
+                         cMirrorSync->isChecked() != config->data.general.mirrorSync ||
+                         cMirrorRemoveOrphans->isChecked() != config->data.general.mirrorRemoveOrphans ||
                          cWriteLogFiles->isChecked() != config->data.general.writeLogFiles ||
+                         cRecordMetrics->isChecked() != config->data.general.recordMetrics ||
+                         ( cServeMetrics->isChecked() ? iMetricsPort->value() : 0 ) != config->data.general.metricsPort ||
                          cUseSharedMemoryForTempFiles->isChecked() != config->data.advanced.useSharedMemoryForTempFiles ||
                          iMaxSizeForSharedMemoryTempFiles->value() != config->data.advanced.maxSizeForSharedMemoryTempFiles ||
-                         cUsePipes->isChecked() != config->data.advanced.usePipes;
+                         cUsePipes->isChecked() != config->data.advanced.usePipes ||
+                         ( cUseConversionCache->isChecked() ? iConversionCacheSize->value() : 0 ) != config->data.advanced.conversionCacheSize;
 
     emit configChanged( changed );
 }
 
+void ConfigAdvancedPage::metricsToggled()
+{
+    iMetricsPort->setEnabled( cRecordMetrics->isChecked() && cServeMetrics->isChecked() );
+}
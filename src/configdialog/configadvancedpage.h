@@ -43,10 +43,17 @@ private:
     KComboBox *cPreferredVorbisCommentDiscTotalTag;
     QCheckBox *cUseVFATNames;
     QCheckBox *cEjectCdAfterRip;
+    QCheckBox *cMirrorSync;
+    QCheckBox *cMirrorRemoveOrphans;
     QCheckBox *cWriteLogFiles;
+    QCheckBox *cRecordMetrics;
+    QCheckBox *cServeMetrics;
+    KIntSpinBox *iMetricsPort;
     QCheckBox *cUseSharedMemoryForTempFiles;
     KIntSpinBox *iMaxSizeForSharedMemoryTempFiles;
     QCheckBox *cUsePipes;
+    QCheckBox *cUseConversionCache;
+    KIntSpinBox *iConversionCacheSize;
 
     Config *config;
 
@@ -56,6 +63,7 @@ public slots:
 
 private slots:
     void somethingChanged();
+    void metricsToggled();
 
 };
 
@@ -5,11 +5,13 @@
 
 #include <KLocale>
 #include <KLineEdit>
+#include <KIntSpinBox>
 
 #include <QLayout>
 #include <QLabel>
 #include <QRadioButton>
 #include <QButtonGroup>
+#include <QCheckBox>
 
 
 ConfigCoverArtPage::ConfigCoverArtPage( Config *_config, QWidget *parent )
@@ -88,6 +90,46 @@ ConfigCoverArtPage::ConfigCoverArtPage( Config *_config, QWidget *parent )
         rWriteCoverNameDefault->setChecked( true );
     lWriteCoverNameDefaultEdit->setText( config->data.coverArt.writeCoverDefaultName );
 
+    box->addSpacing( spacingBig );
+
+    QLabel *lCoverResizing = new QLabel( i18n("Resizing covers"), this );
+    lCoverResizing->setFont( groupFont );
+    box->addWidget( lCoverResizing );
+
+    box->addSpacing( spacingSmall );
+
+    QHBoxLayout *resizeCoversBox = new QHBoxLayout();
+    resizeCoversBox->addSpacing( spacingOffset );
+    box->addLayout( resizeCoversBox );
+    cResizeCovers = new QCheckBox( i18n("Downscale covers that are bigger than:"), this );
+    cResizeCovers->setToolTip( i18n("Big covers make every output file bigger and some portable players can't display them.\nCovers will be saved as JPEG images without additional meta data.") );
+    cResizeCovers->setChecked( config->data.coverArt.resizeCovers );
+    resizeCoversBox->addWidget( cResizeCovers );
+    iMaxCoverSize = new KIntSpinBox( 100, 4000, 100, config->data.coverArt.maxCoverSize, this );
+    iMaxCoverSize->setSuffix( " " + i18nc("pixels","px") );
+    iMaxCoverSize->setEnabled( cResizeCovers->isChecked() );
+    resizeCoversBox->addWidget( iMaxCoverSize );
+    resizeCoversBox->addStretch();
+    connect( cResizeCovers, SIGNAL(toggled(bool)), iMaxCoverSize, SLOT(setEnabled(bool)) );
+    connect( cResizeCovers, SIGNAL(toggled(bool)), this, SLOT(somethingChanged()) );
+    connect( iMaxCoverSize, SIGNAL(valueChanged(int)), this, SLOT(somethingChanged()) );
+
+    box->addSpacing( spacingSmall );
+
+    QHBoxLayout *coverQualityBox = new QHBoxLayout();
+    coverQualityBox->addSpacing( spacingOffset );
+    box->addLayout( coverQualityBox );
+    lCoverQuality = new QLabel( i18n("JPEG quality:"), this );
+    lCoverQuality->setEnabled( cResizeCovers->isChecked() );
+    coverQualityBox->addWidget( lCoverQuality );
+    iCoverQuality = new KIntSpinBox( 10, 100, 5, config->data.coverArt.coverQuality, this );
+    iCoverQuality->setEnabled( cResizeCovers->isChecked() );
+    coverQualityBox->addWidget( iCoverQuality );
+    coverQualityBox->addStretch();
+    connect( cResizeCovers, SIGNAL(toggled(bool)), lCoverQuality, SLOT(setEnabled(bool)) );
+    connect( cResizeCovers, SIGNAL(toggled(bool)), iCoverQuality, SLOT(setEnabled(bool)) );
+    connect( iCoverQuality, SIGNAL(valueChanged(int)), this, SLOT(somethingChanged()) );
+
 //     QGroupBox *coverGroup = new QGroupBox( i18n("CD covers"), this );
 //     writeCoversBox->addWidget( coverGroup );
 //     QVBoxLayout *coverBox = new QVBoxLayout();
@@ -133,6 +175,9 @@ void ConfigCoverArtPage::resetDefaults()
     rWriteCoversAuto->setChecked( true );
     rWriteCoverNameTitle->setChecked( true );
     lWriteCoverNameDefaultEdit->setText( i18nc("cover file name","cover") );
+    cResizeCovers->setChecked( false );
+    iMaxCoverSize->setValue( 600 );
+    iCoverQuality->setValue( 85 );
 
     emit configChanged( true );
 }
@@ -152,6 +197,9 @@ void ConfigCoverArtPage::saveSettings()
         config->data.coverArt.writeCoverName = 1;
 
     config->data.coverArt.writeCoverDefaultName = lWriteCoverNameDefaultEdit->text();
+    config->data.coverArt.resizeCovers = cResizeCovers->isChecked();
+    config->data.coverArt.maxCoverSize = iMaxCoverSize->value();
+    config->data.coverArt.coverQuality = iCoverQuality->value();
 }
 
 void ConfigCoverArtPage::somethingChanged()
@@ -161,7 +209,10 @@ void ConfigCoverArtPage::somethingChanged()
                          ( rWriteCoversNever->isChecked() && config->data.coverArt.writeCovers != 2 ) ||
                          ( rWriteCoverNameTitle->isChecked() && config->data.coverArt.writeCoverName != 0 ) ||
                          ( rWriteCoverNameDefault->isChecked() && config->data.coverArt.writeCoverName != 1 ) ||
-                         lWriteCoverNameDefaultEdit->text() != config->data.coverArt.writeCoverDefaultName;
+                         lWriteCoverNameDefaultEdit->text() != config->data.coverArt.writeCoverDefaultName ||
+                         cResizeCovers->isChecked() != config->data.coverArt.resizeCovers ||
+                         iMaxCoverSize->value() != config->data.coverArt.maxCoverSize ||
+                         iCoverQuality->value() != config->data.coverArt.coverQuality;
 
     emit configChanged( changed );
 }
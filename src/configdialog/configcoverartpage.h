@@ -19,6 +19,8 @@ class QRadioButton;
 class QLabel;
 class QAbstractButton;
 class KLineEdit;
+class QCheckBox;
+class KIntSpinBox;
 
 /**
 	@author Daniel Faust <hessijames@gmail.com>
@@ -48,6 +50,11 @@ private:
     QLabel       *lWriteCoverNameDefaultLabel;
     KLineEdit    *lWriteCoverNameDefaultEdit;
 
+    QCheckBox    *cResizeCovers;
+    KIntSpinBox  *iMaxCoverSize;
+    QLabel       *lCoverQuality;
+    KIntSpinBox  *iCoverQuality;
+
 //     QCheckBox *cCopyCover;
 //     QCheckBox *cEmbedCover;
 //     QListView *lCoverList;
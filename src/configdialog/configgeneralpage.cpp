@@ -144,6 +144,28 @@ ConfigGeneralPage::ConfigGeneralPage( Config *_config, QWidget *parent )
 
     box->addSpacing( spacingSmall );
 
+    QHBoxLayout *adaptiveNumFilesBox = new QHBoxLayout();
+    adaptiveNumFilesBox->addSpacing( spacingOffset );
+    box->addLayout( adaptiveNumFilesBox );
+    cAdaptiveNumFiles = new QCheckBox( i18n("Adjust the number of files to the system load"), this );
+    cAdaptiveNumFiles->setToolTip( i18n("Start with the number above and convert more files at once while processor cores are idle,\nor less files if the processors are mostly waiting for the hard disk or network.") );
+    cAdaptiveNumFiles->setChecked( config->data.general.adaptiveNumFiles );
+    adaptiveNumFilesBox->addWidget( cAdaptiveNumFiles );
+    connect( cAdaptiveNumFiles, SIGNAL(toggled(bool)), this, SLOT(somethingChanged()) );
+
+    box->addSpacing( spacingSmall );
+
+    QHBoxLayout *longestFilesFirstBox = new QHBoxLayout();
+    longestFilesFirstBox->addSpacing( spacingOffset );
+    box->addLayout( longestFilesFirstBox );
+    cLongestFilesFirst = new QCheckBox( i18n("Convert the longest files first"), this );
+    cLongestFilesFirst->setToolTip( i18n("Start the files that are expected to take the longest time first, so a long file doesn't keep the conversion running at the end.\nThe files of an album that get album gain are still converted together.") );
+    cLongestFilesFirst->setChecked( config->data.general.longestFilesFirst );
+    longestFilesFirstBox->addWidget( cLongestFilesFirst );
+    connect( cLongestFilesFirst, SIGNAL(toggled(bool)), this, SLOT(somethingChanged()) );
+
+    box->addSpacing( spacingSmall );
+
     QHBoxLayout *waitForAlbumGainBox = new QHBoxLayout();
     waitForAlbumGainBox->addSpacing( spacingOffset );
     box->addLayout( waitForAlbumGainBox );
@@ -164,6 +186,17 @@ ConfigGeneralPage::ConfigGeneralPage( Config *_config, QWidget *parent )
     copyIfSameCodecBox->addWidget( cCopyIfSameCodec );
     connect( cCopyIfSameCodec, SIGNAL(toggled(bool)), this, SLOT(somethingChanged()) );
 
+    QHBoxLayout *remuxIfSameCodecBox = new QHBoxLayout();
+    remuxIfSameCodecBox->addSpacing( 2 * spacingOffset );
+    box->addLayout( remuxIfSameCodecBox );
+    cRemuxIfSameCodec = new QCheckBox( i18n("Repair the file structure while copying"), this );
+    cRemuxIfSameCodec->setToolTip( i18n("Let FFmpeg copy the audio stream into a new file. This drops junk data and rewrites broken headers, but the file isn't an exact copy anymore.\nThe tags and cover images are kept.") );
+    cRemuxIfSameCodec->setChecked( config->data.general.remuxIfSameCodec );
+    cRemuxIfSameCodec->setEnabled( config->data.general.copyIfSameCodec );
+    remuxIfSameCodecBox->addWidget( cRemuxIfSameCodec );
+    connect( cCopyIfSameCodec, SIGNAL(toggled(bool)), cRemuxIfSameCodec, SLOT(setEnabled(bool)) );
+    connect( cRemuxIfSameCodec, SIGNAL(toggled(bool)), this, SLOT(somethingChanged()) );
+
     box->addSpacing( spacingBig );
 
     QLabel *lReplayGainTool = new QLabel( i18n("Replay Gain tool"), this );
@@ -217,8 +250,11 @@ void ConfigGeneralPage::resetDefaults()
 //     cPriority->setCurrentIndex( 1 );
     cConflictHandling->setCurrentIndex( 0 );
     iNumFiles->setValue( processorsCount > 0 ? processorsCount : 1 );
+    cAdaptiveNumFiles->setChecked( false );
+    cLongestFilesFirst->setChecked( false );
     cWaitForAlbumGain->setChecked( true );
     cCopyIfSameCodec->setChecked( false );
+    cRemuxIfSameCodec->setChecked( false );
     cReplayGainGrouping->setCurrentIndex( 0 );
     iNumReplayGainFiles->setValue( processorsCount > 0 ? processorsCount : 1 );
 
@@ -233,8 +269,11 @@ void ConfigGeneralPage::saveSettings()
 //     config->data.general.priority = cPriority->currentIndex() * 10; // NOTE that just works for 'normal' and 'low'
     config->data.general.conflictHandling = (Config::Data::General::ConflictHandling)cConflictHandling->currentIndex();
     config->data.general.numFiles = iNumFiles->value();
+    config->data.general.adaptiveNumFiles = cAdaptiveNumFiles->isChecked();
+    config->data.general.longestFilesFirst = cLongestFilesFirst->isChecked();
     config->data.general.waitForAlbumGain = cWaitForAlbumGain->isChecked();
     config->data.general.copyIfSameCodec = cCopyIfSameCodec->isChecked();
+    config->data.general.remuxIfSameCodec = cRemuxIfSameCodec->isChecked();
     config->data.general.replayGainGrouping = (Config::Data::General::ReplayGainGrouping)cReplayGainGrouping->currentIndex();
     config->data.general.numReplayGainFiles = iNumReplayGainFiles->value();
 }
@@ -246,8 +285,11 @@ void ConfigGeneralPage::somethingChanged()
                          cDefaultFormat->currentText() != config->data.general.defaultFormat ||
                          cConflictHandling->currentIndex() != (int)config->data.general.conflictHandling ||
                          iNumFiles->value() != config->data.general.numFiles ||
+                         cAdaptiveNumFiles->isChecked() != config->data.general.adaptiveNumFiles ||
+                         cLongestFilesFirst->isChecked() != config->data.general.longestFilesFirst ||
                          cWaitForAlbumGain->isChecked() != config->data.general.waitForAlbumGain ||
                          cCopyIfSameCodec->isChecked() != config->data.general.copyIfSameCodec ||
+                         cRemuxIfSameCodec->isChecked() != config->data.general.remuxIfSameCodec ||
                          cReplayGainGrouping->currentIndex() != (int)config->data.general.replayGainGrouping ||
                          iNumReplayGainFiles->value() != config->data.general.numReplayGainFiles;
 
@@ -42,8 +42,11 @@ private:
 //     QStringList sPriority;
     KComboBox *cConflictHandling;
     KIntSpinBox *iNumFiles;
+    QCheckBox *cAdaptiveNumFiles;
+    QCheckBox *cLongestFilesFirst;
     QCheckBox *cWaitForAlbumGain;
     QCheckBox *cCopyIfSameCodec;
+    QCheckBox *cRemuxIfSameCodec;
     KComboBox *cReplayGainGrouping;
     KIntSpinBox *iNumReplayGainFiles;
 
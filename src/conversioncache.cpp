@@ -0,0 +1,235 @@
+
+#include "conversioncache.h"
+#include "core/conversionoptions.h"
+#include "global.h"
+#include "pluginloader.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDomDocument>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+
+#include <KStandardDirs>
+
+
+#define CONVERSION_CACHE_VERSION 1
+
+
+QDataStream& operator<<( QDataStream& stream, const ConversionCache::Entry& entry )
+{
+    return stream << entry.fileName << entry.size << entry.lastUsed;
+}
+
+QDataStream& operator>>( QDataStream& stream, ConversionCache::Entry& entry )
+{
+    return stream >> entry.fileName >> entry.size >> entry.lastUsed;
+}
+
+
+ConversionCache::ConversionCache( QObject *parent )
+    : QObject( parent )
+{
+    directory = KStandardDirs::locateLocal( "cache", "soundkonverter/conversions/" );
+    fileName = directory + "index.dat";
+    loaded = false;
+    changed = false;
+}
+
+ConversionCache::~ConversionCache()
+{
+    save();
+}
+
+void ConversionCache::load()
+{
+    if( loaded )
+        return;
+
+    loaded = true;
+
+    QFile file( fileName );
+    if( !file.open(QIODevice::ReadOnly) )
+        return;
+
+    QDataStream stream( &file );
+    stream.setVersion( QDataStream::Qt_4_6 );
+
+    qint32 version;
+    stream >> version;
+    if( version != CONVERSION_CACHE_VERSION )
+        return;
+
+    stream >> entries;
+
+    if( stream.status() != QDataStream::Ok )
+        entries.clear();
+}
+
+void ConversionCache::save()
+{
+    if( !changed )
+        return;
+
+    QFile file( fileName );
+    if( !file.open(QIODevice::WriteOnly) )
+        return;
+
+    QDataStream stream( &file );
+    stream.setVersion( QDataStream::Qt_4_6 );
+
+    stream << (qint32)CONVERSION_CACHE_VERSION;
+    stream << entries;
+
+    file.close();
+
+    changed = false;
+}
+
+QByteArray ConversionCache::key( const QByteArray& contentHash, const ConversionOptions *conversionOptions, const ConversionPipe& pipe )
+{
+    if( contentHash.isEmpty() )
+        return QByteArray();
+
+    // a new version of soundKonverter or of a backend binary may produce a different output
+    QStringList backends;
+    backends.append( SOUNDKONVERTER_VERSION_STRING );
+    foreach( const ConversionPipeTrunk& trunk, pipe.trunks )
+    {
+        backends.append( trunk.plugin->name() + ":" + trunk.codecFrom + ">" + trunk.codecTo );
+        foreach( const QString& binary, trunk.plugin->binaries.values() )
+        {
+            if( binary.isEmpty() )
+                continue;
+
+            const QFileInfo binaryInfo( binary );
+            backends.append( binary + ":" + QString::number(binaryInfo.size()) + ":" + QString::number(binaryInfo.lastModified().toTime_t()) );
+        }
+    }
+
+    QCryptographicHash hash( QCryptographicHash::Md5 );
+    hash.addData( contentHash );
+    hash.addData( fingerprint(conversionOptions) );
+    hash.addData( backends.join("\n").toUtf8() );
+
+    return hash.result().toHex();
+}
+
+QByteArray ConversionCache::fingerprint( const ConversionOptions *conversionOptions )
+{
+    if( !conversionOptions )
+        return QByteArray();
+
+    // the same file converted into another directory or with a renamed profile has the same content
+    QDomDocument document( "soundkonverter_conversionoptions" );
+    QDomElement element = conversionOptions->toXml( document );
+    element.removeAttribute( "profile" );
+    element.removeChild( element.firstChildElement("outputOptions") );
+    document.appendChild( element );
+
+    return QCryptographicHash::hash( document.toString().toUtf8(), QCryptographicHash::Md5 ).toHex();
+}
+
+QString ConversionCache::find( const QByteArray& key )
+{
+    load();
+
+    if( key.isEmpty() || !entries.contains(key) )
+        return QString();
+
+    Entry& entry = entries[key];
+    const QString path = directory + entry.fileName;
+    if( QFileInfo(path).size() != entry.size )
+    {
+        QFile::remove( path );
+        entries.remove( key );
+        changed = true;
+        return QString();
+    }
+
+    entry.lastUsed = QDateTime::currentDateTime();
+    changed = true;
+
+    return path;
+}
+
+QString ConversionCache::cacheFileName( const QByteArray& key, const QString& outputFile, int maximumSize )
+{
+    load();
+
+    if( key.isEmpty() )
+        return QString();
+
+    const qint64 size = QFileInfo( outputFile ).size();
+    if( size <= 0 || size > (qint64)maximumSize * 1024 * 1024 || pendingKeys.contains(key) )
+        return QString();
+
+    remove( key );
+    pendingKeys.insert( key );
+
+    return directory + QString(key) + "." + QFileInfo(outputFile).suffix();
+}
+
+void ConversionCache::insert( const QByteArray& key, const QString& cachedFile, int maximumSize )
+{
+    load();
+
+    if( key.isEmpty() )
+        return;
+
+    pendingKeys.remove( key );
+
+    const qint64 maximumBytes = (qint64)maximumSize * 1024 * 1024;
+    const qint64 size = QFileInfo( cachedFile ).size();
+    if( size <= 0 || size > maximumBytes )
+    {
+        QFile::remove( cachedFile );
+        return;
+    }
+
+    Entry entry;
+    entry.fileName = QFileInfo(cachedFile).fileName();
+    entry.size = size;
+    entry.lastUsed = QDateTime::currentDateTime();
+
+    entries.insert( key, entry );
+    changed = true;
+
+    qint64 totalSize = 0;
+    foreach( const Entry& cached, entries )
+        totalSize += cached.size;
+
+    while( totalSize > maximumBytes )
+    {
+        QHash<QByteArray,Entry>::iterator oldest = entries.begin();
+        for( QHash<QByteArray,Entry>::iterator it = entries.begin(); it != entries.end(); ++it )
+        {
+            if( it.value().lastUsed < oldest.value().lastUsed )
+                oldest = it;
+        }
+        totalSize -= oldest.value().size;
+        QFile::remove( directory + oldest.value().fileName );
+        entries.erase( oldest );
+    }
+
+    save();
+}
+
+void ConversionCache::cancelInsert( const QByteArray& key, const QString& cachedFile )
+{
+    pendingKeys.remove( key );
+    QFile::remove( cachedFile );
+}
+
+void ConversionCache::remove( const QByteArray& key )
+{
+    load();
+
+    if( !entries.contains(key) )
+        return;
+
+    QFile::remove( directory + entries.value(key).fileName );
+    entries.remove( key );
+    changed = true;
+}
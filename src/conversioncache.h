@@ -0,0 +1,73 @@
+
+#ifndef CONVERSIONCACHE_H
+#define CONVERSIONCACHE_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QHash>
+#include <QSet>
+
+class ConversionOptions;
+struct ConversionPipe;
+
+
+/**
+ * @short Keeps the results of conversions, so converting the same file with the same options again is a copy
+ *
+ * The results are identified by the content of the source file, the fingerprint of the
+ * conversion options and the used backends. They are stored without the tags in the
+ * cache folder, the least recently used files get dropped if it grows too big.
+ */
+class ConversionCache : public QObject
+{
+    Q_OBJECT
+public:
+    struct Entry
+    {
+        QString fileName;
+        qint64 size;
+        QDateTime lastUsed;
+    };
+
+    explicit ConversionCache( QObject *parent );
+    ~ConversionCache();
+
+    /** Writes the index to disc if it has been changed */
+    void save();
+
+    /** Returns the key for converting a file with the content hash @p contentHash (see MirrorManifest::contentHash()) with @p conversionOptions by @p pipe */
+    static QByteArray key( const QByteArray& contentHash, const ConversionOptions *conversionOptions, const ConversionPipe& pipe );
+
+    /** Returns the path of the cached result for @p key or an empty string if there is none */
+    QString find( const QByteArray& key );
+    /**
+     * Drops the old result for @p key and returns the path @p outputFile has to be copied to for storing it,
+     * an empty string if it doesn't fit into @p maximumSize [MiB] or if the same result is being stored already
+     */
+    QString cacheFileName( const QByteArray& key, const QString& outputFile, int maximumSize );
+    /** Adds the copy @p cachedFile for @p key and drops old results until the cache is smaller than @p maximumSize [MiB] */
+    void insert( const QByteArray& key, const QString& cachedFile, int maximumSize );
+    /** Copying the result for @p key to @p cachedFile has failed */
+    void cancelInsert( const QByteArray& key, const QString& cachedFile );
+    /** Drops the result for @p key, e.g. if it can't be copied */
+    void remove( const QByteArray& key );
+
+private:
+    /** Returns the hash of the parts of @p conversionOptions that change the converted data, the output directory and the profile name are left out */
+    static QByteArray fingerprint( const ConversionOptions *conversionOptions );
+
+    /** Loads the index on first use, so it doesn't slow down the start if the cache isn't used */
+    void load();
+
+    /** QHash< key, entry > */
+    QHash<QByteArray,Entry> entries;
+    /** the keys of the results that are being copied into the cache */
+    QSet<QByteArray> pendingKeys;
+
+    QString directory;
+    QString fileName;
+    bool loaded;
+    bool changed;
+};
+
+#endif // CONVERSIONCACHE_H
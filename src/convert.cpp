@@ -1,13 +1,18 @@
 
 #include "convert.h"
+#include "accuraterip.h"
 #include "convertitem.h"
 #include "config.h"
 #include "core/codecplugin.h"
 #include "core/conversionoptions.h"
 #include "filelist.h"
 #include "global.h"
+#include "jobmetrics.h"
+#include "localcopyjob.h"
 #include "logger.h"
 #include "outputdirectory.h"
+#include "prefetcher.h"
+#include "ripverifier.h"
 
 #include <kio/jobclasses.h>
 #include <kio/job.h>
@@ -16,6 +21,9 @@
 #include <KMessageBox>
 #include <QFile>
 #include <QFileInfo>
+#include <QRegExp>
+#include <QtConcurrentRun>
+#include <QThread>
 
 
 Convert::Convert( Config *_config, FileList *_fileList, Logger *_logger, QObject *parent )
@@ -26,6 +34,11 @@ Convert::Convert( Config *_config, FileList *_fileList, Logger *_logger, QObject
 {
     connect( &updateTimer, SIGNAL(timeout()), this, SLOT(updateProgress()) );
 
+    metrics = new JobMetrics( config, this );
+
+    prefetcher = new Prefetcher( config, this );
+    connect( prefetcher, SIGNAL(finished(const KUrl&,bool)), this, SLOT(prefetchFinished(const KUrl&,bool)) );
+
     QList<CodecPlugin*> codecPlugins = config->pluginLoader()->getAllCodecPlugins();
     for( int i=0; i<codecPlugins.size(); i++ )
     {
@@ -63,11 +76,32 @@ void Convert::cleanUp()
 void Convert::get( ConvertItem *item )
 {
     if( item->take > 0 )
+    {
         remove( item, FileListItem::Failed );
+        return;
+    }
 
     logger->log( item->logID, i18n("Getting file") );
     item->state = ConvertItem::get;
 
+    if( item->take == 0 && prefetcher->contains(item->inputUrl) )
+    {
+        beginStage( item );
+
+        if( prefetcher->isFinished(item->inputUrl) )
+        {
+            item->tempInputUrl = prefetcher->take( item->inputUrl );
+            logger->log( item->logID, i18n("Using prefetched file \"%1\"",item->tempInputUrl.toLocalFile()) );
+            getFinished( item );
+        }
+        else
+        {
+            // prefetchFinished() continues
+            logger->log( item->logID, i18n("Waiting for the prefetched file") );
+        }
+        return;
+    }
+
     item->tempInputUrl = item->generateTempUrl( "download", item->inputUrl.fileName().mid(item->inputUrl.fileName().lastIndexOf(".")+1) );
 
     if( !updateTimer.isActive() )
@@ -78,6 +112,45 @@ void Convert::get( ConvertItem *item )
     item->kioCopyJob = KIO::file_copy( item->inputUrl, item->tempInputUrl, -1 , KIO::HideProgressInfo );
     connect( item->kioCopyJob.data(), SIGNAL(result(KJob*)), this, SLOT(kioJobFinished(KJob*)) );
     connect( item->kioCopyJob.data(), SIGNAL(percent(KJob*,unsigned long)), this, SLOT(kioJobProgress(KJob*,unsigned long)) );
+
+    beginStage( item );
+}
+
+void Convert::getFinished( ConvertItem *item )
+{
+    if( !item->fileListItem->tags )
+    {
+        item->fileListItem->tags = config->tagEngine()->readTags( item->tempInputUrl );
+        if( item->fileListItem->tags )
+        {
+            logger->log( item->logID, i18n("Read tags successfully") );
+        }
+        else
+        {
+            logger->log( item->logID, i18n("Unable to read tags") );
+        }
+    }
+    item->finishedTime += item->getTime;
+    executeNextStep( item );
+}
+
+QString Convert::remuxBinary( const QString& codecName )
+{
+    // only the formats that often carry junk data or broken headers get remuxed, the others are always copied byte for byte
+    // ffmpeg would rewrite the headers of flac and ogg files and drop seek tables and padding
+    static const QStringList codecs = QStringList() << "mp3" << "mp2" << "m4a/aac" << "ac3" << "wma";
+
+    if( !codecs.contains(codecName) )
+        return QString();
+
+    // use the binary the user has configured for the plugin
+    foreach( CodecPlugin *plugin, config->pluginLoader()->getAllCodecPlugins() )
+    {
+        if( plugin->name() == "FFmpeg" )
+            return plugin->binaries.value( "ffmpeg" );
+    }
+
+    return QString();
 }
 
 void Convert::convert( ConvertItem *item )
@@ -109,6 +182,12 @@ void Convert::convert( ConvertItem *item )
     {
         // item->outputUrl = !item->fileListItem->outputUrl.url().isEmpty() ? item->fileListItem->outputUrl : OutputDirectory::calcPath( item->fileListItem, config, usedOutputNames.values() );
         item->outputUrl = OutputDirectory::calcPath( item->fileListItem, config, usedOutputNames.values() );
+        if( QFile::exists(item->outputUrl.toLocalFile()) && OutputDirectory::isMirrorOutput(item->outputUrl,item->fileListItem,config,usedOutputNames.values()) )
+        {
+            // the source file has been checked against the mirror manifest when it was added, so the existing output is outdated
+            logger->log( item->logID, "\t" + i18n("Replacing outdated output file") );
+            QFile::remove( item->outputUrl.toLocalFile() );
+        }
         if( QFile::exists(item->outputUrl.toLocalFile()) )
         {
             logger->log( item->logID, "\tOutput file already exists" );
@@ -126,16 +205,76 @@ void Convert::convert( ConvertItem *item )
         fileList->updateItem( item->fileListItem );
     }
     usedOutputNames.insert( item->logID, item->outputUrl.toLocalFile() );
+    emit outputFileCreated( item->outputUrl.toLocalFile() );
 
     if( config->data.general.copyIfSameCodec && item->fileListItem->codecName == conversionOptions->codecName )
     {
         item->state = ConvertItem::convert;
+
+        // a plain copy is the rule, it's byte exact and LocalCopyJob can clone the file on btrfs and XFS
+        // remuxing drops junk data and rewrites broken headers if the user wants that, the tags are written afterwards
+        // if remuxing fails, executeSameStep() increases take and the file gets copied
+        const QString ffmpeg = config->data.general.remuxIfSameCodec ? remuxBinary( conversionOptions->codecName ) : QString();
+        item->remuxing = item->take == 0 && !ffmpeg.isEmpty() && inputUrl.isLocalFile();
+
+        if( !item->remuxing && inputUrl.isLocalFile() && item->outputUrl.isLocalFile() )
+        {
+            logger->log( item->logID, i18n("Copying \"%1\" to \"%2\"",inputUrl.toLocalFile(),item->outputUrl.toLocalFile()) );
+
+            item->localCopyJob = new LocalCopyJob( inputUrl.toLocalFile(), item->outputUrl.toLocalFile(), this );
+            connect( item->localCopyJob.data(), SIGNAL(finished(LocalCopyJob*)), this, SLOT(localCopyFinished(LocalCopyJob*)) );
+            item->localCopyJob.data()->start();
+
+            beginStage( item );
+
+            return;
+        }
+
+        if( item->remuxing )
+        {
+            logger->log( item->logID, i18n("Remuxing \"%1\" to \"%2\"",inputUrl.pathOrUrl(),item->outputUrl.toLocalFile()) );
+
+            item->conversionPipesStep = 0;
+            float time = 0.0f;
+            foreach( const float t, item->convertTimes )
+            {
+                time += t;
+            }
+            item->convertTimes.clear();
+            item->convertTimes.append( time );
+
+            QStringList arguments;
+            arguments << "-nostdin" << "-y" << "-i" << inputUrl.toLocalFile() << "-map" << "0:a:0";
+            // keep the attached cover images, the raw mp2 and ac3 muxers can't store them
+            if( conversionOptions->codecName == "mp3" || conversionOptions->codecName == "m4a/aac" || conversionOptions->codecName == "wma" )
+                arguments << "-map" << "0:v?";
+            // keep all tags, TagData doesn't know every field
+            arguments << "-c" << "copy" << "-map_metadata" << "0" << item->outputUrl.toLocalFile();
+            logger->log( item->logID, "<pre>\t<span style=\"color:#DC6300\">" + ffmpeg + " " + arguments.join(" ") + "</span></pre>" );
+
+            item->process = new KProcess();
+            item->process.data()->setOutputChannelMode( KProcess::MergedChannels );
+            connect( item->process.data(), SIGNAL(readyRead()), this, SLOT(processOutput()) );
+            connect( item->process.data(), SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(processExit(int,QProcess::ExitStatus)) );
+            item->process.data()->setProgram( ffmpeg, arguments );
+            item->process.data()->start();
+
+            if( !updateTimer.isActive() )
+                updateTimer.start( ConfigUpdateDelay );
+
+            beginStage( item );
+
+            return;
+        }
+
         logger->log( item->logID, i18n("Copying \"%1\" to \"%2\"",inputUrl.pathOrUrl(),item->outputUrl.toLocalFile()) );
 
         item->kioCopyJob = KIO::file_copy( item->inputUrl, item->outputUrl, -1 , KIO::HideProgressInfo );
         connect( item->kioCopyJob.data(), SIGNAL(result(KJob*)), this, SLOT(kioJobFinished(KJob*)) );
 //         connect( item->kioCopyJob.data(), SIGNAL(percent(KJob*,unsigned long)), this, SLOT(kioJobProgress(KJob*,unsigned long)) );
 
+        beginStage( item );
+
         return;
     }
 
@@ -147,7 +286,49 @@ void Convert::convert( ConvertItem *item )
     }
 
     if( item->take > 0 )
-        item->updateTimes();
+        item->updateTimes( config->timeModel(), conversionOptions );
+
+    item->cacheKey.clear();
+    if( config->data.advanced.conversionCacheSize > 0 && inputUrl.isLocalFile() && item->outputUrl.isLocalFile() )
+    {
+        if( !item->contentHashed )
+        {
+            // hashing reads the whole file, so it runs in a thread and convert() gets called again when it's done
+            QFutureWatcher<QByteArray> *watcher = new QFutureWatcher<QByteArray>( this );
+            connect( watcher, SIGNAL(finished()), this, SLOT(contentHashFinished()) );
+            watcher->setFuture( QtConcurrent::run(&MirrorManifest::contentHash,inputUrl.toLocalFile()) );
+            item->hashWatcher = watcher;
+            return;
+        }
+
+        // the hash is calculated once, the key is cheap for every further take
+        item->cacheKey = ConversionCache::key( item->contentHash, conversionOptions, item->conversionPipes.at(item->take) );
+
+        const QString cachedFile = config->conversionCache()->find( item->cacheKey );
+        if( !cachedFile.isEmpty() )
+        {
+            // the tags get written when the item is removed, like for every other conversion
+            logger->log( item->logID, i18n("Copying the cached conversion result to \"%1\"",item->outputUrl.toLocalFile()) );
+
+            item->state = ConvertItem::convert;
+            item->cacheHit = true;
+            item->conversionPipesStep = 0;
+            float time = 0.0f;
+            foreach( const float t, item->convertTimes )
+            {
+                time += t;
+            }
+            item->convertTimes.clear();
+            item->convertTimes.append( time );
+            item->localCopyJob = new LocalCopyJob( cachedFile, item->outputUrl.toLocalFile(), this );
+            connect( item->localCopyJob.data(), SIGNAL(finished(LocalCopyJob*)), this, SLOT(localCopyFinished(LocalCopyJob*)) );
+            item->localCopyJob.data()->start();
+
+            beginStage( item );
+
+            return;
+        }
+    }
 
     item->conversionPipesStep = -1;
 
@@ -180,13 +361,21 @@ void Convert::convert( ConvertItem *item )
             {
                 item->internalReplayGainUsed = true;
             }
-            item->backendID = qobject_cast<CodecPlugin*>(item->backendPlugin)->convert( inputUrl, item->outputUrl, item->conversionPipes.at(item->take).trunks.at(0).codecFrom, item->conversionPipes.at(item->take).trunks.at(0).codecTo, conversionOptions, item->fileListItem->tags, useInternalReplayGain );
+            CodecPlugin *codecPlugin = qobject_cast<CodecPlugin*>(item->backendPlugin);
+            codecPlugin->setThreadLimit( threadLimit(item) );
+            item->backendID = codecPlugin->convert( inputUrl, item->outputUrl, item->conversionPipes.at(item->take).trunks.at(0).codecFrom, item->conversionPipes.at(item->take).trunks.at(0).codecTo, conversionOptions, item->fileListItem->tags, useInternalReplayGain );
+            codecPlugin->setThreadLimit( 1 );
+            if( item->backendID >= 100 )
+                item->threads = codecPlugin->threadCount( item->backendID );
         }
         else if( item->backendPlugin->type() == "ripper" )
         {
             item->backendID = qobject_cast<RipperPlugin*>(item->backendPlugin)->rip( item->fileListItem->device, item->fileListItem->track, item->fileListItem->tracks, item->outputUrl );
         }
 
+        if( item->backendID >= 100 )
+            beginStage( item );
+
         if( item->backendID < 100 )
         {
             switch( item->backendID )
@@ -214,6 +403,8 @@ void Convert::convert( ConvertItem *item )
         else if( item->backendPlugin->type() == "ripper" )
         {
             item->fileListItem->state = FileListItem::Ripping;
+            item->ripDevice = item->fileListItem->device;
+            startRipVerification( item, item->outputUrl );
         }
     }
     else // conversion needs two plugins or more
@@ -273,6 +464,9 @@ void Convert::convert( ConvertItem *item )
 
             logger->log( item->logID, i18n("Converting") );
             item->state = ConvertItem::convert;
+            // the drive is busy until the whole pipe has finished
+            if( item->conversionPipes.at(item->take).trunks.first().plugin->type() == "ripper" )
+                item->ripDevice = item->fileListItem->device;
             // merge all conversion times into one since we are doing everything in one step
             float time = 0.0f;
             foreach( const float t, item->convertTimes )
@@ -290,6 +484,8 @@ void Convert::convert( ConvertItem *item )
             item->process.data()->clearProgram();
             item->process.data()->setShellCommand( command );
             item->process.data()->start();
+
+            beginStage( item );
         }
         else
         {
@@ -331,6 +527,66 @@ void Convert::convert( ConvertItem *item )
     }
 }
 
+int Convert::slotCount() const
+{
+    int count = 0;
+    foreach( const ConvertItem *item, items )
+    {
+        if( item->state != ConvertItem::rip )
+            count++;
+    }
+    return count;
+}
+
+void Convert::continueRippedItems()
+{
+    // executeNextStep() may remove items, so look for the next waiting item every time
+    while( slotCount() < fileList->numFiles() )
+    {
+        ConvertItem *waitingItem = 0;
+        foreach( ConvertItem *item, items )
+        {
+            if( item->waitingForSlot )
+            {
+                waitingItem = item;
+                break;
+            }
+        }
+        if( !waitingItem )
+            break;
+
+        waitingItem->waitingForSlot = false;
+        executeNextStep( waitingItem );
+    }
+}
+
+QStringList Convert::busyDevices() const
+{
+    QStringList devices;
+    foreach( const ConvertItem *item, items )
+    {
+        if( !item->ripDevice.isEmpty() )
+            devices += item->ripDevice;
+    }
+    return devices;
+}
+
+int Convert::threadLimit( ConvertItem *item )
+{
+    // as long as files are waiting, each core is better used for a file of its own
+    if( fileList->queuedCount() > 0 )
+        return 1;
+
+    int usedThreads = 0;
+    foreach( ConvertItem *otherItem, items )
+    {
+        if( otherItem != item && ( otherItem->backendID >= 100 || otherItem->process.data() ) )
+            usedThreads += otherItem->threads;
+    }
+
+    return qMax( 1, qMin(QThread::idealThreadCount(),fileList->numFiles()) - usedThreads );
+}
+
 void Convert::convertNextBackend( ConvertItem *item )
 {
     if( !item )
@@ -419,13 +675,21 @@ void Convert::convertNextBackend( ConvertItem *item )
         {
             item->internalReplayGainUsed = true;
         }
-        item->backendID = qobject_cast<CodecPlugin*>(plugin)->convert( inUrl, outUrl, item->conversionPipes.at(item->take).trunks.at(step).codecFrom, item->conversionPipes.at(item->take).trunks.at(step).codecTo, conversionOptions, item->fileListItem->tags, useInternalReplayGain );
+        CodecPlugin *codecPlugin = qobject_cast<CodecPlugin*>(plugin);
+        codecPlugin->setThreadLimit( threadLimit(item) );
+        item->backendID = codecPlugin->convert( inUrl, outUrl, item->conversionPipes.at(item->take).trunks.at(step).codecFrom, item->conversionPipes.at(item->take).trunks.at(step).codecTo, conversionOptions, item->fileListItem->tags, useInternalReplayGain );
+        codecPlugin->setThreadLimit( 1 );
+        if( item->backendID >= 100 )
+            item->threads = codecPlugin->threadCount( item->backendID );
     }
     else if( plugin->type() == "ripper" )
     {
         item->backendID = qobject_cast<RipperPlugin*>(plugin)->rip( item->fileListItem->device, item->fileListItem->track, item->fileListItem->tracks, outUrl );
     }
 
+    if( item->backendID >= 100 )
+        beginStage( item );
+
     if( item->backendID < 100 )
     {
         switch( item->backendID )
@@ -453,6 +717,8 @@ void Convert::convertNextBackend( ConvertItem *item )
     else if( item->backendPlugin->type() == "ripper" )
     {
         item->fileListItem->state = FileListItem::Ripping;
+        item->ripDevice = item->fileListItem->device;
+        startRipVerification( item, outUrl );
     }
 }
 
@@ -543,6 +809,9 @@ void Convert::replaygain( ConvertItem *item )
 
     item->backendID = qobject_cast<ReplayGainPlugin*>(item->backendPlugin)->apply( urlList );
 
+    if( item->backendID >= 100 )
+        beginStage( item );
+
     if( item->backendID < 100 )
     {
         switch( item->backendID )
@@ -578,11 +847,10 @@ void Convert::writeTags( ConvertItem *item )
         return;
 
     logger->log( item->logID, i18n("Writing tags") );
+    metrics->beginStage( item->logID, "write_tags" );
 //     item->state = ConvertItem::write_tags;
 //     item->fileListItem->setText( 0, i18n("Writing tags")+"... 00 %" );
 
-    config->tagEngine()->writeTags( item->outputUrl, item->fileListItem->tags );
-
     KUrl inputUrl;
     if( !item->tempInputUrl.toLocalFile().isEmpty() )
         inputUrl = item->tempInputUrl;
@@ -595,11 +863,17 @@ void Convert::writeTags( ConvertItem *item )
         item->fileListItem->tags->tagsRead = TagData::TagsRead(item->fileListItem->tags->tagsRead | TagData::Covers);
     }
 
-    const bool success = config->tagEngine()->writeCovers( item->outputUrl, item->fileListItem->tags->covers );
+    const QList<CoverData*> covers = config->tagEngine()->prepareCovers( item->fileListItem->tags->covers );
+
+    // write the tags and the covers at once, so the output file gets rewritten only once
+    bool success = false;
+    config->tagEngine()->writeTagsAndCovers( item->outputUrl, item->fileListItem->tags, covers, &success );
     if( config->data.coverArt.writeCovers == 0 || ( config->data.coverArt.writeCovers == 1 && !success ) )
     {
-        config->tagEngine()->writeCoversToDirectory( item->outputUrl.directory(), item->fileListItem->tags );
+        config->tagEngine()->writeCoversToDirectory( item->outputUrl.directory(), item->fileListItem->tags, covers );
     }
+
+    qDeleteAll( covers );
 }
 
 // void Convert::executeUserScript( ConvertItem *item )
@@ -634,6 +908,7 @@ void Convert::executeNextStep( ConvertItem *item )
     item->lastTake = item->take;
     item->take = 0;
     item->progress = 0.0f;
+    item->threads = 1;
 
     switch( item->state )
     {
@@ -660,6 +935,10 @@ void Convert::executeNextStep( ConvertItem *item )
         case ConvertItem::convert:
         case ConvertItem::encode:
         {
+            // the output file is copied before the tags are written, so the cached files don't have any
+            if( !item->cacheKey.isEmpty() && !item->cacheHit && storeInCache(item) )
+                break;
+
             if( item->mode & ConvertItem::replaygain )
                 replaygain( item );
             else
@@ -687,10 +966,27 @@ void Convert::executeNextStep( ConvertItem *item )
     }
 }
 
+bool Convert::storeInCache( ConvertItem *item )
+{
+    const QString cacheFile = config->conversionCache()->cacheFileName( item->cacheKey, item->outputUrl.toLocalFile(), config->data.advanced.conversionCacheSize );
+    if( cacheFile.isEmpty() )
+    {
+        item->cacheKey.clear();
+        return false;
+    }
+
+    item->cacheStoring = true;
+    item->localCopyJob = new LocalCopyJob( item->outputUrl.toLocalFile(), cacheFile, this );
+    connect( item->localCopyJob.data(), SIGNAL(finished(LocalCopyJob*)), this, SLOT(localCopyFinished(LocalCopyJob*)) );
+    item->localCopyJob.data()->start();
+
+    return true;
+}
+
 void Convert::executeSameStep( ConvertItem *item )
 {
     item->take++;
-    item->updateTimes();
+    item->updateTimes( config->timeModel(), config->conversionOptionsManager()->getConversionOptions(item->fileListItem->conversionOptionsId) );
     item->progress = 0.0f;
 
     if( item->internalReplayGainUsed )
@@ -763,6 +1059,13 @@ void Convert::kioJobFinished( KJob *job )
         {
             item->kioCopyJob.data()->deleteLater();
 
+            if( job->error() == 0 )
+            {
+                const qint64 size = QFileInfo( item->state == ConvertItem::get ? item->tempInputUrl.toLocalFile() : item->outputUrl.toLocalFile() ).size();
+                metrics->addTransferredBytes( item->logID, size, size );
+            }
+            metrics->endStage( item->logID );
+
             if( job->error() == 0 ) // copy was successful
             {
                 float fileTime;
@@ -789,21 +1092,13 @@ void Convert::kioJobFinished( KJob *job )
                 }
                 if( item->state == ConvertItem::get )
                 {
-                    if( !item->fileListItem->tags )
-                    {
-                        item->fileListItem->tags = config->tagEngine()->readTags( item->tempInputUrl );
-                        if( item->fileListItem->tags )
-                        {
-                            logger->log( item->logID, i18n("Read tags successfully") );
-                        }
-                        else
-                        {
-                            logger->log( item->logID, i18n("Unable to read tags") );
-                        }
-                    }
+                    getFinished( item );
+                }
+                else
+                {
+                    item->finishedTime += fileTime;
+                    executeNextStep( item );
                 }
-                item->finishedTime += fileTime;
-                executeNextStep( item );
             }
             else
             {
@@ -843,6 +1138,133 @@ void Convert::kioJobFinished( KJob *job )
     }
 }
 
+void Convert::localCopyFinished( LocalCopyJob *job )
+{
+    foreach( ConvertItem *item, items )
+    {
+        if( item->localCopyJob.data() == job )
+        {
+            job->deleteLater();
+
+            if( item->cacheStoring )
+            {
+                item->cacheStoring = false;
+
+                // the conversion has succeeded anyway
+                if( job->method() != LocalCopyJob::Failed )
+                    config->conversionCache()->insert( item->cacheKey, job->destination(), config->data.advanced.conversionCacheSize );
+                else
+                    config->conversionCache()->cancelInsert( item->cacheKey, job->destination() );
+
+                // executeNextStep() must not store the file again and has to know the take that has been used
+                item->cacheKey.clear();
+                item->take = item->lastTake;
+
+                if( item->killed )
+                    remove( item, FileListItem::StoppedByUser );
+                else
+                    executeNextStep( item );
+
+                return;
+            }
+
+            if( job->method() != LocalCopyJob::Failed )
+            {
+                const qint64 size = QFileInfo( job->destination() ).size();
+                metrics->addTransferredBytes( item->logID, size, size );
+            }
+            metrics->endStage( item->logID );
+
+            if( item->killed )
+            {
+                remove( item, FileListItem::StoppedByUser );
+                return;
+            }
+
+            switch( job->method() )
+            {
+                case LocalCopyJob::Reflink:
+                    logger->log( item->logID, "\t" + i18n("The file has been copied by sharing its data blocks (reflink)") );
+                    break;
+                case LocalCopyJob::CopyFileRange:
+                    logger->log( item->logID, "\t" + i18n("The file has been copied by the kernel") );
+                    break;
+                case LocalCopyJob::Stream:
+                    logger->log( item->logID, "\t" + i18n("The file has been copied") );
+                    break;
+                case LocalCopyJob::Failed:
+                    logger->log( item->logID, "\t" + i18n("Copying the file failed") );
+                    if( item->cacheHit )
+                    {
+                        // convert the file instead
+                        item->cacheHit = false;
+                        config->conversionCache()->remove( item->cacheKey );
+                        QFile::remove( item->outputUrl.toLocalFile() );
+                        item->updateTimes( config->timeModel(), config->conversionOptionsManager()->getConversionOptions(item->fileListItem->conversionOptionsId) );
+                        convert( item );
+                        return;
+                    }
+                    remove( item, FileListItem::Failed );
+                    return;
+            }
+
+            foreach( const float t, item->convertTimes )
+            {
+                item->finishedTime += t;
+            }
+            executeNextStep( item );
+            return;
+        }
+    }
+}
+
+void Convert::contentHashFinished()
+{
+    QFutureWatcher<QByteArray> *watcher = static_cast< QFutureWatcher<QByteArray>* >( QObject::sender() );
+    watcher->deleteLater();
+
+    foreach( ConvertItem *item, items )
+    {
+        if( item->hashWatcher.data() == watcher )
+        {
+            item->contentHash = watcher->result();
+            item->contentHashed = true;
+
+            if( item->killed )
+            {
+                remove( item, FileListItem::StoppedByUser );
+                return;
+            }
+
+            convert( item );
+            return;
+        }
+    }
+}
+
+void Convert::prefetchFinished( const KUrl& url, bool success )
+{
+    foreach( ConvertItem *item, items )
+    {
+        if( item->state == ConvertItem::get && !item->kioCopyJob.data() && item->tempInputUrl.isEmpty() && item->inputUrl == url )
+        {
+            if( success )
+            {
+                item->tempInputUrl = prefetcher->take( url );
+                logger->log( item->logID, i18n("Using prefetched file \"%1\"",item->tempInputUrl.toLocalFile()) );
+                getFinished( item );
+            }
+            else
+            {
+                // the failed download has been removed from the prefetcher, so this time the file gets copied directly
+                logger->log( item->logID, i18n("Prefetching failed") );
+                get( item );
+            }
+            return;
+        }
+    }
+}
+
 void Convert::processOutput()
 {
     foreach( ConvertItem *item, items )
@@ -852,16 +1274,30 @@ void Convert::processOutput()
             const QString output = item->process.data()->readAllStandardOutput().data();
 
             bool logOutput = true;
-            foreach( const ConversionPipeTrunk& trunk, item->conversionPipes.at(item->take).trunks )
+            if( item->remuxing )
             {
-                const float progress = trunk.plugin->parseOutput( output );
-
-                if( progress > item->progress )
+                // size=    2445kB time=00:01:58.31 bitrate= 169.3kbits/s
+                QRegExp regTime("time=(\\d{2}):(\\d{2}):(\\d{2})\\.(\\d{2})");
+                if( output.contains(regTime) && item->fileListItem->length > 0 )
                 {
-                    item->progress = progress;
+                    const float time = regTime.cap(1).toInt()*3600 + regTime.cap(2).toInt()*60 + regTime.cap(3).toInt() + regTime.cap(4).toInt()/100.0f;
+                    item->progress = qMin( 100.0f, time*100.0f/item->fileListItem->length );
                     logOutput = false;
                 }
             }
+            else if( item->take < item->conversionPipes.count() )
+            {
+                foreach( const ConversionPipeTrunk& trunk, item->conversionPipes.at(item->take).trunks )
+                {
+                    const float progress = trunk.plugin->parseOutput( output );
+
+                    if( progress > item->progress )
+                    {
+                        item->progress = progress;
+                        logOutput = false;
+                    }
+                }
+            }
 
             if( logOutput && !output.simplified().isEmpty() )
                 logger->log( item->logID, "<pre>\t<span style=\"color:#C00000\">" + output.trimmed().replace("\n","<br>\t") + "</span></pre>" );
@@ -888,6 +1324,10 @@ void Convert::processExit( int exitCode, QProcess::ExitStatus exitStatus )
         if( item->process.data() == QObject::sender() )
         {
             item->process.data()->deleteLater(); // NOTE crash discovered here - probably fixed by using deleteLater
+            metrics->endStage( item->logID );
+
+            // the following steps aren't part of the remux
+            item->remuxing = false;
 
             if( item->killed )
             {
@@ -924,8 +1364,9 @@ void Convert::processExit( int exitCode, QProcess::ExitStatus exitStatus )
                 }
                 item->finishedTime += fileTime;
 
-                if( item->state == ConvertItem::rip )
+                if( !item->ripDevice.isEmpty() )
                 {
+                    item->ripDevice.clear();
                     item->fileListItem->state = FileListItem::Converting;
                     emit rippingFinished( item->fileListItem->device );
                 }
@@ -935,6 +1376,13 @@ void Convert::processExit( int exitCode, QProcess::ExitStatus exitStatus )
                     item->mode = ConvertItem::Mode( item->mode ^ ConvertItem::replaygain );
                 }
 
+                if( item->state == ConvertItem::rip && slotCount() >= fileList->numFiles() )
+                {
+                    logger->log( item->logID, i18n("Waiting for a free slot to encode the ripped track") );
+                    item->waitingForSlot = true;
+                    return;
+                }
+
                 switch( item->state )
                 {
                     case ConvertItem::rip:
@@ -973,6 +1421,7 @@ void Convert::pluginProcessFinished( int id, int exitCode )
         if( item->backendPlugin && item->backendPlugin == QObject::sender() && item->backendID == id )
         {
             item->backendID = -1;
+            metrics->endStage( item->logID );
 
             if( item->backendPlugin->name() == "Vorbis Gain" )
             {
@@ -1022,8 +1471,17 @@ void Convert::pluginProcessFinished( int id, int exitCode )
                 }
                 item->finishedTime += fileTime;
 
+                learnStageTime( item );
+
                 if( item->state == ConvertItem::rip )
                 {
+                    const float wallTime = item->stageTime.elapsed() / 1000.0f;
+                    if( wallTime > 0.0f )
+                        logger->log( item->logID, i18n("Read speed of %1: %2x",item->fileListItem->device,QString::number(item->fileListItem->length/wallTime,'f',1)) );
+
+                    finishRipVerification( item );
+
+                    item->ripDevice.clear();
                     item->fileListItem->state = FileListItem::Converting;
                     emit rippingFinished( item->fileListItem->device );
                 }
@@ -1033,6 +1491,13 @@ void Convert::pluginProcessFinished( int id, int exitCode )
                     item->mode = ConvertItem::Mode( item->mode ^ ConvertItem::replaygain );
                 }
 
+                if( item->state == ConvertItem::rip && slotCount() >= fileList->numFiles() )
+                {
+                    logger->log( item->logID, i18n("Waiting for a free slot to encode the ripped track") );
+                    item->waitingForSlot = true;
+                    return;
+                }
+
                 executeNextStep( item );
             }
             else
@@ -1190,7 +1655,7 @@ void Convert::add( FileListItem *fileListItem )
 //     if( (!newItem->inputUrl.isLocalFile() && item->track == -1) || newItem->inputUrl.url().toAscii() != newItem->inputUrl.url() )
 //         newItem->mode = ConvertItem::Mode( newItem->mode | ConvertItem::get );
 
-    newItem->updateTimes();
+    newItem->updateTimes( config->timeModel(), conversionOptions );
 
     // (visual) feedback
     fileListItem->state = FileListItem::Converting;
@@ -1199,6 +1664,166 @@ void Convert::add( FileListItem *fileListItem )
     executeNextStep( newItem );
 }
 
+void Convert::learnStageTime( ConvertItem *item )
+{
+    // a file that has been split up doesn't tell anything about the speed of the backend
+    if( item->threads > 1 )
+        return;
+
+    const float length = item->fileListItem->length;
+    const float wallTime = item->stageTime.elapsed() / 1000.0f;
+
+    if( item->state == ConvertItem::replaygain )
+    {
+        // album gain processes all files of the album at once
+        const QString albumName = item->fileListItem->tags ? item->fileListItem->tags->album : "";
+        if( item->take < item->replaygainPipes.count() && ( albumName.isEmpty() || albumGainItems.value(albumName).isEmpty() ) )
+            config->timeModel()->addStage( TimeModel::replayGainKey(item->backendPlugin->name(),item->replaygainPipes.at(item->take).codecName), length, wallTime );
+    }
+    else if( item->take < item->conversionPipes.count() && item->conversionPipesStep >= 0 && item->conversionPipesStep < item->conversionPipes.at(item->take).trunks.count() )
+    {
+        const ConversionOptions *conversionOptions = config->conversionOptionsManager()->getConversionOptions( item->fileListItem->conversionOptionsId );
+        config->timeModel()->addStage( TimeModel::stageKey(item->conversionPipes.at(item->take).trunks.at(item->conversionPipesStep),conversionOptions), length, wallTime );
+    }
+}
+
+void Convert::beginStage( ConvertItem *item )
+{
+    item->stageTime.start();
+
+    if( !metrics->isEnabled() )
+        return;
+
+    QString stage;
+    QString backend;
+    switch( item->state )
+    {
+        case ConvertItem::get:
+            stage = "get";
+            backend = "KIO";
+            break;
+        case ConvertItem::convert:
+            stage = "convert";
+            break;
+        case ConvertItem::rip:
+            stage = "rip";
+            break;
+        case ConvertItem::decode:
+            stage = "decode";
+            break;
+        case ConvertItem::filter:
+            stage = "filter";
+            break;
+        case ConvertItem::encode:
+            stage = "encode";
+            break;
+        case ConvertItem::replaygain:
+            stage = "replaygain";
+            break;
+        default:
+            return;
+    }
+
+    if( item->kioCopyJob.data() )
+    {
+        backend = "KIO";
+    }
+    else if( item->localCopyJob.data() )
+    {
+        backend = "local copy";
+    }
+    else if( item->remuxing )
+    {
+        backend = "ffmpeg (remux)";
+    }
+    else if( item->process.data() )
+    {
+        // all backends are running in one pipe
+        QStringList backends;
+        foreach( const ConversionPipeTrunk& trunk, item->conversionPipes.at(item->take).trunks )
+        {
+            backends.append( trunk.plugin->name() );
+        }
+        backend = backends.join(" | ");
+    }
+    else if( item->backendPlugin )
+    {
+        backend = item->backendPlugin->name();
+    }
+
+    metrics->beginStage( item->logID, stage, backend );
+}
+
+void Convert::startRipVerification( ConvertItem *item, const KUrl& outputUrl )
+{
+    delete item->ripVerifier;
+    item->ripVerifier = 0;
+
+    // the checksums are calculated per track and the whole table of contents is needed for the lookup
+    const FileListItem *fileListItem = item->fileListItem;
+    if( fileListItem->track <= 0 )
+        return;
+
+    if( fileListItem->track >= fileListItem->discOffsets.count() )
+    {
+        logger->log( item->logID, i18n("The ripped track can't be verified, the disc contains data tracks or its table of contents is unknown") );
+        return;
+    }
+
+    item->ripVerifier = new RipVerifier( outputUrl.toLocalFile(), fileListItem->discOffsets, fileListItem->track );
+
+    RipperPlugin *ripperPlugin = qobject_cast<RipperPlugin*>( item->backendPlugin );
+    item->ripOffsetCorrected = ripperPlugin && ripperPlugin->isReadOffsetCorrected( fileListItem->device );
+}
+
+void Convert::finishRipVerification( ConvertItem *item )
+{
+    if( !item->ripVerifier )
+        return;
+
+    FileListItem *fileListItem = item->fileListItem;
+
+    if( item->ripVerifier->finish() )
+    {
+        fileListItem->ripCrc32 = item->ripVerifier->crc32();
+        fileListItem->accurateRipV1 = item->ripVerifier->accurateRipV1();
+        fileListItem->accurateRipV2 = item->ripVerifier->accurateRipV2();
+        fileListItem->ripConfidence = AccurateRipDatabase::confidence( fileListItem->discOffsets, fileListItem->track, fileListItem->accurateRipV1, fileListItem->accurateRipV2 );
+
+        logger->log( item->logID, i18n("Checksums of the ripped track: CRC32 %1, AccurateRip v1 %2, AccurateRip v2 %3",QString("%1").arg(fileListItem->ripCrc32,8,16,QChar('0')).toUpper(),QString("%1").arg(fileListItem->accurateRipV1,8,16,QChar('0')).toUpper(),QString("%1").arg(fileListItem->accurateRipV2,8,16,QChar('0')).toUpper()) );
+
+        if( fileListItem->ripConfidence < 0 )
+        {
+            fileListItem->ripVerification = FileListItem::NotInDatabase;
+            logger->log( item->logID, i18n("The disc isn't in the imported AccurateRip database (%1)",AccurateRipDatabase::fileName(fileListItem->discOffsets)) );
+        }
+        else if( fileListItem->ripConfidence > 0 )
+        {
+            fileListItem->ripVerification = FileListItem::AccuratelyRipped;
+            logger->log( item->logID, i18n("Accurately ripped (confidence %1)",fileListItem->ripConfidence) );
+        }
+        else if( !item->ripOffsetCorrected )
+        {
+            // a drive with an uncorrected read offset produces other checksums even for a perfect rip
+            fileListItem->ripVerification = FileListItem::ReadOffsetUnknown;
+            logger->log( item->logID, i18n("The rip can't be verified, the read offset of drive %1 isn't configured in the ripper plugin",fileListItem->device) );
+        }
+        else
+        {
+            fileListItem->ripVerification = FileListItem::NotAccuratelyRipped;
+            logger->log( item->logID, i18n("Not accurately ripped, the checksums don't match the AccurateRip database") );
+        }
+    }
+    else
+    {
+        fileListItem->ripVerification = FileListItem::NotVerified;
+        logger->log( item->logID, i18n("Can't calculate the checksums of the ripped track") );
+    }
+
+    delete item->ripVerifier;
+    item->ripVerifier = 0;
+}
+
 void Convert::remove( ConvertItem *item, FileListItem::ReturnCode returnCode )
 {
     // TODO "remove" (re-add) the times to the progress indicator
@@ -1247,40 +1872,69 @@ void Convert::remove( ConvertItem *item, FileListItem::ReturnCode returnCode )
     if( returnCode == FileListItem::Succeeded && item->lastTake > 0 )
         returnCode = FileListItem::SucceededWithProblems;
 
+    QString resultName;
     switch( returnCode )
     {
         case FileListItem::Succeeded:
             exitMessage = i18nc("Conversion exit status","Normal exit");
+            resultName = "succeeded";
             break;
         case FileListItem::SucceededWithProblems:
             exitMessage = i18nc("Conversion exit status","Succeeded but problems occurred");
+            resultName = "succeeded_with_problems";
             break;
         case FileListItem::StoppedByUser:
             exitMessage = i18nc("Conversion exit status","Aborted by the user");
+            resultName = "stopped_by_user";
             break;
         case FileListItem::BackendNeedsConfiguration:
             exitMessage = i18nc("Conversion exit status","Backend needs configuration");
+            resultName = "backend_needs_configuration";
             break;
         case FileListItem::DiscFull:
             exitMessage = i18nc("Conversion exit status","Not enough space on the output device");
+            resultName = "disc_full";
             break;
         case FileListItem::CantWriteOutput:
             exitMessage = i18nc("Conversion exit status","Cannot write to output directory, please check permissions");
+            resultName = "cant_write_output";
             break;
         case FileListItem::Skipped:
             exitMessage = i18nc("Conversion exit status","File already exists");
+            resultName = "skipped";
             break;
         case FileListItem::Encrypted:
             exitMessage = i18nc("Conversion exit status","File is encrypted");
+            resultName = "encrypted";
             break;
         case FileListItem::Failed:
             exitMessage = i18nc("Conversion exit status","An error occurred");
+            resultName = "failed";
             break;
     }
 
     if( returnCode == FileListItem::Succeeded || returnCode == FileListItem::SucceededWithProblems )
         writeTags( item );
 
+    if( ( returnCode == FileListItem::Succeeded || returnCode == FileListItem::SucceededWithProblems ) && config->data.general.mirrorSync && item->fileListItem->local && item->fileListItem->track == -1 )
+    {
+        const QString previousOutputPath = config->mirrorManifest()->update( item->inputUrl.toLocalFile(), MirrorManifest::fingerprint(conversionOptions), item->outputUrl.toLocalFile() );
+        if( !previousOutputPath.isEmpty() && QFile::exists(previousOutputPath) )
+        {
+            // another source file may have been converted to the same path in the meantime
+            const bool outputUsed = usedOutputNames.values().contains( previousOutputPath ) || config->mirrorManifest()->isOutputUsed( previousOutputPath, item->inputUrl.toLocalFile() );
+            if( config->data.general.mirrorRemoveOrphans && !outputUsed )
+            {
+                logger->log( item->logID, i18n("Removing previous output file \"%1\"",previousOutputPath) );
+                QFile::remove( previousOutputPath );
+            }
+            else
+            {
+                logger->log( item->logID, i18n("The previous output file \"%1\" is kept",previousOutputPath) );
+            }
+        }
+    }
+
     if( !waitForAlbumGain && !item->fileListItem->notifyCommand.isEmpty() && ( !config->data.general.waitForAlbumGain || !conversionOptions || !conversionOptions->replaygain ) )
     {
         QList<ConvertItem*> albumItems;
@@ -1318,6 +1972,11 @@ void Convert::remove( ConvertItem *item, FileListItem::ReturnCode returnCode )
         logger->log( item->logID, i18n("Removing partially converted output file") );
         QFile::remove(item->outputUrl.toLocalFile());
     }
+    if( ( returnCode == FileListItem::CantWriteOutput || returnCode == FileListItem::Failed ) && !item->outputUrl.isEmpty() )
+    {
+        // the output directory might have been removed in the meantime
+        OutputDirectory::invalidatePath( item->outputUrl );
+    }
 
     usedOutputNames.remove( item->logID );
 
@@ -1329,10 +1988,14 @@ void Convert::remove( ConvertItem *item, FileListItem::ReturnCode returnCode )
 
     emit timeFinished( item->fileListItem->length );
 
+    metrics->finishJob( item->logID, item->inputUrl.pathOrUrl(), item->outputUrl.toLocalFile(), resultName );
+
     if( item->process.data() )
         item->process.data()->deleteLater();
     if( item->kioCopyJob.data() )
         item->kioCopyJob.data()->deleteLater();
+    if( item->localCopyJob.data() )
+        item->localCopyJob.data()->deleteLater();
 
     if( !waitForAlbumGain && !albumName.isEmpty() )
     {
@@ -1354,6 +2017,8 @@ void Convert::remove( ConvertItem *item, FileListItem::ReturnCode returnCode )
     if( !waitForAlbumGain )
         delete item;
 
+    continueRippedItems();
+
     if( items.size() == 0 && albumGainItems.size() == 0 )
         updateTimer.stop();
 }
@@ -1378,6 +2043,22 @@ void Convert::kill( FileListItem *fileListItem )
             {
                 items.at(i)->kioCopyJob.data()->kill( KJob::EmitResult );
             }
+            else if( items.at(i)->localCopyJob.data() != 0 )
+            {
+                items.at(i)->localCopyJob.data()->kill();
+            }
+            else if( items.at(i)->waitingForSlot )
+            {
+                remove( items.at(i), FileListItem::StoppedByUser );
+                break;
+            }
+            else if( items.at(i)->state == ConvertItem::get && prefetcher->contains(items.at(i)->inputUrl) )
+            {
+                // waiting for the prefetcher
+                prefetcher->cancel( items.at(i)->inputUrl );
+                remove( items.at(i), FileListItem::StoppedByUser );
+                break;
+            }
         }
     }
 }
@@ -1387,6 +2068,9 @@ void Convert::itemRemoved( FileListItem *fileListItem )
     if( !fileListItem )
         return;
 
+    if( !fileListItem->local )
+        prefetcher->cancel( fileListItem->url );
+
     const QString albumName = fileListItem->tags ? fileListItem->tags->album : "";
 
     if( !albumName.isEmpty() )
@@ -1404,6 +2088,18 @@ void Convert::itemRemoved( FileListItem *fileListItem )
     }
 }
 
+void Convert::prefetch( const QList<FileListItem*>& fileListItems )
+{
+    KUrl::List urls;
+    foreach( const FileListItem *fileListItem, fileListItems )
+    {
+        if( !fileListItem->local && fileListItem->track < 0 )
+            urls.append( fileListItem->url );
+    }
+
+    prefetcher->prefetch( urls );
+}
+
 void Convert::updateProgress()
 {
     float time = 0.0f;
@@ -1420,10 +2116,13 @@ void Convert::updateProgress()
         if( item->backendID != -1 && item->backendPlugin )
         {
             fileProgress = item->backendPlugin->progress( item->backendID );
+            metrics->sample( item->logID, item->backendPlugin->processId(item->backendID) );
         }
         else
         {
             fileProgress = item->progress;
+            if( item->process.data() )
+                metrics->sample( item->logID, item->process.data()->pid() );
         }
 
         if( fileProgress >= 0 )
@@ -1459,7 +2158,21 @@ void Convert::updateProgress()
             case ConvertItem::rip:
             {
                 fileTime = item->convertTimes.at(item->conversionPipesStep);
-                item->fileListItem->setText( 0, i18n("Ripping")+"... "+fileProgressString );
+                // hash the new samples while they are still cached
+                if( item->ripVerifier && !item->ripVerifier->update() )
+                {
+                    logger->log( item->logID, i18n("Can't calculate the checksums of the ripped track") );
+                    delete item->ripVerifier;
+                    item->ripVerifier = 0;
+                }
+                // every drive rips one track at a time, so this is the throughput of the drive
+                const float wallTime = item->stageTime.elapsed() / 1000.0f;
+                if( item->waitingForSlot )
+                    item->fileListItem->setText( 0, i18n("Waiting") );
+                else if( wallTime >= 1.0f && fileProgress > 0 )
+                    item->fileListItem->setText( 0, i18n("Ripping")+"... "+fileProgressString+" ("+i18nc("The read speed of a cd drive","%1x",QString::number(fileProgress/100.0f*item->fileListItem->length/wallTime,'f',1))+")" );
+                else
+                    item->fileListItem->setText( 0, i18n("Ripping")+"... "+fileProgressString );
                 break;
             }
             case ConvertItem::decode:
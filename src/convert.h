@@ -16,9 +16,13 @@ class CDManager;
 class Config;
 class ConvertItem;
 class FileList;
+class JobMetrics;
+class LocalCopyJob;
 class Logger;
+class Prefetcher;
 
 class KJob;
+class KUrl;
 
 
 /**
@@ -34,13 +38,33 @@ public:
 
     void cleanUp();
 
+    /** Returns the drives that tracks are being ripped from */
+    QStringList busyDevices() const;
+
 private:
     /** Copy the file with the file list item @p item to a temporary directory and download if necessary */
     void get( ConvertItem *item );
 
+    /** The file of @p item has been copied to the temporary directory */
+    void getFinished( ConvertItem *item );
+
+    /** Returns the ffmpeg binary of the FFmpeg plugin if files of the codec @p codecName can be remuxed instead of being copied, an empty string otherwise */
+    QString remuxBinary( const QString& codecName );
+
     /** Convert the file */
     void convert( ConvertItem *item );
 
+    /** Copies the output file of @p item into the conversion cache, returns false if it doesn't get cached */
+    bool storeInCache( ConvertItem *item );
+
+    /** Returns the number of items that take a slot of the files to convert at once, ripping a track doesn't take one */
+    int slotCount() const;
+    /** Encodes ripped tracks as long as there are free slots */
+    void continueRippedItems();
+
+    /** Returns the number of processor cores the next conversion step of @p item may use, more than one only if nothing is waiting in the queue */
+    int threadLimit( ConvertItem *item );
+
     /** Apply a filter to the file after it has been decoded in convert() */
     void convertNextBackend( ConvertItem *item );
 
@@ -59,6 +83,16 @@ private:
     /** Make another try for @p item */
     void executeSameStep( ConvertItem *item );
 
+    /** Tell the job metrics that @p item has started a new conversion step */
+    void beginStage( ConvertItem *item );
+    /** Feed the duration of the conversion step of @p item that has just finished into the time model */
+    void learnStageTime( ConvertItem *item );
+
+    /** Start calculating the checksums of the track that gets ripped by @p item to @p outputUrl */
+    void startRipVerification( ConvertItem *item, const KUrl& outputUrl );
+    /** Compare the checksums of the ripped track with the AccurateRip database and store the result in the file list item */
+    void finishRipVerification( ConvertItem *item );
+
     /** Remove item @p item and emit the state @p state */
     void remove( ConvertItem *item, FileListItem::ReturnCode returnCode = FileListItem::Succeeded );
 
@@ -72,6 +106,8 @@ private:
     CDManager* cdManager;
     FileList *fileList;
     Logger* logger;
+    JobMetrics *metrics;
+    Prefetcher *prefetcher;
     QMap<int,QString> usedOutputNames;
 
     QStringList activeVorbisGainDirectories; // vorbisgain creates temporary files with the fixed name "vorbisgain.tmp", so it must run only once per directory (https://github.com/HessiJames/soundkonverter/issues/12)
@@ -93,6 +129,15 @@ private slots:
     /** The file has been moved */
     void kioJobFinished( KJob *job );
 
+    /** A local file has been copied */
+    void localCopyFinished( LocalCopyJob *job );
+
+    /** The hash of an input file for the conversion cache has been calculated */
+    void contentHashFinished();
+
+    /** The prefetcher has finished downloading @p url */
+    void prefetchFinished( const KUrl& url, bool success );
+
     /** Get the process' output */
     void processOutput();
 
@@ -115,6 +160,8 @@ public slots:
     void kill( FileListItem *fileListItem );
     /** the file list item @p item will get removed */
     void itemRemoved( FileListItem *fileListItem );
+    /** Download the remote files of @p fileListItems ahead of their conversion */
+    void prefetch( const QList<FileListItem*>& fileListItems );
 
     /** Change the process priorities */
 //     void priorityChanged( int );
@@ -125,6 +172,8 @@ signals:
     void finished( FileListItem *fileListItem, FileListItem::ReturnCode returnCode, bool waitingForAlbumGain = false );
     /** The next track from the device can be ripped while the track is being encoded */
     void rippingFinished( const QString& device );
+    /** The output file @p path is going to be written, e.g. for excluding it from watched directories */
+    void outputFileCreated( const QString& path );
 
     // connected to Logger
     /** Tell the logger that the process has finished */
@@ -1,6 +1,8 @@
 
 #include "convertitem.h"
 #include "filelistitem.h"
+#include "ripverifier.h"
+#include "timemodel.h"
 
 #include <KStandardDirs>
 #include <QFile>
@@ -14,6 +16,9 @@ ConvertItem::ConvertItem( FileListItem *item )
     finishedTime = 0.0f;
     progress = 0.0f;
 
+    ripVerifier = 0;
+    ripOffsetCorrected = false;
+    waitingForSlot = false;
     backendPlugin = 0;
     backendID = -1;
 
@@ -24,6 +29,11 @@ ConvertItem::ConvertItem( FileListItem *item )
 
     killed = false;
     internalReplayGainUsed = false;
+    remuxing = false;
+    threads = 1;
+    contentHashed = false;
+    cacheHit = false;
+    cacheStoring = false;
 
     mode = initial;
     state = initial;
@@ -31,7 +41,9 @@ ConvertItem::ConvertItem( FileListItem *item )
 }
 
 ConvertItem::~ConvertItem()
-{}
+{
+    delete ripVerifier;
+}
 
 KUrl ConvertItem::generateTempUrl( const QString& trunk, const QString& extension, bool useSharedMemory )
 {
@@ -52,11 +64,15 @@ KUrl ConvertItem::generateTempUrl( const QString& trunk, const QString& extensio
     return KUrl(tempUrl);
 }
 
-void ConvertItem::updateTimes()
+void ConvertItem::updateTimes( TimeModel *timeModel, const ConversionOptions *conversionOptions )
 {
+    // the guessed wall time per second of audio is used until the time model has learned the real one
+    const float defaultFactor = TimeModel::DefaultFactor;
+
     float totalTime = 0.0f;
-    getTime = ( mode & ConvertItem::get ) ? 0.8f : 0.0f;                        // TODO file size? connection speed?
+    getTime = ( mode & ConvertItem::get ) ? 0.8f * defaultFactor : 0.0f;       // TODO file size? connection speed?
     totalTime += getTime;
+    convertTimes.clear();
     if( conversionPipes.count() > take )
     {
         foreach( const ConversionPipeTrunk& trunk, conversionPipes.at(take).trunks )
@@ -74,12 +90,23 @@ void ConvertItem::updateTimes()
             if( trunk.codecFrom == "wav" && trunk.codecTo == "wav" )
                 time += 0.4f;
 
+            time *= defaultFactor;
+
+            if( timeModel )
+                time = timeModel->stageFactor( TimeModel::stageKey(trunk,conversionOptions), time );
+
             totalTime += time;
 
             convertTimes.append( time );
         }
     }
-    replaygainTime = ( mode & ConvertItem::replaygain ) ? 0.2f : 0.0f;
+    replaygainTime = 0.0f;
+    if( mode & ConvertItem::replaygain )
+    {
+        replaygainTime = 0.2f * defaultFactor;
+        if( timeModel && replaygainPipes.count() > 0 && replaygainPipes.first().plugin )
+            replaygainTime = timeModel->stageFactor( TimeModel::replayGainKey(replaygainPipes.first().plugin->name(),replaygainPipes.first().codecName), replaygainTime );
+    }
     totalTime += replaygainTime;
 
     const float length = fileListItem ? fileListItem->length : 200.0f;
@@ -7,12 +7,17 @@
 
 #include <kio/job.h>
 
+#include <QFutureWatcher>
 #include <QList>
 #include <QTime>
 #include <QWeakPointer>
 
+class ConversionOptions;
 class FileListItem;
 class KProcess;
+class LocalCopyJob;
+class RipVerifier;
+class TimeModel;
 
 
 /**
@@ -61,6 +66,16 @@ public:
     QWeakPointer<KProcess> process;
     /** for moving the file to the temporary directory */
     QWeakPointer<KIO::FileCopyJob> kioCopyJob;
+    /** for copying local files if the codec doesn't change */
+    QWeakPointer<LocalCopyJob> localCopyJob;
+    /** calculates the checksums of the track while it's being ripped */
+    RipVerifier *ripVerifier;
+    /** is the read offset of the drive corrected, otherwise the AccurateRip checksums can't match */
+    bool ripOffsetCorrected;
+    /** the drive the item is reading from, empty if it isn't ripping */
+    QString ripDevice;
+    /** the track has been ripped and waits for a free slot to get encoded */
+    bool waitingForSlot;
     /** the active plugin */
     BackendPlugin *backendPlugin;
     /** the id from the active plugin (-1 if false) */
@@ -71,6 +86,20 @@ public:
     bool killed;
     /** has the internal replaygain been used in this conversion take? */
     bool internalReplayGainUsed;
+    /** is the file being remuxed instead of being copied or converted? */
+    bool remuxing;
+    /** the number of processor cores used by the current conversion step */
+    int threads;
+    /** the hash of the input file for the conversion cache, it's calculated in a thread */
+    QByteArray contentHash;
+    bool contentHashed;
+    QWeakPointer< QFutureWatcher<QByteArray> > hashWatcher;
+    /** the key of the conversion result in the conversion cache, empty if it shouldn't be cached */
+    QByteArray cacheKey;
+    /** is the output file being copied from the conversion cache? */
+    bool cacheHit;
+    /** is the output file being copied into the conversion cache? */
+    bool cacheStoring;
 
     /** the url from fileListItem or the download temp file */
     KUrl inputUrl;
@@ -98,7 +127,11 @@ public:
 
     float finishedTime; // the time of the finished conversion steps
 
-    void updateTimes();
+    /** Splits the length of the file up into the conversion steps, using the speeds learned by @p timeModel */
+    void updateTimes( TimeModel *timeModel = 0, const ConversionOptions *conversionOptions = 0 );
+
+    /** measures the duration of the current conversion step */
+    QTime stageTime;
 
     /** the current conversion progress */
     float progress;
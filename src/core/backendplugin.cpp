@@ -2,7 +2,34 @@
 #include "backendplugin.h"
 
 #include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
 #include <KStandardDirs>
+#include <KConfigGroup>
+#include <KGlobal>
+#include <KSharedConfig>
+
+
+// QHash< binary name, location (empty if not found) >
+static QHash<QString,QString> binaryCache;
+static bool binaryCacheChanged = false;
+
+/** returns the modification times of all directories searched by KStandardDirs::findExe, any installed or removed binary changes them */
+static QStringList pathModificationTimes( QStringList *pathDirectories )
+{
+    QStringList modificationTimes;
+
+    // KStandardDirs::findExe looks into the KDE libexec and bin directories before $PATH
+    *pathDirectories = QStringList() << KStandardDirs::installPath("libexec") << KStandardDirs::installPath("exe");
+    *pathDirectories += QString::fromLocal8Bit( qgetenv("PATH") ).split( ':', QString::SkipEmptyParts );
+    foreach( const QString& directory, *pathDirectories )
+    {
+        QFileInfo directoryInfo( directory );
+        modificationTimes.append( directoryInfo.exists() ? QString::number(directoryInfo.lastModified().toTime_t()) : "-" );
+    }
+
+    return modificationTimes;
+}
 
 
 BackendPluginItem::BackendPluginItem( QObject *parent )
@@ -402,11 +429,70 @@ BackendPlugin::FormatInfo BackendPlugin::formatInfo( const QString& codecName )
     return info;
 }
 
+void BackendPlugin::loadBinaryCache()
+{
+    binaryCache.clear();
+    binaryCacheChanged = false;
+
+    KSharedConfig::Ptr conf = KGlobal::config();
+    KConfigGroup group = conf->group( "BinaryCache" );
+
+    QStringList pathDirectories;
+    const QStringList modificationTimes = pathModificationTimes( &pathDirectories );
+    if( group.readEntry("path",QStringList()) != pathDirectories || group.readEntry("pathModified",QStringList()) != modificationTimes )
+        return;
+
+    const QStringList names = group.readEntry( "names", QStringList() );
+    const QStringList locations = group.readEntry( "locations", QStringList() );
+    if( names.count() != locations.count() )
+        return;
+
+    for( int i=0; i<names.count(); i++ )
+    {
+        binaryCache.insert( names.at(i), locations.at(i) );
+    }
+}
+
+void BackendPlugin::saveBinaryCache()
+{
+    if( !binaryCacheChanged )
+        return;
+
+    QStringList pathDirectories;
+    const QStringList modificationTimes = pathModificationTimes( &pathDirectories );
+
+    KSharedConfig::Ptr conf = KGlobal::config();
+    KConfigGroup group = conf->group( "BinaryCache" );
+    group.writeEntry( "path", pathDirectories );
+    group.writeEntry( "pathModified", modificationTimes );
+    group.writeEntry( "names", binaryCache.keys() );
+    group.writeEntry( "locations", binaryCache.values() );
+
+    binaryCacheChanged = false;
+}
+
+QString BackendPlugin::findExe( const QString& name )
+{
+    QHash<QString,QString>::const_iterator it = binaryCache.constFind( name );
+    if( it != binaryCache.constEnd() )
+    {
+        // the binary might have been removed without changing the directory (e.g. a dangling symlink)
+        if( it.value().isEmpty() || QFile::exists(it.value()) )
+            return it.value();
+    }
+
+    const QString location = KStandardDirs::findExe( name );
+    binaryCache.insert( name, location );
+    binaryCacheChanged = true;
+
+    return location;
+}
+
 void BackendPlugin::scanForBackends( const QStringList& directoryList )
 {
     for( QMap<QString, QString>::Iterator a = binaries.begin(); a != binaries.end(); ++a )
     {
-        a.value() = KStandardDirs::findExe( a.key() );
+        a.value() = findExe( a.key() );
         if( a.value().isEmpty() )
         {
             for( QList<QString>::const_iterator b = directoryList.begin(); b != directoryList.end(); ++b )
@@ -470,6 +556,18 @@ float BackendPlugin::progress( int id )
     return 0.0f;
 }
 
+qint64 BackendPlugin::processId( int id )
+{
+    for( int i=0; i<backendItems.size(); i++ )
+    {
+        if( backendItems.at(i)->id == id && backendItems.at(i)->process != 0 )
+        {
+            return backendItems.at(i)->process->pid();
+        }
+    }
+    return 0;
+}
+
 // void BackendPlugin::setPriority( int _priority )
 // {
 //     priority = _priority;
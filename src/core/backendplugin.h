@@ -97,11 +97,19 @@ public:
     virtual bool kill( int id );
 //     virtual void setPriority( int _priority );
     virtual float progress( int id );
+    /** returns the process id of the backend process for the job @p id or 0 if there's none */
+    qint64 processId( int id );
     virtual float parseOutput( const QString& output ) = 0;
 //     virtual float parseOutput( const QString& output, BackendPluginItem *backendItem = 0 ) = 0; TODO ogg replaygain fix
 
     /** search for the backend binaries in the given directories */
     virtual void scanForBackends( const QStringList& directoryList = QStringList() );
+    /** returns the location of the binary @p name like KStandardDirs::findExe, the result is taken from the binary cache if possible */
+    static QString findExe( const QString& name );
+    /** loads the locations of the binaries found at the last start, they are only used if no searched directory has changed since */
+    static void loadBinaryCache();
+    /** saves the locations of the binaries if they have changed */
+    static void saveBinaryCache();
     /** holds all backend binaries and their location if they were found */
     QMap<QString,QString> binaries;
 
@@ -17,6 +17,7 @@ CodecPlugin::CodecPlugin( QObject *parent )
     : BackendPlugin( parent )
 {
     lastUsedConversionOptions = 0;
+    threadLimit = 1;
 }
 
 CodecPlugin::~CodecPlugin()
@@ -30,6 +31,13 @@ QString CodecPlugin::type() const
     return "codec";
 }
 
+int CodecPlugin::threadCount( int id )
+{
+    Q_UNUSED(id)
+
+    return 1;
+}
+
 CodecWidget *CodecPlugin::deleteCodecWidget( CodecWidget *codecWidget )
 {
     if( !codecWidget )
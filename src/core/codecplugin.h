@@ -51,8 +51,15 @@ public:
 
     const ConversionOptions* lastConversionOptions();
 
+    /** Sets the number of processor cores the next call of convert() may use */
+    void setThreadLimit( int threads ) { threadLimit = threads; }
+    /** Returns the number of processor cores the conversion @p id uses */
+    virtual int threadCount( int id );
+
 protected:
     ConversionOptions *lastUsedConversionOptions;
+    /** more than one if the conversion may split the file up, e.g. for the last files of the queue */
+    int threadLimit;
 
 };
 
@@ -33,3 +33,10 @@ QString RipperPlugin::type() const
 {
     return "ripper";
 }
+
+bool RipperPlugin::isReadOffsetCorrected( const QString& device )
+{
+    Q_UNUSED(device)
+
+    return false;
+}
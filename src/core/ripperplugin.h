@@ -43,6 +43,8 @@ public:
     virtual int rip( const QString& device, int track, int tracks, const KUrl& outputFile ) = 0;
     /** returns a command for ripping a track through a pipe; "" if pipes aren't supported */
     virtual QStringList ripCommand( const QString& device, int track, int tracks, const KUrl& outputFile ) = 0;
+    /** returns true if the read offset of @p device is corrected while ripping, needed for matching AccurateRip checksums */
+    virtual bool isReadOffsetCorrected( const QString& device );
 };
 
 #define K_EXPORT_SOUNDKONVERTER_RIPPER(libname, classname) \
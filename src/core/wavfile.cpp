@@ -0,0 +1,406 @@
+
+#include "wavfile.h"
+
+#include <math.h>
+#include <string.h>
+
+
+#define WAVE_FORMAT_PCM 0x0001
+#define WAVE_FORMAT_IEEE_FLOAT 0x0003
+#define WAVE_FORMAT_EXTENSIBLE 0xFFFE
+
+
+namespace
+{
+    quint16 readUInt16( const char *data )
+    {
+        const uchar *d = reinterpret_cast<const uchar*>(data);
+        return d[0] | ( d[1] << 8 );
+    }
+
+    quint32 readUInt32( const char *data )
+    {
+        const uchar *d = reinterpret_cast<const uchar*>(data);
+        return d[0] | ( d[1] << 8 ) | ( d[2] << 16 ) | ( (quint32)d[3] << 24 );
+    }
+
+    void writeUInt16( char *data, quint16 value )
+    {
+        data[0] = value;
+        data[1] = value >> 8;
+    }
+
+    void writeUInt32( char *data, quint32 value )
+    {
+        data[0] = value;
+        data[1] = value >> 8;
+        data[2] = value >> 16;
+        data[3] = value >> 24;
+    }
+}
+
+
+WavFile::WavFile()
+    : writing( false ),
+    rate( 0 ),
+    channelCount( 0 ),
+    bits( 0 ),
+    format( Integer ),
+    mask( 0 ),
+    dataOffset( 0 ),
+    frames( 0 ),
+    framePosition( 0 )
+{}
+
+WavFile::~WavFile()
+{
+    close();
+}
+
+bool WavFile::openRead( const QString& fileName )
+{
+    file.setFileName( fileName );
+    if( !file.open(QIODevice::ReadOnly) )
+        return false;
+
+    writing = false;
+
+    char header[12];
+    if( file.read(header,12) != 12 || qstrncmp(header,"RIFF",4) != 0 || qstrncmp(header+8,"WAVE",4) != 0 )
+        return false;
+
+    int formatTag = 0;
+    mask = 0;
+
+    while( true )
+    {
+        char chunkHeader[8];
+        if( file.read(chunkHeader,8) != 8 )
+            return false;
+
+        const qint64 chunkSize = readUInt32( chunkHeader + 4 );
+
+        if( qstrncmp(chunkHeader,"fmt ",4) == 0 )
+        {
+            if( chunkSize < 16 )
+                return false;
+
+            const QByteArray fmt = file.read( chunkSize + ( chunkSize & 1 ) );
+            if( fmt.size() < chunkSize )
+                return false;
+
+            formatTag = readUInt16( fmt.constData() );
+            channelCount = readUInt16( fmt.constData() + 2 );
+            rate = readUInt32( fmt.constData() + 4 );
+            bits = readUInt16( fmt.constData() + 14 );
+
+            // the actual format is the first part of the sub format guid
+            if( formatTag == WAVE_FORMAT_EXTENSIBLE && chunkSize >= 40 )
+            {
+                mask = readUInt32( fmt.constData() + 20 );
+                formatTag = readUInt16( fmt.constData() + 24 );
+            }
+        }
+        else if( qstrncmp(chunkHeader,"data",4) == 0 )
+        {
+            if( formatTag == 0 || channelCount == 0 )
+                return false;
+
+            if( mask == 0 )
+                mask = defaultChannelMask( channelCount );
+
+            dataOffset = file.pos();
+            qint64 dataSize = chunkSize;
+
+            // backends writing to a pipe can't know the size in advance
+            if( dataSize == 0 || dataSize == 0xFFFFFFFF || dataOffset + dataSize > file.size() )
+                dataSize = file.size() - dataOffset;
+
+            if( formatTag == WAVE_FORMAT_PCM && ( bits == 8 || bits == 16 || bits == 24 || bits == 32 ) )
+                format = Integer;
+            else if( formatTag == WAVE_FORMAT_IEEE_FLOAT && ( bits == 32 || bits == 64 ) )
+                format = Float;
+            else
+                return false;
+
+            frames = dataSize / ( bits / 8 * channelCount );
+            framePosition = 0;
+
+            return true;
+        }
+        else
+        {
+            if( !file.seek(file.pos() + chunkSize + ( chunkSize & 1 )) )
+                return false;
+        }
+    }
+}
+
+quint32 WavFile::defaultChannelMask( int channels )
+{
+    switch( channels )
+    {
+        case 1:
+            return FrontCenter;
+        case 2:
+            return FrontLeft | FrontRight;
+        case 3:
+            return FrontLeft | FrontRight | FrontCenter;
+        case 4:
+            return FrontLeft | FrontRight | BackLeft | BackRight;
+        case 5:
+            return FrontLeft | FrontRight | FrontCenter | BackLeft | BackRight;
+        case 6:
+            return FrontLeft | FrontRight | FrontCenter | LowFrequency | BackLeft | BackRight;
+        case 7:
+            return FrontLeft | FrontRight | FrontCenter | LowFrequency | BackCenter | SideLeft | SideRight;
+        case 8:
+            return FrontLeft | FrontRight | FrontCenter | LowFrequency | BackLeft | BackRight | SideLeft | SideRight;
+    }
+
+    return 0;
+}
+
+bool WavFile::openWrite( const QString& fileName, int sampleRate, int channels, int bitsPerSample, SampleFormat sampleFormat )
+{
+    file.setFileName( fileName );
+    if( !file.open(QIODevice::WriteOnly | QIODevice::Truncate) )
+        return false;
+
+    writing = true;
+
+    rate = sampleRate;
+    channelCount = channels;
+    bits = bitsPerSample;
+    format = sampleFormat;
+    mask = 0;
+    frames = 0;
+    framePosition = 0;
+
+    // more than two channels or more than 16 bit integer samples need the extensible format
+    const bool extensible = ( channels > 2 || ( format == Integer && bits > 16 ) );
+    const int formatTag = ( format == Float ) ? WAVE_FORMAT_IEEE_FLOAT : WAVE_FORMAT_PCM;
+
+    QByteArray header( extensible ? 68 : 44, 0 );
+    char *h = header.data();
+    const int fmtSize = extensible ? 40 : 16;
+
+    memcpy( h, "RIFF", 4 );
+    memcpy( h + 8, "WAVE", 4 );
+    memcpy( h + 12, "fmt ", 4 );
+    writeUInt32( h + 16, fmtSize );
+    writeUInt16( h + 20, extensible ? WAVE_FORMAT_EXTENSIBLE : formatTag );
+    writeUInt16( h + 22, channels );
+    writeUInt32( h + 24, sampleRate );
+    writeUInt32( h + 28, sampleRate * channels * bits / 8 );
+    writeUInt16( h + 32, channels * bits / 8 );
+    writeUInt16( h + 34, bits );
+    if( extensible )
+    {
+        static const char guidTail[14] = { 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, (char)0x80, 0x00, 0x00, (char)0xAA, 0x00, 0x38, (char)0x9B, 0x71 };
+
+        writeUInt16( h + 36, 22 );
+        writeUInt16( h + 38, bits );
+        writeUInt32( h + 40, 0 ); // no speaker positions
+        writeUInt16( h + 44, formatTag );
+        memcpy( h + 46, guidTail, 14 );
+    }
+    memcpy( h + fmtSize + 20, "data", 4 );
+
+    dataOffset = header.size();
+
+    return file.write( header ) == header.size();
+}
+
+bool WavFile::close()
+{
+    if( !file.isOpen() )
+        return true;
+
+    bool success = true;
+
+    if( writing )
+    {
+        const qint64 dataSize = file.pos() - dataOffset;
+        char size[4];
+
+        // sizes that don't fit into the header are set to the maximum, readers fall back to the file size
+        writeUInt32( size, qMin(dataOffset + dataSize - 8, (qint64)0xFFFFFFFF) );
+        success = file.seek( 4 ) && file.write( size, 4 ) == 4;
+
+        writeUInt32( size, qMin(dataSize, (qint64)0xFFFFFFFF) );
+        success = success && file.seek( dataOffset - 4 ) && file.write( size, 4 ) == 4;
+
+        success = success && file.flush();
+    }
+
+    file.close();
+
+    return success;
+}
+
+int WavFile::read( float *samples, int count )
+{
+    if( writing || !file.isOpen() )
+        return -1;
+
+    count = qMin( (qint64)count, frames - framePosition );
+    if( count <= 0 )
+        return 0;
+
+    const int frameSize = bits / 8 * channelCount;
+    buffer.resize( count * frameSize );
+
+    if( file.read(buffer.data(),buffer.size()) != buffer.size() )
+        return -1;
+
+    decode( buffer.constData(), count * channelCount, samples );
+    framePosition += count;
+
+    return count;
+}
+
+int WavFile::readRaw( char *data, int count )
+{
+    if( writing || !file.isOpen() )
+        return -1;
+
+    count = qMin( (qint64)count, frames - framePosition );
+    if( count <= 0 )
+        return 0;
+
+    const int frameSize = bits / 8 * channelCount;
+    if( file.read(data,count*frameSize) != count*frameSize )
+        return -1;
+
+    framePosition += count;
+
+    return count;
+}
+
+bool WavFile::write( const float *samples, int count )
+{
+    if( !writing || !file.isOpen() )
+        return false;
+
+    const int frameSize = bits / 8 * channelCount;
+    buffer.resize( count * frameSize );
+
+    encode( samples, count * channelCount, buffer.data() );
+
+    if( file.write(buffer) != buffer.size() )
+        return false;
+
+    framePosition += count;
+
+    return true;
+}
+
+bool WavFile::rewind()
+{
+    if( writing || !file.isOpen() || !file.seek(dataOffset) )
+        return false;
+
+    framePosition = 0;
+
+    return true;
+}
+
+void WavFile::decode( const char *data, int count, float *samples ) const
+{
+    const uchar *d = reinterpret_cast<const uchar*>(data);
+
+    if( format == Float )
+    {
+        if( bits == 32 )
+        {
+            for( int i=0; i<count; i++ )
+            {
+                const quint32 value = readUInt32( data + i*4 );
+                memcpy( &samples[i], &value, 4 );
+            }
+        }
+        else
+        {
+            for( int i=0; i<count; i++ )
+            {
+                const quint64 value = readUInt32( data + i*8 ) | ( (quint64)readUInt32( data + i*8 + 4 ) << 32 );
+                double sample;
+                memcpy( &sample, &value, 8 );
+                samples[i] = sample;
+            }
+        }
+        return;
+    }
+
+    switch( bits )
+    {
+        case 8:
+            for( int i=0; i<count; i++ )
+                samples[i] = ( (int)d[i] - 128 ) * ( 1.0f / 128.0f );
+            break;
+        case 16:
+            for( int i=0; i<count; i++ )
+                samples[i] = (qint16)( d[i*2] | ( d[i*2+1] << 8 ) ) * ( 1.0f / 32768.0f );
+            break;
+        case 24:
+            for( int i=0; i<count; i++ )
+                samples[i] = ( (qint32)( ( d[i*3] << 8 ) | ( d[i*3+1] << 16 ) | ( (quint32)d[i*3+2] << 24 ) ) >> 8 ) * ( 1.0f / 8388608.0f );
+            break;
+        case 32:
+            for( int i=0; i<count; i++ )
+                samples[i] = (qint32)readUInt32( data + i*4 ) * ( 1.0f / 2147483648.0f );
+            break;
+    }
+}
+
+void WavFile::encode( const float *samples, int count, char *data ) const
+{
+    if( format == Float )
+    {
+        for( int i=0; i<count; i++ )
+        {
+            if( bits == 32 )
+            {
+                quint32 value;
+                memcpy( &value, &samples[i], 4 );
+                writeUInt32( data + i*4, value );
+            }
+            else
+            {
+                const double sample = samples[i];
+                quint64 value;
+                memcpy( &value, &sample, 8 );
+                writeUInt32( data + i*8, value );
+                writeUInt32( data + i*8 + 4, value >> 32 );
+            }
+        }
+        return;
+    }
+
+    const double scale = (double)( Q_INT64_C(1) << ( bits - 1 ) );
+    const qint64 maximum = Q_INT64_C(1) << ( bits - 1 );
+
+    for( int i=0; i<count; i++ )
+    {
+        const qint64 value = qBound( -maximum, (qint64)floor( samples[i] * scale + 0.5 ), maximum - 1 );
+
+        switch( bits )
+        {
+            case 8:
+                data[i] = value + 128;
+                break;
+            case 16:
+                writeUInt16( data + i*2, value );
+                break;
+            case 24:
+                data[i*3] = value;
+                data[i*3+1] = value >> 8;
+                data[i*3+2] = value >> 16;
+                break;
+            case 32:
+                writeUInt32( data + i*4, value );
+                break;
+        }
+    }
+}
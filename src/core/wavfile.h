@@ -0,0 +1,99 @@
+
+#ifndef WAVFILE_H
+#define WAVFILE_H
+
+#include <KGenericFactory>
+#include <QFile>
+
+
+/**
+ * @short Reads and writes the samples of wav files for filters that process audio without an external backend
+ *
+ * The samples are converted from and to interleaved floats in the range -1 to 1, integer
+ * samples get clipped and rounded while writing.
+ */
+class KDE_EXPORT WavFile
+{
+public:
+    enum SampleFormat
+    {
+        Integer,
+        Float
+    };
+
+    /** The speaker positions of the channel mask of WAVE_FORMAT_EXTENSIBLE */
+    enum Speaker
+    {
+        FrontLeft           = 0x1,
+        FrontRight          = 0x2,
+        FrontCenter         = 0x4,
+        LowFrequency        = 0x8,
+        BackLeft            = 0x10,
+        BackRight           = 0x20,
+        FrontLeftOfCenter   = 0x40,
+        FrontRightOfCenter  = 0x80,
+        BackCenter          = 0x100,
+        SideLeft            = 0x200,
+        SideRight           = 0x400,
+        TopCenter           = 0x800,
+        TopFrontLeft        = 0x1000,
+        TopFrontCenter      = 0x2000,
+        TopFrontRight       = 0x4000,
+        TopBackLeft         = 0x8000,
+        TopBackCenter       = 0x10000,
+        TopBackRight        = 0x20000
+    };
+
+    WavFile();
+    ~WavFile();
+
+    /** Opens @p fileName for reading, returns false if it isn't a wav file with a supported sample format */
+    bool openRead( const QString& fileName );
+    /** Creates @p fileName, the sizes in the header get written by close() */
+    bool openWrite( const QString& fileName, int sampleRate, int channels, int bitsPerSample, SampleFormat sampleFormat );
+    /** Finishes the header when writing, returns false if writing failed */
+    bool close();
+
+    /** Reads up to @p count frames into @p samples, returns the number of frames read or -1 on error */
+    int read( float *samples, int count );
+    /** Reads up to @p count frames without converting them, returns the number of frames read or -1 on error */
+    int readRaw( char *data, int count );
+    /** Writes @p count frames from @p samples */
+    bool write( const float *samples, int count );
+    /** Jumps back to the first frame of a file opened for reading */
+    bool rewind();
+
+    int sampleRate() const { return rate; }
+    int channels() const { return channelCount; }
+    int bitsPerSample() const { return bits; }
+    SampleFormat sampleFormat() const { return format; }
+    /** The speaker positions of the channels in the order they are stored, guessed from the number of channels if the file doesn't tell */
+    quint32 channelMask() const { return mask; }
+    /** The channel layout flac and vorbis use for @p channels channels */
+    static quint32 defaultChannelMask( int channels );
+    /** The number of frames in a file opened for reading */
+    qint64 frameCount() const { return frames; }
+    /** The number of frames read or written so far */
+    qint64 position() const { return framePosition; }
+
+private:
+    void decode( const char *data, int count, float *samples ) const;
+    void encode( const float *samples, int count, char *data ) const;
+
+    QFile file;
+    bool writing;
+
+    int rate;
+    int channelCount;
+    int bits;
+    SampleFormat format;
+    quint32 mask;
+
+    qint64 dataOffset;
+    qint64 frames;
+    qint64 framePosition;
+
+    QByteArray buffer;
+};
+
+#endif // WAVFILE_H
@@ -8,6 +8,10 @@
 #include "core/conversionoptions.h"
 #include "outputdirectory.h"
 #include "codecproblems.h"
+#include "concurrencycontroller.h"
+#include "convert.h"
+#include "pluginloader.h"
+#include "timemodel.h"
 
 #include <KApplication>
 #include <KIcon>
@@ -32,6 +36,27 @@
 #include <QProgressBar>
 
 
+namespace
+{
+    /** A file or all files of an album that must be converted together for album gain */
+    struct ConversionGroup
+    {
+        QList<FileListItem*> items;
+        float cost;
+        /** being converted or ripped from a disc, these keep their order */
+        bool fixed;
+    };
+
+    bool conversionGroupLessThan( const ConversionGroup& group1, const ConversionGroup& group2 )
+    {
+        if( group1.fixed != group2.fixed )
+            return group1.fixed;
+
+        return !group1.fixed && group1.cost > group2.cost;
+    }
+}
+
+
 FileList::FileList( Logger *_logger, Config *_config, QWidget *parent )
     : QTreeWidget( parent ),
     logger( _logger ),
@@ -39,8 +64,14 @@ FileList::FileList( Logger *_logger, Config *_config, QWidget *parent )
 {
     queue = false;
     optionsEditor = 0;
+    convert = 0;
     tagEngine = config->tagEngine();
 
+    concurrencyController = new ConcurrencyController( logger, this );
+    connect( concurrencyController, SIGNAL(limitChanged(int)), this, SLOT(concurrencyLimitChanged(int)) );
+
+    connect( config->mirrorManifest(), SIGNAL(verified(const QString&,const QByteArray&,bool)), this, SLOT(mirrorSourceVerified(const QString&,const QByteArray&,bool)) );
+
     setAcceptDrops( true );
     setDragEnabled( false );
 
@@ -306,9 +337,38 @@ int FileList::listDir( const QString& directory, const QStringList& filter, bool
         {
             count++;
 
-            codecName = config->pluginLoader()->getCodecFromFile( directory + "/" + fileName, 0, checkM4a );
+            if( !scanFingerprint.isEmpty() )
+            {
+                scanSeenFiles.insert( QDir::cleanPath(fileInfo.absoluteFilePath()) );
+            }
 
-            if( filter.contains(codecName) )
+            const MirrorManifest::State mirrorState = scanFingerprint.isEmpty() ? MirrorManifest::Changed : config->mirrorManifest()->state( fileInfo, scanFingerprint );
+            if( mirrorState == MirrorManifest::TimeStampChanged )
+            {
+                // the file gets added in mirrorSourceVerified() if its content has changed
+                const QString sourcePath = QDir::cleanPath( fileInfo.absoluteFilePath() );
+                const QString key = QString::fromLatin1( scanFingerprint ) + sourcePath;
+                if( !mirrorVerifications.contains(key) )
+                {
+                    MirrorVerification verification;
+                    verification.filter = filter;
+                    verification.checkM4a = checkM4a;
+                    verification.conversionOptionsId = config->conversionOptionsManager()->increaseReferences( conversionOptionsId );
+                    mirrorVerifications.insert( key, verification );
+                    config->mirrorManifest()->verify( sourcePath, scanFingerprint );
+                }
+                codecName.clear();
+            }
+            else if( mirrorState == MirrorManifest::UpToDate )
+            {
+                codecName.clear();
+            }
+            else
+            {
+                codecName = config->pluginLoader()->getCodecFromFile( directory + "/" + fileName, 0, checkM4a );
+            }
+
+            if( !codecName.isEmpty() && filter.contains(codecName) )
             {
                 addFiles( KUrl(directory + "/" + fileName), 0, "", codecName, conversionOptionsId );
             }
@@ -409,7 +469,12 @@ void FileList::addFiles( const KUrl::List& fileList, ConversionOptions *conversi
         }
         else
         {
-            newItem->length = ( newItem->tags && newItem->tags->length > 0 ) ? newItem->tags->length : 200.0f;
+            if( newItem->tags && newItem->tags->length > 0 )
+                newItem->length = newItem->tags->length;
+            else if( newItem->local )
+                newItem->length = TimeModel::estimateLength( QFileInfo(newItem->url.toLocalFile()).size(), config->pluginLoader()->isCodecLossless(newItem->codecName) );
+            else
+                newItem->length = 200.0f;
         }
         newItem->notifyCommand = command;
 
@@ -452,8 +517,48 @@ void FileList::addDir( const KUrl& directory, bool recursive, const QStringList&
     pScanStatus->setMaximum( count );
     kapp->processEvents();
 
+    if( config->data.general.mirrorSync && directory.isLocalFile() )
+    {
+        scanFingerprint = MirrorManifest::fingerprint( config->conversionOptionsManager()->getConversionOptions(conversionOptionsId) );
+        scanSeenFiles.clear();
+    }
+
     listDir( directory.toLocalFile(), codecList, recursive, conversionOptionsId );
 
+    // only a recursive scan has seen all files below the directory
+    if( !scanFingerprint.isEmpty() && recursive )
+    {
+        MirrorManifest *mirrorManifest = config->mirrorManifest();
+        const QList< QPair<QString,QString> > orphans = mirrorManifest->orphans( directory.toLocalFile(), scanFingerprint, scanSeenFiles );
+        for( int i=0; i<orphans.count(); i++ )
+        {
+            if( config->data.general.mirrorRemoveOrphans )
+            {
+                if( mirrorManifest->isOutputUsed(orphans.at(i).second,orphans.at(i).first) )
+                {
+                    // another source file has been converted to the same path
+                    mirrorManifest->remove( orphans.at(i).first, scanFingerprint );
+                }
+                else if( !QFile::exists(orphans.at(i).second) || QFile::remove(orphans.at(i).second) )
+                {
+                    logger->log( 1000, i18n("Removed output file of deleted source file %1: %2",orphans.at(i).first,orphans.at(i).second) );
+                    mirrorManifest->remove( orphans.at(i).first, scanFingerprint );
+                }
+                else
+                {
+                    logger->log( 1000, i18n("Could not remove output file of deleted source file %1: %2",orphans.at(i).first,orphans.at(i).second) );
+                }
+            }
+            else
+            {
+                logger->log( 1000, i18n("Source file %1 has been deleted, its output file %2 is kept",orphans.at(i).first,orphans.at(i).second) );
+            }
+        }
+        mirrorManifest->save();
+    }
+    scanFingerprint.clear();
+    scanSeenFiles.clear();
+
     pScanStatus->hide(); // hide the status bar, when the scan is done
 
     emit fileCountChanged( topLevelItemCount() );
@@ -462,7 +567,7 @@ void FileList::addDir( const KUrl& directory, bool recursive, const QStringList&
         convertNextItem();
 }
 
-void FileList::addTracks( const QString& device, QList<int> trackList, int tracks, QList<TagData*> tagList, ConversionOptions *conversionOptions, const QString& notifyCommand )
+void FileList::addTracks( const QString& device, QList<int> trackList, int tracks, QList<int> discOffsets, QList<TagData*> tagList, ConversionOptions *conversionOptions, const QString& notifyCommand )
 {
     FileListItem *lastListItem = 0;
 
@@ -489,6 +594,7 @@ void FileList::addTracks( const QString& device, QList<int> trackList, int track
         newItem->track = trackList.at(i);
         newItem->tracks = tracks;
         newItem->device = device;
+        newItem->discOffsets = discOffsets;
         newItem->tags = tagList.at(i);
         newItem->length = newItem->tags ? newItem->tags->length : 200.0f;
         addTopLevelItem( newItem );
@@ -700,6 +806,9 @@ void FileList::updateAllItems()
 
 void FileList::startConversion()
 {
+    // the time model might have learned new speeds since the last run
+    costFactors.clear();
+
     // iterate through all items and set the state to "Waiting"
     for( int i=0; i<topLevelItemCount(); i++ )
     {
@@ -733,6 +842,9 @@ void FileList::startConversion()
         }
     }
 
+    if( config->data.general.adaptiveNumFiles && !concurrencyController->isRunning() )
+        concurrencyController->start( config->data.general.numFiles );
+
     queue = true;
     emit queueModeChanged( queue );
     emit conversionStarted();
@@ -744,6 +856,8 @@ void FileList::killConversion()
     queue = false;
     emit queueModeChanged( queue );
 
+    concurrencyController->stop();
+
     for( int i=0; i<topLevelItemCount(); i++ )
     {
         FileListItem *item = topLevelItem( i );
@@ -799,45 +913,211 @@ void FileList::convertNextItem()
     bool callItemsSelected = false;
     QStringList devices;
 
-    // look for tracks that are being ripped
+    // tracks that are ripped through a pipe are being converted at the same time, so ask Convert for the busy drives
+    if( convert )
+        devices = convert->busyDevices();
+
+    // reading from a drive doesn't take a slot from the encoders
     for( int i=0; i<topLevelItemCount(); i++ )
     {
         FileListItem *item = topLevelItem( i );
         if( item->state == FileListItem::Ripping )
+            count--;
+    }
+
+    const int maxCount = numFiles();
+    const QList<FileListItem*> order = conversionOrder();
+
+    // every drive rips its tracks on its own, the next track gets started by rippingFinished()
+    for( int i=0; i<order.count(); i++ )
+    {
+        FileListItem *item = order.at( i );
+        if( item->state == FileListItem::WaitingForConversion && item->track >= 0 && !devices.contains(item->device) )
         {
             devices += item->device;
+            emit convertItem( item );
+            if( selectedFiles.contains(item) )
+                callItemsSelected = true;
         }
     }
 
     // look for waiting files
-    for( int i=0; i<topLevelItemCount() && count < config->data.general.numFiles; i++ )
+    for( int i=0; i<order.count() && count < maxCount; i++ )
+    {
+        FileListItem *item = order.at( i );
+        if( item->state == FileListItem::WaitingForConversion && item->track < 0 )
+        {
+            count++;
+            emit convertItem( item );
+            if( selectedFiles.contains(item) )
+                callItemsSelected = true;
+        }
+    }
+
+    if( callItemsSelected )
+        itemsSelected();
+
+    concurrencyController->setRunningCount( count );
+
+    emit expectedSpeedChanged( expectedSpeed() );
+
+    // let the remote files of the next items get downloaded in the meantime
+    QList<FileListItem*> nextItems;
+    for( int i=0; i<order.count() && nextItems.count() < 2 * maxCount; i++ )
+    {
+        FileListItem *item = order.at( i );
+        if( item->state == FileListItem::WaitingForConversion && !item->local && item->track < 0 )
+            nextItems.append( item );
+    }
+    emit prefetchItems( nextItems );
+
+    if( count == 0 && devices.isEmpty() )
+        itemFinished( 0, FileListItem::Succeeded );
+}
+
+QList<FileListItem*> FileList::conversionOrder()
+{
+    QList<FileListItem*> order;
+
+    if( !config->data.general.longestFilesFirst )
+    {
+        for( int i=0; i<topLevelItemCount(); i++ )
+            order.append( topLevelItem(i) );
+
+        return order;
+    }
+
+    // files of the same album are next to each other, see waitForAlbumGain()
+    QList<ConversionGroup> groups;
+    QString lastAlbum;
+    for( int i=0; i<topLevelItemCount(); i++ )
     {
         FileListItem *item = topLevelItem( i );
+        const ConversionOptions *conversionOptions = config->conversionOptionsManager()->getConversionOptions( item->conversionOptionsId );
+
+        QString album;
+        if( config->data.general.waitForAlbumGain && item->tags && conversionOptions && conversionOptions->replaygain )
+            album = item->tags->album;
+
+        if( album.isEmpty() || album != lastAlbum || groups.isEmpty() )
+        {
+            ConversionGroup group;
+            group.cost = 0.0f;
+            group.fixed = false;
+            groups.append( group );
+        }
+        lastAlbum = album;
+
+        ConversionGroup& group = groups.last();
+        group.items.append( item );
         if( item->state == FileListItem::WaitingForConversion )
+            group.cost += conversionCost( item );
+
+        // the tracks of a disc get ripped one after another
+        if( ( item->state != FileListItem::WaitingForConversion && item->state != FileListItem::Stopped ) || item->track >= 0 )
+            group.fixed = true;
+    }
+
+    // albums that have been started get finished first, so their album gain isn't delayed
+    qStableSort( groups.begin(), groups.end(), conversionGroupLessThan );
+
+    foreach( const ConversionGroup& group, groups )
+        order += group.items;
+
+    return order;
+}
+
+float FileList::conversionCost( FileListItem *item )
+{
+    const QString key = item->codecName + ":" + QString::number(item->conversionOptionsId);
+
+    if( !costFactors.contains(key) )
+    {
+        float factor = 0.0f;
+
+        const ConversionOptions *conversionOptions = config->conversionOptionsManager()->getConversionOptions( item->conversionOptionsId );
+        if( conversionOptions )
         {
-            if( item->track >= 0 && !devices.contains(item->device) )
-            {
-                count++;
-                devices += item->device;
-                emit convertItem( item );
-                if( selectedFiles.contains(item) )
-                    callItemsSelected = true;
-            }
-            else if( item->track < 0 )
+            const QList<ConversionPipe> conversionPipes = config->pluginLoader()->getConversionPipes( item->codecName, conversionOptions->codecName, conversionOptions->filterOptions, conversionOptions->pluginName );
+            if( !conversionPipes.isEmpty() )
             {
-                count++;
-                emit convertItem( item );
-                if( selectedFiles.contains(item) )
-                    callItemsSelected = true;
+                foreach( const ConversionPipeTrunk& trunk, conversionPipes.first().trunks )
+                    factor += config->timeModel()->stageFactor( TimeModel::stageKey(trunk,conversionOptions), TimeModel::DefaultFactor );
             }
         }
+
+        costFactors.insert( key, factor > 0.0f ? factor : TimeModel::DefaultFactor );
     }
 
-    if( callItemsSelected )
-        itemsSelected();
+    return item->length * costFactors.value( key );
+}
 
-    if( count == 0 )
-        itemFinished( 0, FileListItem::Succeeded );
+float FileList::expectedSpeed()
+{
+    float length = 0.0f;
+    float cost = 0.0f;
+
+    for( int i=0; i<topLevelItemCount(); i++ )
+    {
+        FileListItem *item = topLevelItem( i );
+        if( item->state == FileListItem::WaitingForConversion || item->state == FileListItem::Ripping || item->state == FileListItem::Converting )
+        {
+            length += item->length;
+            cost += conversionCost( item );
+        }
+    }
+
+    if( cost <= 0.0f )
+        return 0.0f;
+
+    // the stage times have been measured while converting in parallel, so they don't need to be scaled
+    return length / ( cost / numFiles() );
+}
+
+int FileList::numFiles()
+{
+    if( config->data.general.adaptiveNumFiles && concurrencyController->isRunning() )
+        return concurrencyController->limit();
+
+    return config->data.general.numFiles;
+}
+
+void FileList::concurrencyLimitChanged( int limit )
+{
+    Q_UNUSED(limit)
+
+    // start more files if the limit has been raised, a lowered limit takes effect when the running files are finished
+    convertNextItem();
+}
+
+void FileList::mirrorSourceVerified( const QString& sourcePath, const QByteArray& fingerprint, bool upToDate )
+{
+    const QString key = QString::fromLatin1( fingerprint ) + sourcePath;
+    if( !mirrorVerifications.contains(key) )
+        return;
+
+    const MirrorVerification verification = mirrorVerifications.take( key );
+
+    if( !upToDate )
+    {
+        const QString codecName = config->pluginLoader()->getCodecFromFile( sourcePath, 0, verification.checkM4a );
+        if( !codecName.isEmpty() && verification.filter.contains(codecName) )
+        {
+            addFiles( KUrl(sourcePath), 0, "", codecName, verification.conversionOptionsId );
+
+            emit fileCountChanged( topLevelItemCount() );
+
+            if( queue )
+                convertNextItem();
+        }
+    }
+
+    config->conversionOptionsManager()->removeConversionOptions( verification.conversionOptionsId );
+}
+
+int FileList::queuedCount()
+{
+    return queue ? waitingCount() : 0;
 }
 
 int FileList::waitingCount()
@@ -954,7 +1234,10 @@ void FileList::itemFinished( FileListItem *item, FileListItem::ReturnCode return
     else if( convertingCount(true) == 0 )
     {
         queue = false;
+        concurrencyController->stop();
         save( false );
+        config->mirrorManifest()->save();
+        config->timeModel()->save();
         emit queueModeChanged( queue );
 //         float time = 0;
 //         for( int i=0; i<topLevelItemCount(); i++ )
@@ -1453,6 +1736,8 @@ void FileList::load( const QString& fileListPath )
                     item->track = file.attribute("track").toInt();
                     item->tracks = file.attribute("tracks").toInt();
                     item->device = file.attribute("device");
+                    foreach( const QString& offset, file.attribute("discOffsets").split(",",QString::SkipEmptyParts) )
+                        item->discOffsets.append( offset.toInt() );
                     item->length = file.attribute("time").toInt();
                     item->notifyCommand = file.attribute("notifyCommand");
                     if( conversionOptionsReferences[item->conversionOptionsId] != 0 )
@@ -1538,6 +1823,10 @@ void FileList::save( bool user )
         file.setAttribute("track",item->track);
         file.setAttribute("tracks",item->tracks);
         file.setAttribute("device",item->device);
+        QStringList discOffsets;
+        foreach( int offset, item->discOffsets )
+            discOffsets.append( QString::number(offset) );
+        file.setAttribute("discOffsets",discOffsets.join(","));
         file.setAttribute("time",item->length);
         file.setAttribute("notifyCommand",item->notifyCommand);
         root.appendChild(file);
@@ -7,6 +7,8 @@
 #include "filelistitem.h"
 
 #include <QTime>
+#include <QSet>
+#include <QHash>
 // #include <QDebug>
 
 class FileListItem;
@@ -20,6 +22,8 @@ class ConversionOptions;
 class QMenu;
 class KAction;
 class QProgressBar;
+class ConcurrencyController;
+class Convert;
 
 /**
  * @short The file list
@@ -46,6 +50,7 @@ public:
     FileListItem *topLevelItem( int index ) const { return static_cast<FileListItem*>( QTreeWidget::topLevelItem(index) ); }
 
     void setOptionsLayer( OptionsLayer *_optionsLayer ) { optionsLayer = _optionsLayer; }
+    void setConvert( Convert *_convert ) { convert = _convert; }
 
     void load( bool user = false );
     void load( const QString& fileListPath );
@@ -54,6 +59,11 @@ public:
 
     bool waitForAlbumGain( FileListItem *item );
 
+    /** The number of files that are still going to be started in this run */
+    int queuedCount();
+    /** The number of files to convert at once */
+    int numFiles();
+
 private:
     /** Counts all files in a directory */
     int countDir( const QString& directory, bool recursive, int count = 0 );
@@ -63,12 +73,32 @@ private:
     QProgressBar *pScanStatus;
     /** Update timer for the scan status */
     QTime tScanStatus;
+    /** The conversion options fingerprint of the current directory scan if the mirror mode is enabled */
+    QByteArray scanFingerprint;
+    /** All source files that have been found during the current directory scan, used to find orphaned output files */
+    QSet<QString> scanSeenFiles;
+    struct MirrorVerification
+    {
+        QStringList filter;
+        bool checkM4a;
+        int conversionOptionsId;
+    };
+    /** Source files whose time stamp has changed and whose content is being compared by the mirror manifest, QHash< fingerprint + source path, scan options > */
+    QHash<QString,MirrorVerification> mirrorVerifications;
 
 // debug
 //     int TimeCount;
 //     QTime Time;
 
     void convertNextItem();
+    /** Returns all items in the order they should be converted */
+    QList<FileListItem*> conversionOrder();
+    /** Estimates the time needed for converting @p item from its length and the speeds learned by the time model */
+    float conversionCost( FileListItem *item );
+    /** QHash< codec and conversion options id, wall time per second of audio > */
+    QHash<QString,float> costFactors;
+    /** Returns the expected number of audio seconds converted per second for the remaining files, 0 if there are none */
+    float expectedSpeed();
     int waitingCount();
     int convertingCount( bool includeWaiting = false );
 
@@ -84,11 +114,15 @@ private:
 
     bool queue;
 
+    /** Adjusts the number of files to convert at once if enabled */
+    ConcurrencyController *concurrencyController;
+
     Logger *logger;
     Config *config;
     TagEngine *tagEngine;
     OptionsEditor *optionsEditor;
     OptionsLayer *optionsLayer;
+    Convert *convert;
 
     QMenu *contextMenu;
     KAction *editAction;
@@ -112,11 +146,17 @@ private slots:
 
     void showLogClicked( const QString& logIdString );
 
+    // connected to ConcurrencyController
+    void concurrencyLimitChanged( int limit );
+
+    // connected to MirrorManifest
+    void mirrorSourceVerified( const QString& sourcePath, const QByteArray& fingerprint, bool upToDate );
+
 public slots:
     // connected to soundKonverterView
     void addFiles( const KUrl::List& fileList, ConversionOptions *conversionOptions, const QString& notifyCommand = "", const QString& _codecName = "", int conversionOptionsId = -1 );
     void addDir( const KUrl& directory, bool recursive, const QStringList& codecList, ConversionOptions *conversionOptions );
-    void addTracks( const QString& device, QList<int> trackList, int tracks, QList<TagData*> tagList, ConversionOptions *conversionOptions, const QString& notifyCommand = "" );
+    void addTracks( const QString& device, QList<int> trackList, int tracks, QList<int> discOffsets, QList<TagData*> tagList, ConversionOptions *conversionOptions, const QString& notifyCommand = "" );
     void startConversion();
     void killConversion();
     void stopConversion();
@@ -133,6 +173,7 @@ public slots:
 signals:
     // connected to ProgressIndicator
     void timeChanged( float timeDelta );
+    void expectedSpeedChanged( float speed );
     void finished( bool );
     // connected to soundKonverterView
     void fileCountChanged( int count );
@@ -146,6 +187,8 @@ signals:
 
     // connected to Convert
     void convertItem( FileListItem* );
+    /** The given items are the next ones in the queue */
+    void prefetchItems( const QList<FileListItem*>& );
     void killItem( FileListItem* );
     void replaygainItems( QList<FileListItem*> );
 
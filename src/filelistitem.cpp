@@ -16,6 +16,12 @@ FileListItem::FileListItem( QTreeWidget *parent, QTreeWidgetItem *after )
     track = -1;
     tracks = 0;
 
+    ripVerification = NotVerified;
+    ripConfidence = 0;
+    ripCrc32 = 0;
+    accurateRipV1 = 0;
+    accurateRipV2 = 0;
+
     length = 0;
 
     logId = -1;
@@ -33,6 +39,12 @@ FileListItem::FileListItem( QTreeWidget *parent )
     track = -1;
     tracks = 0;
 
+    ripVerification = NotVerified;
+    ripConfidence = 0;
+    ripCrc32 = 0;
+    accurateRipV1 = 0;
+    accurateRipV2 = 0;
+
     length = 0;
 
     logId = -1;
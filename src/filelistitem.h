@@ -41,6 +41,14 @@ public:
         Failed                          = 6
     };
 
+    enum RipVerification {
+        NotVerified,
+        NotInDatabase,
+        AccuratelyRipped,
+        NotAccuratelyRipped,
+        ReadOffsetUnknown
+    };
+
     explicit FileListItem( QTreeWidget *parent );
     FileListItem( QTreeWidget *parent, QTreeWidgetItem *after );
     ~FileListItem();
@@ -58,6 +66,13 @@ public:
                                 // if it is lower than 0, it isn't an audio cd track at all
     int tracks;                 // the total amount of tracks on the cd
     QString device;             // the device of the audio cd
+    QList<int> discOffsets;     // the start sectors of the audio tracks (+150) and the lead-out, used for the AccurateRip lookup, empty for discs with data tracks
+
+    RipVerification ripVerification;    // the result of the AccurateRip lookup after the track has been ripped
+    int ripConfidence;                  // the number of rips in the AccurateRip database with the same checksum
+    quint32 ripCrc32;                   // the checksums of the ripped audio data
+    quint32 accurateRipV1;
+    quint32 accurateRipV2;
 
     float length;               // the length of the track, used for the calculation of the progress bar
     QString notifyCommand;      // execute this command, when the file is converted (%i=input file, %o=output file)
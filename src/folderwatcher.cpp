@@ -0,0 +1,204 @@
+
+#include "folderwatcher.h"
+#include "config.h"
+#include "logger.h"
+
+#include <KLocale>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QTimer>
+
+
+// the time in ms a new file must not change before it gets converted
+#define SettleDelay 2000
+// the time in s an output file is ignored, if it doesn't appear within it the conversion has failed
+#define IgnoreTimeout (24*60*60)
+
+
+FolderWatcher::FolderWatcher( Config *_config, Logger *_logger, QObject *parent )
+    : QObject( parent ),
+    config( _config ),
+    logger( _logger )
+{
+    watcher = new QFileSystemWatcher( this );
+    connect( watcher, SIGNAL(directoryChanged(const QString&)), this, SLOT(directoryChanged(const QString&)) );
+
+    settleTimer = new QTimer( this );
+    settleTimer->setSingleShot( true );
+    connect( settleTimer, SIGNAL(timeout()), this, SLOT(checkPendingFiles()) );
+}
+
+FolderWatcher::~FolderWatcher()
+{}
+
+void FolderWatcher::addDirectory( const QString& directory )
+{
+    const QString path = QDir::cleanPath( QFileInfo(directory).absoluteFilePath() );
+
+    if( !QFileInfo(path).isDir() )
+    {
+        logger->log( 1000, i18n("Cannot watch \"%1\", it's not a directory",path) );
+        return;
+    }
+
+    if( watchedDirectories.contains(path) )
+        return;
+
+    watchedDirectories.append( path );
+    logger->log( 1000, i18n("Watching directory \"%1\" for new files",path) );
+
+    scanDirectory( path, true );
+}
+
+void FolderWatcher::setExcludedDirectory( const QString& directory )
+{
+    excludedDirectory = directory.isEmpty() ? QString() : QDir::cleanPath( QFileInfo(directory).absoluteFilePath() );
+}
+
+void FolderWatcher::ignoreFile( const QString& path )
+{
+    const QDateTime now = QDateTime::currentDateTime();
+
+    QHash<QString,QDateTime>::iterator it = ignoredFiles.begin();
+    while( it != ignoredFiles.end() )
+    {
+        if( it.value().secsTo(now) > IgnoreTimeout )
+            it = ignoredFiles.erase( it );
+        else
+            ++it;
+    }
+
+    ignoredFiles.insert( QDir::cleanPath(path), now );
+}
+
+bool FolderWatcher::isExcluded( const QString& path ) const
+{
+    return !excludedDirectory.isEmpty() && ( path == excludedDirectory || path.startsWith(excludedDirectory + "/") );
+}
+
+void FolderWatcher::scanDirectory( const QString& directory, bool initial )
+{
+    QDir dir( directory );
+    dir.setFilter( QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot | QDir::Readable );
+
+    if( !dir.exists() )
+    {
+        // the directory has been removed, QFileSystemWatcher removes the watch by itself
+        knownEntries.remove( directory );
+        return;
+    }
+
+    if( !knownEntries.contains(directory) )
+        watcher->addPath( directory );
+
+    QSet<QString>& known = knownEntries[directory];
+    QSet<QString> current;
+
+    foreach( const QString& fileName, dir.entryList() )
+    {
+        current.insert( fileName );
+
+        if( known.contains(fileName) )
+            continue;
+
+        const QString path = directory + "/" + fileName;
+        if( isExcluded(path) )
+            continue;
+
+        QFileInfo fileInfo( path );
+        if( fileInfo.isDir() )
+        {
+            // files in a new sub directory are new files as well
+            scanDirectory( path, initial );
+        }
+        else if( !initial && !fileName.startsWith(".") ) // e.g. temporary files of rsync
+        {
+            PendingFile pendingFile;
+            pendingFile.size = fileInfo.size();
+            pendingFile.modified = fileInfo.lastModified();
+            pendingFile.unchanged.start();
+            pendingFiles.insert( path, pendingFile );
+        }
+    }
+
+    known = current;
+
+    if( !pendingFiles.isEmpty() && !settleTimer->isActive() )
+        settleTimer->start( SettleDelay );
+}
+
+void FolderWatcher::directoryChanged( const QString& directory )
+{
+    scanDirectory( directory, false );
+}
+
+void FolderWatcher::checkPendingFiles()
+{
+    KUrl::List urls;
+    QStringList codecNames;
+
+    const bool canDecodeAac = config->pluginLoader()->canDecode( "m4a/aac" );
+    const bool canDecodeAlac = config->pluginLoader()->canDecode( "m4a/alac" );
+    const bool checkM4a = ( !canDecodeAac || !canDecodeAlac ) && canDecodeAac != canDecodeAlac;
+
+    // the time until the next pending file might be settled
+    qint64 nextCheck = SettleDelay;
+
+    QHash<QString,PendingFile>::iterator it = pendingFiles.begin();
+    while( it != pendingFiles.end() )
+    {
+        QFileInfo fileInfo( it.key() );
+        if( !fileInfo.exists() )
+        {
+            it = pendingFiles.erase( it );
+            continue;
+        }
+
+        // converted files must not get converted again
+        if( ignoredFiles.remove(it.key()) > 0 )
+        {
+            it = pendingFiles.erase( it );
+            continue;
+        }
+
+        if( fileInfo.size() != it.value().size || fileInfo.lastModified() != it.value().modified )
+        {
+            // still being written, check again later
+            it.value().size = fileInfo.size();
+            it.value().modified = fileInfo.lastModified();
+            it.value().unchanged.start();
+            ++it;
+            continue;
+        }
+
+        // every file needs to be unchanged for the whole delay, e.g. a network copy might just be stalled
+        const qint64 unchangedTime = it.value().unchanged.elapsed();
+        if( unchangedTime < SettleDelay )
+        {
+            nextCheck = qMin( nextCheck, SettleDelay - unchangedTime );
+            ++it;
+            continue;
+        }
+
+        const QString codecName = config->pluginLoader()->getCodecFromFile( KUrl(it.key()), 0, checkM4a );
+        if( config->pluginLoader()->canDecode(codecName) )
+        {
+            urls.append( KUrl(it.key()) );
+            codecNames.append( codecName );
+        }
+
+        it = pendingFiles.erase( it );
+    }
+
+    if( !pendingFiles.isEmpty() )
+        settleTimer->start( nextCheck );
+
+    if( !urls.isEmpty() )
+    {
+        logger->log( 1000, i18np("Adding 1 new file from the watched directories","Adding %1 new files from the watched directories",urls.count()) );
+        emit filesReady( urls, codecNames );
+    }
+}
@@ -0,0 +1,85 @@
+
+#ifndef FOLDERWATCHER_H
+#define FOLDERWATCHER_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <KUrl>
+
+class Config;
+class Logger;
+class QFileSystemWatcher;
+class QTimer;
+
+
+/**
+ * @short Watches directories and reports new audio files once they have been written completely
+ *
+ * The directories are watched with QFileSystemWatcher (inotify on Linux), so nothing
+ * is polled while no files arrive. New files are only reported after their size and
+ * modification time haven't changed for a while, so files that are still being
+ * copied into the directory don't get converted half way.
+ */
+class FolderWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    FolderWatcher( Config *_config, Logger *_logger, QObject *parent );
+    ~FolderWatcher();
+
+    /** Starts watching @p directory and all its sub directories, files that already exist are ignored */
+    void addDirectory( const QString& directory );
+
+    QStringList directories() const { return watchedDirectories; }
+
+    /** Files in @p directory and its sub directories are never reported, e.g. because the converted files are written there */
+    void setExcludedDirectory( const QString& directory );
+
+public slots:
+    /** @p path won't be reported when it appears, e.g. because it is a converted file */
+    void ignoreFile( const QString& path );
+
+signals:
+    /** @p urls have been added to a watched directory and aren't written to anymore, @p codecNames are their codecs */
+    void filesReady( const KUrl::List& urls, const QStringList& codecNames );
+
+private slots:
+    void directoryChanged( const QString& directory );
+    void checkPendingFiles();
+
+private:
+    struct PendingFile
+    {
+        qint64 size;
+        QDateTime modified;
+        /** measures the time since the size or the modification time has changed the last time */
+        QElapsedTimer unchanged;
+    };
+
+    /** Updates the known entries of @p directory, new files are added to the pending files if @p initial is false */
+    void scanDirectory( const QString& directory, bool initial );
+    bool isExcluded( const QString& path ) const;
+
+    Config *config;
+    Logger *logger;
+
+    QFileSystemWatcher *watcher;
+    /** Checks the pending files when the next one might be settled, only running while there are any */
+    QTimer *settleTimer;
+
+    QStringList watchedDirectories;
+    /** QHash< directory, file and sub directory names > */
+    QHash< QString, QSet<QString> > knownEntries;
+    /** files that have been added but might still be written */
+    QHash<QString,PendingFile> pendingFiles;
+
+    QString excludedDirectory;
+    /** QHash< file, time when it has been added >, old entries are dropped in case the file never appears */
+    QHash<QString,QDateTime> ignoredFiles;
+};
+
+#endif // FOLDERWATCHER_H
@@ -0,0 +1,357 @@
+
+#include "jobmetrics.h"
+#include "config.h"
+
+#include <KStandardDirs>
+
+#include <QDateTime>
+#include <QFile>
+#include <QHostAddress>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTextStream>
+
+#include <unistd.h>
+
+
+JobMetrics::JobMetrics( Config *_config, QObject *parent )
+    : QObject( parent ),
+    config( _config ),
+    server( 0 ),
+    serverPort( 0 )
+{
+    fileName = KStandardDirs::locateLocal( "data", "soundkonverter/metrics.jsonl" );
+
+    const long ticks = sysconf( _SC_CLK_TCK );
+    ticksPerSecond = ( ticks > 0 ) ? ticks : 100;
+
+    // the server must stop as soon as recording is disabled, not only with the next conversion
+    connect( config, SIGNAL(updateMetricsSettings()), this, SLOT(updateServer()) );
+
+    updateServer();
+}
+
+JobMetrics::~JobMetrics()
+{}
+
+bool JobMetrics::isEnabled() const
+{
+    return config->data.general.recordMetrics;
+}
+
+void JobMetrics::beginStage( int id, const QString& stage, const QString& backend )
+{
+    if( !isEnabled() )
+        return;
+
+    if( !jobs.contains(id) )
+    {
+        jobs[id].timer.start();
+        jobs[id].stageActive = false;
+    }
+
+    endStage( id );
+
+    Job& job = jobs[id];
+    job.stageActive = true;
+    job.stageTimer.start();
+    job.processSamples.clear();
+    job.currentStage.name = stage;
+    job.currentStage.backend = backend;
+    job.currentStage.wallTime = 0;
+    job.currentStage.userTime = 0.0;
+    job.currentStage.systemTime = 0.0;
+    job.currentStage.peakRss = 0;
+    job.currentStage.bytesRead = 0;
+    job.currentStage.bytesWritten = 0;
+}
+
+void JobMetrics::endStage( int id )
+{
+    if( !jobs.contains(id) || !jobs.value(id).stageActive )
+        return;
+
+    Job& job = jobs[id];
+    job.stageActive = false;
+
+    Stage& stage = job.currentStage;
+    stage.wallTime = job.stageTimer.elapsed();
+    foreach( const ProcessSample& processSample, job.processSamples )
+    {
+        stage.userTime += processSample.userTicks / ticksPerSecond;
+        stage.systemTime += processSample.systemTicks / ticksPerSecond;
+        // the processes of a pipe don't necessarily peak at the same time, so the sum would overstate the usage
+        stage.peakRss = qMax( stage.peakRss, processSample.peakRss );
+        stage.bytesRead += processSample.bytesRead;
+        stage.bytesWritten += processSample.bytesWritten;
+    }
+    job.processSamples.clear();
+    job.stages.append( stage );
+
+    Totals& total = totals[stage.name + "\t" + stage.backend];
+    total.count++;
+    total.wallTime += stage.wallTime / 1000.0;
+    total.userTime += stage.userTime;
+    total.systemTime += stage.systemTime;
+    total.peakRss = qMax( total.peakRss, stage.peakRss );
+    total.bytesRead += stage.bytesRead;
+    total.bytesWritten += stage.bytesWritten;
+}
+
+void JobMetrics::sample( int id, qint64 pid )
+{
+    if( !isEnabled() || pid <= 0 || !jobs.contains(id) || !jobs.value(id).stageActive )
+        return;
+
+    Job& job = jobs[id];
+
+    // the process might be a shell running a pipe, so sample all its children, too
+    QList<qint64> pids;
+    pids.append( pid );
+    for( int i=0; i<pids.count(); i++ )
+    {
+        pids += childProcesses( pids.at(i) );
+    }
+
+    foreach( const qint64 processId, pids )
+    {
+        ProcessSample processSample;
+        if( readProcess(processId,&processSample) )
+        {
+            // the counters only grow, so the last sample holds the final values (minus the last sample interval)
+            job.processSamples[processId] = processSample;
+        }
+    }
+}
+
+void JobMetrics::addTransferredBytes( int id, qint64 bytesRead, qint64 bytesWritten )
+{
+    if( !isEnabled() || !jobs.contains(id) || !jobs.value(id).stageActive )
+        return;
+
+    jobs[id].currentStage.bytesRead += bytesRead;
+    jobs[id].currentStage.bytesWritten += bytesWritten;
+}
+
+void JobMetrics::finishJob( int id, const QString& inputFile, const QString& outputFile, const QString& result )
+{
+    if( !jobs.contains(id) )
+        return;
+
+    endStage( id );
+
+    const Job job = jobs.take( id );
+
+    results[result]++;
+
+    QFile file( fileName );
+    if( file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text) )
+    {
+        QTextStream stream( &file );
+        stream.setCodec( "UTF-8" );
+        stream << toJson( job, inputFile, outputFile, result ) << "\n";
+    }
+}
+
+bool JobMetrics::readProcess( qint64 pid, ProcessSample *sample )
+{
+    const QString path = QString("/proc/%1/").arg(pid);
+
+    QFile statFile( path + "stat" );
+    if( !statFile.open(QIODevice::ReadOnly) )
+        return false;
+
+    // the process name can contain spaces, the fields start after the closing bracket
+    const QString stat = QString::fromLocal8Bit( statFile.readAll() );
+    const QStringList fields = stat.mid( stat.lastIndexOf(')') + 2 ).split( ' ' );
+    if( fields.count() < 13 )
+        return false;
+
+    sample->userTicks = fields.at(11).toLongLong();
+    sample->systemTicks = fields.at(12).toLongLong();
+    sample->peakRss = 0;
+    sample->bytesRead = 0;
+    sample->bytesWritten = 0;
+
+    QFile statusFile( path + "status" );
+    if( statusFile.open(QIODevice::ReadOnly) )
+    {
+        foreach( const QByteArray& line, statusFile.readAll().split('\n') )
+        {
+            if( line.startsWith("VmHWM:") )
+            {
+                sample->peakRss = line.mid(6).simplified().split(' ').first().toLongLong();
+                break;
+            }
+        }
+    }
+
+    QFile ioFile( path + "io" );
+    if( ioFile.open(QIODevice::ReadOnly) )
+    {
+        foreach( const QByteArray& line, ioFile.readAll().split('\n') )
+        {
+            if( line.startsWith("rchar:") )
+                sample->bytesRead = line.mid(6).trimmed().toLongLong();
+            else if( line.startsWith("wchar:") )
+                sample->bytesWritten = line.mid(6).trimmed().toLongLong();
+        }
+    }
+
+    return true;
+}
+
+QList<qint64> JobMetrics::childProcesses( qint64 pid )
+{
+    QList<qint64> children;
+
+    QFile file( QString("/proc/%1/task/%1/children").arg(pid) );
+    if( !file.open(QIODevice::ReadOnly) )
+        return children;
+
+    foreach( const QByteArray& child, file.readAll().simplified().split(' ') )
+    {
+        if( child.toLongLong() > 0 )
+            children.append( child.toLongLong() );
+    }
+
+    return children;
+}
+
+void JobMetrics::updateServer()
+{
+    const int port = isEnabled() ? config->data.general.metricsPort : 0;
+    if( port == serverPort )
+        return;
+
+    serverPort = port;
+
+    if( server )
+    {
+        server->close();
+        server->deleteLater();
+        server = 0;
+    }
+
+    if( serverPort > 0 )
+    {
+        server = new QTcpServer( this );
+        connect( server, SIGNAL(newConnection()), this, SLOT(newConnection()) );
+        // only serve local clients, there's no authentication
+        server->listen( QHostAddress::LocalHost, serverPort );
+    }
+}
+
+void JobMetrics::newConnection()
+{
+    while( server && server->hasPendingConnections() )
+    {
+        QTcpSocket *socket = server->nextPendingConnection();
+        connect( socket, SIGNAL(readyRead()), this, SLOT(readRequest()) );
+        connect( socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()) );
+    }
+}
+
+void JobMetrics::readRequest()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket*>( QObject::sender() );
+    if( !socket || !socket->canReadLine() )
+        return;
+
+    // every path returns the metrics
+    const QByteArray requestLine = socket->readLine();
+    socket->readAll();
+
+    QByteArray response;
+    if( requestLine.startsWith("GET ") )
+    {
+        const QByteArray body = prometheusText().toUtf8();
+        response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\nContent-Length: " + QByteArray::number(body.size()) + "\r\n\r\n" + body;
+    }
+    else
+    {
+        response = "HTTP/1.0 405 Method Not Allowed\r\nContent-Length: 0\r\n\r\n";
+    }
+
+    disconnect( socket, SIGNAL(readyRead()), this, SLOT(readRequest()) );
+    socket->write( response );
+    socket->disconnectFromHost();
+}
+
+static QString jsonString( QString string )
+{
+    string.replace( "\\", "\\\\" );
+    string.replace( "\"", "\\\"" );
+    string.replace( "\n", "\\n" );
+    string.replace( "\t", "\\t" );
+    return "\"" + string + "\"";
+}
+
+QString JobMetrics::toJson( const Job& job, const QString& inputFile, const QString& outputFile, const QString& result ) const
+{
+    QStringList stageList;
+    foreach( const Stage& stage, job.stages )
+    {
+        stageList.append( QString("{\"stage\":%1,\"backend\":%2,\"wall_ms\":%3,\"user_s\":%4,\"system_s\":%5,\"peak_rss_kib\":%6,\"read_bytes\":%7,\"written_bytes\":%8}")
+                          .arg(jsonString(stage.name)).arg(jsonString(stage.backend)).arg(stage.wallTime)
+                          .arg(stage.userTime,0,'f',2).arg(stage.systemTime,0,'f',2)
+                          .arg(stage.peakRss).arg(stage.bytesRead).arg(stage.bytesWritten) );
+    }
+
+    return QString("{\"finished\":%1,\"input\":%2,\"output\":%3,\"result\":%4,\"wall_ms\":%5,\"stages\":[%6]}")
+           .arg(jsonString(QDateTime::currentDateTime().toString(Qt::ISODate))).arg(jsonString(inputFile)).arg(jsonString(outputFile))
+           .arg(jsonString(result)).arg(job.timer.elapsed()).arg(stageList.join(","));
+}
+
+static QString labelValue( QString value )
+{
+    value.replace( "\\", "\\\\" );
+    value.replace( "\"", "\\\"" );
+    value.replace( "\n", "\\n" );
+    return "\"" + value + "\"";
+}
+
+QString JobMetrics::prometheusText() const
+{
+    QString text;
+    QTextStream stream( &text );
+
+    stream << "# HELP soundkonverter_jobs_total Finished conversion jobs by result.\n";
+    stream << "# TYPE soundkonverter_jobs_total counter\n";
+    for( QMap<QString,qint64>::const_iterator it = results.constBegin(); it != results.constEnd(); ++it )
+    {
+        stream << "soundkonverter_jobs_total{result=" << labelValue(it.key()) << "} " << it.value() << "\n";
+    }
+
+    stream << "# HELP soundkonverter_active_jobs Jobs that are being converted.\n";
+    stream << "# TYPE soundkonverter_active_jobs gauge\n";
+    stream << "soundkonverter_active_jobs " << jobs.count() << "\n";
+
+    const QString metrics[] = { "stages_total", "stage_wall_seconds_total", "stage_user_seconds_total", "stage_system_seconds_total", "stage_peak_rss_bytes", "stage_read_bytes_total", "stage_written_bytes_total" };
+    const QString help[] = { "Finished stages.", "Wall time spent in the stage.", "Processor time spent in user mode by the backends.", "Processor time spent in kernel mode by the backends.", "The highest memory usage of a single backend process in a stage.", "Bytes read by the backends.", "Bytes written by the backends." };
+    for( int i=0; i<7; i++ )
+    {
+        stream << "# HELP soundkonverter_" << metrics[i] << " " << help[i] << "\n";
+        stream << "# TYPE soundkonverter_" << metrics[i] << " " << ( i == 4 ? "gauge" : "counter" ) << "\n";
+        for( QMap<QString,Totals>::const_iterator it = totals.constBegin(); it != totals.constEnd(); ++it )
+        {
+            const QStringList key = it.key().split( "\t" );
+            const Totals& total = it.value();
+            stream << "soundkonverter_" << metrics[i] << "{stage=" << labelValue(key.at(0)) << ",backend=" << labelValue(key.at(1)) << "} ";
+            switch( i )
+            {
+                case 0: stream << total.count; break;
+                case 1: stream << total.wallTime; break;
+                case 2: stream << total.userTime; break;
+                case 3: stream << total.systemTime; break;
+                case 4: stream << total.peakRss * 1024; break;
+                case 5: stream << total.bytesRead; break;
+                case 6: stream << total.bytesWritten; break;
+            }
+            stream << "\n";
+        }
+    }
+
+    stream.flush();
+    return text;
+}
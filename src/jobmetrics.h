@@ -0,0 +1,125 @@
+
+#ifndef JOBMETRICS_H
+#define JOBMETRICS_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QStringList>
+
+class Config;
+class QTcpServer;
+
+
+/**
+ * @short Records the resources used by every stage of every conversion
+ *
+ * For each stage (getting the file, ripping, decoding, filtering, encoding, Replay Gain,
+ * writing tags) the wall time, the processor time, the peak memory usage of the biggest process and the number
+ * of bytes read and written by the backend processes are recorded. The processes are
+ * sampled via /proc while they are running.
+ *
+ * Finished jobs are appended to metrics.jsonl in the soundKonverter data directory,
+ * one JSON object per line. If a port has been set, the accumulated values are also
+ * served in the Prometheus text format on localhost.
+ */
+class JobMetrics : public QObject
+{
+    Q_OBJECT
+public:
+    JobMetrics( Config *_config, QObject *parent );
+    ~JobMetrics();
+
+    /** Returns true if recording has been enabled in the settings */
+    bool isEnabled() const;
+
+    /** The job with the id @p id begins the stage @p stage using @p backend, the previous stage of the job ends */
+    void beginStage( int id, const QString& stage, const QString& backend = QString() );
+    /** The current stage of the job with the id @p id ends */
+    void endStage( int id );
+    /** Samples the process @p pid and its child processes, they belong to the current stage of the job with the id @p id */
+    void sample( int id, qint64 pid );
+    /** Adds data that has been transferred without a backend process (e.g. by KIO) to the current stage */
+    void addTransferredBytes( int id, qint64 bytesRead, qint64 bytesWritten );
+    /** The job with the id @p id has finished with the result @p result, it gets written to the results file */
+    void finishJob( int id, const QString& inputFile, const QString& outputFile, const QString& result );
+
+private:
+    struct ProcessSample
+    {
+        qint64 userTicks;
+        qint64 systemTicks;
+        qint64 peakRss;         // [KiB]
+        qint64 bytesRead;
+        qint64 bytesWritten;
+    };
+
+    struct Stage
+    {
+        QString name;
+        QString backend;
+        qint64 wallTime;        // [ms]
+        double userTime;        // [s]
+        double systemTime;      // [s]
+        qint64 peakRss;         // [KiB] of the biggest process
+        qint64 bytesRead;
+        qint64 bytesWritten;
+    };
+
+    struct Job
+    {
+        QElapsedTimer timer;
+        QElapsedTimer stageTimer;
+        bool stageActive;
+        Stage currentStage;
+        /** the last sample of every process of the current stage */
+        QHash<qint64,ProcessSample> processSamples;
+        QList<Stage> stages;
+    };
+
+    /** The accumulated values of all stages with the same name and backend */
+    struct Totals
+    {
+        qint64 count;
+        double wallTime;        // [s]
+        double userTime;        // [s]
+        double systemTime;      // [s]
+        qint64 peakRss;         // [KiB]
+        qint64 bytesRead;
+        qint64 bytesWritten;
+    };
+
+    /** Reads the statistics of process @p pid, returns false if the process doesn't exist anymore */
+    static bool readProcess( qint64 pid, ProcessSample *sample );
+    /** Returns the ids of all child processes of @p pid */
+    static QList<qint64> childProcesses( qint64 pid );
+
+    QString toJson( const Job& job, const QString& inputFile, const QString& outputFile, const QString& result ) const;
+    QString prometheusText() const;
+
+    Config *config;
+
+    QHash<int,Job> jobs;
+
+    /** QMap< "stage\tbackend", totals > */
+    QMap<QString,Totals> totals;
+    /** QMap< result, number of jobs > */
+    QMap<QString,qint64> results;
+
+    QString fileName;
+    double ticksPerSecond;
+
+    QTcpServer *server;
+    int serverPort;
+
+private slots:
+    /** Starts or stops the metrics server if recording or the port has been changed */
+    void updateServer();
+
+    void newConnection();
+    void readRequest();
+};
+
+#endif // JOBMETRICS_H
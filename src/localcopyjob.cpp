@@ -0,0 +1,172 @@
+
+#include "localcopyjob.h"
+
+#include <QFile>
+#include <QtConcurrentRun>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+    #include <sys/syscall.h>
+    #ifndef FICLONE
+        #define FICLONE _IOW(0x94, 9, int)
+    #endif
+#endif
+
+
+// the amount of data copied at once, the copying can only be canceled in between [bytes]
+#define ChunkSize (64*1024*1024)
+
+
+static int copyThread( const QString source, const QString destination, QAtomicInt *canceled )
+{
+    return LocalCopyJob::copy( source, destination, canceled );
+}
+
+
+LocalCopyJob::LocalCopyJob( const QString& _source, const QString& _destination, QObject *parent )
+    : QObject( parent ),
+    sourcePath( _source ),
+    destinationPath( _destination ),
+    usedMethod( Failed ),
+    canceled( 0 )
+{
+    connect( &watcher, SIGNAL(finished()), this, SLOT(copyFinished()) );
+}
+
+LocalCopyJob::~LocalCopyJob()
+{
+    canceled = 1;
+    watcher.waitForFinished();
+}
+
+void LocalCopyJob::start()
+{
+    watcher.setFuture( QtConcurrent::run(copyThread,sourcePath,destinationPath,&canceled) );
+}
+
+void LocalCopyJob::kill()
+{
+    canceled = 1;
+}
+
+void LocalCopyJob::copyFinished()
+{
+    usedMethod = (int)canceled ? Failed : (Method)watcher.result();
+
+    if( usedMethod == Failed )
+        QFile::remove( destinationPath );
+
+    emit finished( this );
+}
+
+LocalCopyJob::Method LocalCopyJob::copy( const QString& source, const QString& destination, QAtomicInt *canceled )
+{
+    const int sourceFd = ::open( QFile::encodeName(source).constData(), O_RDONLY );
+    if( sourceFd < 0 )
+        return Failed;
+
+    struct stat sourceStat;
+    if( fstat(sourceFd,&sourceStat) != 0 )
+    {
+        ::close( sourceFd );
+        return Failed;
+    }
+
+    const int destinationFd = ::open( QFile::encodeName(destination).constData(), O_WRONLY | O_CREAT | O_TRUNC, sourceStat.st_mode & 0777 );
+    if( destinationFd < 0 )
+    {
+        ::close( sourceFd );
+        return Failed;
+    }
+
+    Method method = Failed;
+
+    #ifdef __linux__
+    if( ioctl(destinationFd,FICLONE,sourceFd) == 0 )
+    {
+        method = Reflink;
+    }
+    #endif
+
+    #if defined(__linux__) && defined(SYS_copy_file_range)
+    if( method == Failed )
+    {
+        off_t remaining = sourceStat.st_size;
+        while( remaining > 0 && !( canceled && (int)*canceled ) )
+        {
+            const ssize_t copied = syscall( SYS_copy_file_range, sourceFd, (loff_t*)0, destinationFd, (loff_t*)0, (size_t)qMin((off_t)ChunkSize,remaining), 0u );
+            if( copied <= 0 )
+                break;
+
+            remaining -= copied;
+        }
+
+        if( remaining == 0 )
+        {
+            method = CopyFileRange;
+        }
+        else if( remaining < sourceStat.st_size )
+        {
+            // copy_file_range stopped in the middle, start over
+            if( lseek(sourceFd,0,SEEK_SET) != 0 || ftruncate(destinationFd,0) != 0 || lseek(destinationFd,0,SEEK_SET) != 0 )
+            {
+                ::close( sourceFd );
+                ::close( destinationFd );
+                return Failed;
+            }
+        }
+    }
+    #endif
+
+    if( method == Failed && !( canceled && (int)*canceled ) )
+    {
+        QByteArray buffer( 1024*1024, 0 );
+        bool success = true;
+        ssize_t bytesRead;
+        while( ( bytesRead = ::read(sourceFd,buffer.data(),buffer.size()) ) != 0 )
+        {
+            if( bytesRead < 0 )
+            {
+                if( errno == EINTR )
+                    continue;
+
+                success = false;
+                break;
+            }
+
+            ssize_t written = 0;
+            while( written < bytesRead )
+            {
+                const ssize_t result = ::write( destinationFd, buffer.constData() + written, bytesRead - written );
+                if( result < 0 && errno == EINTR )
+                    continue;
+                if( result <= 0 )
+                {
+                    success = false;
+                    break;
+                }
+                written += result;
+            }
+
+            if( !success || ( canceled && (int)*canceled ) )
+            {
+                success = false;
+                break;
+            }
+        }
+
+        if( success )
+            method = Stream;
+    }
+
+    ::close( sourceFd );
+    if( ::close(destinationFd) != 0 )
+        method = Failed;
+
+    return method;
+}
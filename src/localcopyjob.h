@@ -0,0 +1,61 @@
+
+#ifndef LOCALCOPYJOB_H
+#define LOCALCOPYJOB_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QFutureWatcher>
+
+
+/**
+ * @short Copies a local file as cheap as the file system allows
+ *
+ * First a reflink (FICLONE) is tried, it shares the data blocks on btrfs and XFS and
+ * takes no time and no additional disk space. Then copy_file_range() lets the kernel
+ * copy the data without passing it through user space, and finally the file is
+ * streamed. The copying runs in a separate thread.
+ */
+class LocalCopyJob : public QObject
+{
+    Q_OBJECT
+public:
+    enum Method
+    {
+        Failed = 0,
+        Reflink,
+        CopyFileRange,
+        Stream
+    };
+
+    LocalCopyJob( const QString& _source, const QString& _destination, QObject *parent );
+    /** Waits for the copy thread to return */
+    ~LocalCopyJob();
+
+    void start();
+    /** Stops copying, finished() gets emitted with method() Failed */
+    void kill();
+
+    /** The method that has been used for copying the file or Failed */
+    Method method() const { return usedMethod; }
+
+    QString source() const { return sourcePath; }
+    QString destination() const { return destinationPath; }
+
+    /** Copies @p source to @p destination and returns the used method, stops if @p canceled gets set */
+    static Method copy( const QString& source, const QString& destination, QAtomicInt *canceled = 0 );
+
+signals:
+    void finished( LocalCopyJob *job );
+
+private slots:
+    void copyFinished();
+
+private:
+    QString sourcePath;
+    QString destinationPath;
+    Method usedMethod;
+    QAtomicInt canceled;
+    QFutureWatcher<int> watcher;
+};
+
+#endif // LOCALCOPYJOB_H
@@ -3,6 +3,7 @@
 #include "soundkonverterapp.h"
 #include "soundkonverter.h"
 #include "global.h"
+#include "startuptrace.h"
 
 #include <kdeui_export.h>
 #include <KMainWindow>
@@ -39,10 +40,16 @@ int main(int argc, char **argv)
     options.add( "autoclose", ki18n("Close soundKonverter after all files are converted (enabled when using '--invisible')") );
     options.add( "command <command>", ki18n("Execute <command> after each file has been converted (%i=input file, %o=output file)") );
     options.add( "file-list <path>", ki18n("Load the file list at <path> after starting soundKonverter") );
+    options.add( "watch <directory>", ki18n("Watch <directory> and convert all new files using the given profile and format (can be used multiple times)") );
+    options.add( "trace <file>", ki18n("Write the duration of the startup phases as a Chrome trace to <file> (or set SOUNDKONVERTER_TRACE)") );
     options.add( "+[files]", ki18n("Audio file(s) to append to the file list") );
     KCmdLineArgs::addCmdLineOptions(options);
 
     soundKonverterApp::addCmdLineOptions();
+
+    const QString traceFileName = KCmdLineArgs::parsedArgs()->getOption( "trace" );
+    StartupTrace::enable( !traceFileName.isEmpty() ? traceFileName : QString::fromLocal8Bit(qgetenv("SOUNDKONVERTER_TRACE")) );
+
     if( !soundKonverterApp::start() )
     {
         return 0;
@@ -25,6 +25,9 @@
 #include <QFile>
 #include <QDir>
 #include <QBuffer>
+#include <QCryptographicHash>
+#include <QImage>
+#include <QPainter>
 
 #include <KLocale>
 
@@ -145,6 +148,11 @@ TagEngine::TagEngine( Config *_config )
     : QObject( _config ),
     config( _config )
 {
+    coverCache.setMaxCost( 64 * 1024 ); // 64 MiB
+    resizedCoverCache.setMaxCost( 16 * 1024 ); // 16 MiB
+    resizedCoverSize = 0;
+    resizedCoverQuality = 0;
+
     TagLib::StringList genres = TagLib::ID3v1::genreList();
     for( TagLib::StringList::ConstIterator it = genres.begin(), end = genres.end(); it != end; ++it )
         genreList += TStringToQString( (*it) );
@@ -540,6 +548,38 @@ bool TagEngine::writeTags( const KUrl& fileName, TagData *tagData )
 
     TagLib::FileRef fileref( fileName.pathOrUrl().toLocal8Bit(), false );
 
+    if( !applyTags(fileref,tagData) )
+        return false;
+
+    return fileref.save();
+}
+
+bool TagEngine::writeTagsAndCovers( const KUrl& fileName, TagData *tagData, const QList<CoverData*>& covers, bool *coversWritten )
+{
+    if( coversWritten )
+        *coversWritten = false;
+
+    if( !tagData )
+        return false;
+
+    TagLib::FileRef fileref( fileName.pathOrUrl().toLocal8Bit(), false );
+
+    if( !applyTags(fileref,tagData) )
+        return false;
+
+    const bool coversApplied = applyCovers( fileref, covers );
+
+    // the file is only rewritten once, TagLib reuses the padding of the existing tags if the new ones fit
+    const bool success = fileref.save();
+
+    if( coversWritten )
+        *coversWritten = success && coversApplied;
+
+    return success;
+}
+
+bool TagEngine::applyTags( TagLib::FileRef& fileref, TagData *tagData )
+{
     //Set default codec to UTF-8 (see bugs 111246 and 111232)
     TagLib::ID3v2::FrameFactory::instance()->setDefaultTextEncoding( TagLib::String::UTF8 );
 
@@ -1036,7 +1076,7 @@ bool TagEngine::writeTags( const KUrl& fileName, TagData *tagData )
             }
         }*/
 
-        return fileref.save();
+        return true;
     }
 
     return false;
@@ -1046,7 +1086,7 @@ QList<CoverData*> TagEngine::readCovers( const KUrl& fileName )
 {
     QList<CoverData*> covers;
 
-    TagLib::FileRef fileref( fileName.pathOrUrl().toLocal8Bit() );
+    TagLib::FileRef fileref( fileName.pathOrUrl().toLocal8Bit(), false ); // the audio properties aren't needed for reading covers
 
     if( !fileref.isNull() )
     {
@@ -1225,9 +1265,30 @@ QList<CoverData*> TagEngine::readCovers( const KUrl& fileName )
         }
     }
 
+    shareCovers( covers );
+
     return covers;
 }
 
+void TagEngine::shareCovers( QList<CoverData*>& covers )
+{
+    foreach( CoverData *cover, covers )
+    {
+        cover->hash = QCryptographicHash::hash( cover->data, QCryptographicHash::Md5 );
+
+        // all tracks of an album usually contain the same cover
+        if( QByteArray *cachedData = coverCache.object(cover->hash) )
+        {
+            if( *cachedData == cover->data )
+                cover->data = *cachedData; // QByteArray is implicitly shared
+        }
+        else
+        {
+            coverCache.insert( cover->hash, new QByteArray(cover->data), cover->data.size() / 1024 + 1 );
+        }
+    }
+}
+
 bool TagEngine::writeCovers( const KUrl& fileName, QList<CoverData*> covers )
 {
     if( covers.isEmpty() )
@@ -1235,6 +1296,17 @@ bool TagEngine::writeCovers( const KUrl& fileName, QList<CoverData*> covers )
 
     TagLib::FileRef fileref( fileName.pathOrUrl().toLocal8Bit(), false );
 
+    if( !applyCovers(fileref,covers) )
+        return false;
+
+    return fileref.save();
+}
+
+bool TagEngine::applyCovers( TagLib::FileRef& fileref, const QList<CoverData*>& covers )
+{
+    if( covers.isEmpty() )
+        return true;
+
     if( !fileref.isNull() )
     {
         if( TagLib::MPEG::File *file = dynamic_cast<TagLib::MPEG::File*>(fileref.file()) )
@@ -1255,7 +1327,7 @@ bool TagEngine::writeCovers( const KUrl& fileName, QList<CoverData*> covers )
                 }
             }
 
-            return fileref.save();
+            return true;
         }
         else if( TagLib::Ogg::Vorbis::File *file = dynamic_cast<TagLib::Ogg::Vorbis::File*>(fileref.file()) )
         {
@@ -1283,7 +1355,7 @@ bool TagEngine::writeCovers( const KUrl& fileName, QList<CoverData*> covers )
                 #endif // TAGLIB_HAS_FLAC_PICTURELIST
             }
 
-            return fileref.save();
+            return true;
         }
         else if( TagLib::FLAC::File *file = dynamic_cast<TagLib::FLAC::File*>(fileref.file()) )
         {
@@ -1304,7 +1376,7 @@ bool TagEngine::writeCovers( const KUrl& fileName, QList<CoverData*> covers )
             Q_UNUSED(file)
             #endif // TAGLIB_HAS_FLAC_PICTURELIST
 
-            return fileref.save();
+            return true;
         }
         #ifdef TAGLIB_HAS_OPUS
         else if( TagLib::Ogg::Opus::File *file = dynamic_cast<TagLib::Ogg::Opus::File*>(fileref.file()) )
@@ -1331,7 +1403,7 @@ bool TagEngine::writeCovers( const KUrl& fileName, QList<CoverData*> covers )
                 #endif // TAGLIB_HAS_FLAC_PICTURELIST
             }
 
-            return fileref.save();
+            return true;
         }
         #endif // TAGLIB_HAS_OPUS
         else if( TagLib::MP4::File *file = dynamic_cast<TagLib::MP4::File*>(fileref.file()) )
@@ -1348,7 +1420,7 @@ bool TagEngine::writeCovers( const KUrl& fileName, QList<CoverData*> covers )
                 tag->itemListMap()["covr"] = TagLib::MP4::Item( coversList );
             }
 
-            return fileref.save();
+            return true;
         }
         else if( TagLib::ASF::File *file = dynamic_cast<TagLib::ASF::File*>(fileref.file()) )
         {
@@ -1372,33 +1444,147 @@ bool TagEngine::writeCovers( const KUrl& fileName, QList<CoverData*> covers )
                 #endif // TAGLIB_HAS_ASF_PICTURE
             }
 
-            return fileref.save();
+            return true;
         }
     }
 
     return false;
 }
 
-bool TagEngine::writeCoversToDirectory( const QString& directoryName, TagData *tags )
+QList<CoverData*> TagEngine::prepareCovers( const QList<CoverData*>& covers )
+{
+    QList<CoverData*> preparedCovers;
+
+    if( config->data.coverArt.resizeCovers && ( resizedCoverSize != config->data.coverArt.maxCoverSize || resizedCoverQuality != config->data.coverArt.coverQuality ) )
+    {
+        resizedCoverCache.clear();
+        resizedCoverSize = config->data.coverArt.maxCoverSize;
+        resizedCoverQuality = config->data.coverArt.coverQuality;
+    }
+
+    foreach( const CoverData *cover, covers )
+    {
+        // file icons must stay 32x32 PNG images
+        if( !config->data.coverArt.resizeCovers || cover->role == CoverData::FileIcon )
+        {
+            CoverData *newCover = new CoverData( cover->data, cover->mimeType, cover->role, cover->description );
+            newCover->hash = cover->hash;
+            preparedCovers.append( newCover );
+            continue;
+        }
+
+        const QByteArray hash = cover->hash.isEmpty() ? QCryptographicHash::hash( cover->data, QCryptographicHash::Md5 ) : cover->hash;
+
+        // every image is only resized once, not once per track
+        CoverData *resized = resizedCoverCache.object( hash );
+        const bool cached = resized;
+        if( !cached )
+        {
+            resized = resizedCover( cover );
+            resized->hash = QCryptographicHash::hash( resized->data, QCryptographicHash::Md5 );
+        }
+
+        CoverData *newCover = new CoverData( resized->data, resized->mimeType, cover->role, cover->description );
+        newCover->hash = resized->hash;
+        preparedCovers.append( newCover );
+
+        // the cache takes the ownership and deletes covers that are bigger than the whole cache right away
+        if( !cached )
+            resizedCoverCache.insert( hash, resized, resized->data.size() / 1024 + 1 );
+    }
+
+    return preparedCovers;
+}
+
+CoverData *TagEngine::resizedCover( const CoverData *cover )
+{
+    CoverData *original = new CoverData( cover->data, cover->mimeType );
+
+    QImage image;
+    if( !image.loadFromData(cover->data) )
+        return original;
+
+    const int maxSize = config->data.coverArt.maxCoverSize;
+    const bool tooBig = image.width() > maxSize || image.height() > maxSize;
+
+    // don't recompress small jpeg images, that would only make them worse
+    if( !tooBig && cover->mimeType == "image/jpeg" )
+        return original;
+
+    if( tooBig )
+        image = image.scaled( maxSize, maxSize, Qt::KeepAspectRatio, Qt::SmoothTransformation );
+
+    if( image.hasAlphaChannel() )
+    {
+        // jpeg doesn't support transparency
+        QImage opaqueImage( image.size(), QImage::Format_RGB32 );
+        opaqueImage.fill( Qt::white );
+        QPainter painter( &opaqueImage );
+        painter.drawImage( 0, 0, image );
+        painter.end();
+        image = opaqueImage;
+    }
+
+    // writing the image anew drops all meta data (e.g. EXIF) of the original
+    QByteArray data;
+    QBuffer buffer( &data );
+    buffer.open( QIODevice::WriteOnly );
+    if( !image.save(&buffer,"JPEG",config->data.coverArt.coverQuality) )
+        return original;
+    buffer.close();
+
+    if( !tooBig && data.size() >= cover->data.size() )
+        return original;
+
+    delete original;
+
+    return new CoverData( data, "image/jpeg" );
+}
+
+bool TagEngine::writeCoversToDirectory( const QString& directoryName, TagData *tags, const QList<CoverData*>& covers )
 {
     if( !tags )
         return false;
 
-    QList<CoverData*> covers = tags->covers;
-
     if( covers.isEmpty() )
         return true;
 
+    if( directoryName.isEmpty() )
+        return false;
+
     QDir dir( directoryName );
 
-    if( directoryName.isEmpty() || !dir.exists() )
+    // the other tracks of the album have already written these covers, so the file system doesn't need to be asked again
+    QHash<QByteArray,QString>& directoryCovers = writtenCovers[QDir::cleanPath(dir.absolutePath())];
+    bool allWritten = true;
+    foreach( CoverData *cover, covers )
+    {
+        if( cover->hash.isEmpty() )
+            cover->hash = QCryptographicHash::hash( cover->data, QCryptographicHash::Md5 );
+
+        if( !directoryCovers.contains(cover->hash) )
+            allWritten = false;
+    }
+
+    if( allWritten )
         return false;
 
+    if( !dir.exists() )
+    {
+        directoryCovers.clear();
+        return false;
+    }
 
     int i = covers.count() > 1 ? 1 : 0;
 
     foreach( CoverData *cover, covers )
     {
+        if( directoryCovers.contains(cover->hash) )
+        {
+            i++;
+            continue;
+        }
+
         QString fileName = cover->description;
         if( fileName.isEmpty() || config->data.coverArt.writeCoverName == 1 )
         {
@@ -1445,11 +1631,30 @@ bool TagEngine::writeCoversToDirectory( const QString& directoryName, TagData *t
         }
 
         QFile file( directoryName + "/" + fileName + extension );
-        if( !file.exists() )
+        if( file.exists() )
+        {
+            directoryCovers.insert( cover->hash, file.fileName() );
+        }
+        else if( file.open(QIODevice::WriteOnly) )
         {
-            file.open( QIODevice::WriteOnly );
-            file.write( cover->data.data(), cover->data.size() );
+            // only remember the cover if it has been written completely, so failed writes get retried
+            const bool written = file.write( cover->data.data(), cover->data.size() ) == cover->data.size();
             file.close();
+
+            if( written )
+            {
+                directoryCovers.insert( cover->hash, file.fileName() );
+            }
+            else
+            {
+                // the directory might have been removed or the disc is full, so don't trust the other records either
+                file.remove();
+                directoryCovers.clear();
+            }
+        }
+        else
+        {
+            directoryCovers.clear();
         }
 
         i++;
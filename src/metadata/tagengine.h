@@ -6,9 +6,15 @@
 #include <KUrl>
 
 #include <QStringList>
+#include <QCache>
+#include <QHash>
 
 class Config;
 
+namespace TagLib {
+    class FileRef;
+}
+
 class CoverData
 {
 public:
@@ -68,6 +74,8 @@ public:
     QString mimeType;
     Role role;
     QString description;
+    /** The MD5 hash of data, set by TagEngine when reading covers */
+    QByteArray hash;
 
     static QString roleName( Role role );
 };
@@ -130,10 +138,36 @@ public:
 
     QList<CoverData*> readCovers( const KUrl& fileName );
     bool writeCovers( const KUrl& fileName, QList<CoverData*> covers );
-    bool writeCoversToDirectory( const QString& directoryName, TagData *tags );
+    /** Writes the tags and the covers with one save, so the file gets rewritten once only, @p coversWritten is set to false if the format doesn't support covers */
+    bool writeTagsAndCovers( const KUrl& fileName, TagData *tagData, const QList<CoverData*>& covers, bool *coversWritten );
+    bool writeCoversToDirectory( const QString& directoryName, TagData *tags, const QList<CoverData*>& covers );
+
+    /** Returns copies of @p covers, downscaled and recompressed if enabled in the settings, the caller takes ownership */
+    QList<CoverData*> prepareCovers( const QList<CoverData*>& covers );
 
 private:
     Config *config;
+
+    /** Sets the tags of the opened file @p fileref without saving it */
+    bool applyTags( TagLib::FileRef& fileref, TagData *tagData );
+    /** Adds @p covers to the opened file @p fileref without saving it, returns false if the format doesn't support covers */
+    bool applyCovers( TagLib::FileRef& fileref, const QList<CoverData*>& covers );
+
+    /** Replaces the data of @p covers by the data of identical covers that have been read before, so every image is kept in memory once */
+    void shareCovers( QList<CoverData*>& covers );
+
+    /** QCache< hash, image data > of recently read covers, the cost is the size in KiB */
+    QCache<QByteArray,QByteArray> coverCache;
+    /** Downscales and recompresses @p cover, returns the original data if that doesn't make it smaller */
+    CoverData *resizedCover( const CoverData *cover );
+
+    /** QCache< hash of the original image, resized cover > */
+    QCache<QByteArray,CoverData> resizedCoverCache;
+    /** the settings the resized covers in the cache have been created with */
+    int resizedCoverSize;
+    int resizedCoverQuality;
+    /** QHash< directory, QHash< hash, file > > of the covers that have been written to the directory */
+    QHash< QString, QHash<QByteArray,QString> > writtenCovers;
 };
 
 #endif // TAGENGINE_H
@@ -0,0 +1,297 @@
+
+#include "mirrormanifest.h"
+#include "core/conversionoptions.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QDomDocument>
+#include <QFile>
+#include <QFileInfo>
+#include <QtConcurrentRun>
+
+#include <KStandardDirs>
+
+
+#define MIRROR_MANIFEST_VERSION 1
+
+
+MirrorManifest::MirrorManifest( QObject *parent )
+    : QObject( parent )
+{
+    fileName = KStandardDirs::locateLocal( "data", "soundkonverter/mirror_manifest.dat" );
+    loaded = false;
+    changed = false;
+
+    connect( &hashWatcher, SIGNAL(finished()), this, SLOT(hashFinished()) );
+}
+
+MirrorManifest::~MirrorManifest()
+{
+    // files that haven't been hashed yet are compared by their time stamp only
+    hashQueue.clear();
+    hashWatcher.waitForFinished();
+    hashFinished();
+
+    save();
+}
+
+void MirrorManifest::load()
+{
+    if( loaded )
+        return;
+
+    loaded = true;
+
+    QFile file( fileName );
+    if( !file.open(QIODevice::ReadOnly) )
+        return;
+
+    QDataStream stream( &file );
+    stream.setVersion( QDataStream::Qt_4_6 );
+
+    qint32 version;
+    stream >> version;
+    if( version != MIRROR_MANIFEST_VERSION )
+        return;
+
+    qint32 fingerprintCount;
+    stream >> fingerprintCount;
+    for( int i=0; i<fingerprintCount && stream.status() == QDataStream::Ok; i++ )
+    {
+        QByteArray fingerprint;
+        qint32 entryCount;
+        stream >> fingerprint >> entryCount;
+
+        QHash<QString,Entry>& fingerprintEntries = entries[fingerprint];
+        fingerprintEntries.reserve( entryCount );
+        for( int j=0; j<entryCount && stream.status() == QDataStream::Ok; j++ )
+        {
+            QString sourcePath;
+            Entry entry;
+            stream >> sourcePath >> entry.size >> entry.modified >> entry.hash >> entry.outputPath;
+            fingerprintEntries.insert( sourcePath, entry );
+        }
+    }
+
+    if( stream.status() != QDataStream::Ok )
+        entries.clear();
+}
+
+void MirrorManifest::save()
+{
+    if( !changed )
+        return;
+
+    QFile file( fileName );
+    if( !file.open(QIODevice::WriteOnly) )
+        return;
+
+    QDataStream stream( &file );
+    stream.setVersion( QDataStream::Qt_4_6 );
+
+    stream << (qint32)MIRROR_MANIFEST_VERSION;
+    stream << (qint32)entries.count();
+    for( QHash< QByteArray, QHash<QString,Entry> >::const_iterator it = entries.constBegin(); it != entries.constEnd(); ++it )
+    {
+        stream << it.key() << (qint32)it.value().count();
+        for( QHash<QString,Entry>::const_iterator entry = it.value().constBegin(); entry != it.value().constEnd(); ++entry )
+        {
+            stream << entry.key() << entry.value().size << entry.value().modified << entry.value().hash << entry.value().outputPath;
+        }
+    }
+
+    file.close();
+
+    changed = false;
+}
+
+QByteArray MirrorManifest::fingerprint( const ConversionOptions *conversionOptions )
+{
+    if( !conversionOptions )
+        return QByteArray();
+
+    QDomDocument document( "soundkonverter_conversionoptions" );
+    document.appendChild( conversionOptions->toXml(document) );
+
+    return QCryptographicHash::hash( document.toString().toUtf8(), QCryptographicHash::Md5 ).toHex();
+}
+
+QByteArray MirrorManifest::contentHash( const QString& fileName )
+{
+    QFile file( fileName );
+    if( !file.open(QIODevice::ReadOnly) )
+        return QByteArray();
+
+    QCryptographicHash hash( QCryptographicHash::Md5 );
+    while( !file.atEnd() )
+    {
+        hash.addData( file.read(1024*1024) );
+    }
+
+    return hash.result().toHex();
+}
+
+MirrorManifest::State MirrorManifest::state( const QFileInfo& sourceInfo, const QByteArray& fingerprint )
+{
+    load();
+
+    if( !entries.contains(fingerprint) )
+        return Changed;
+
+    const QHash<QString,Entry>& fingerprintEntries = entries[fingerprint];
+    const QString sourcePath = QDir::cleanPath( sourceInfo.absoluteFilePath() );
+    if( !fingerprintEntries.contains(sourcePath) )
+        return Changed;
+
+    const Entry& entry = fingerprintEntries[sourcePath];
+    if( entry.size != sourceInfo.size() )
+        return Changed;
+
+    if( !QFile::exists(entry.outputPath) )
+        return Changed;
+
+    if( entry.modified == sourceInfo.lastModified().toTime_t() )
+        return UpToDate;
+
+    // reading the whole file would block the user interface, the content gets compared in verify()
+    return entry.hash.isEmpty() ? Changed : TimeStampChanged;
+}
+
+void MirrorManifest::verify( const QString& sourcePath, const QByteArray& fingerprint )
+{
+    HashJob job;
+    job.fingerprint = fingerprint;
+    job.sourcePath = QDir::cleanPath( QFileInfo(sourcePath).absoluteFilePath() );
+    job.verify = true;
+    hashQueue.append( job );
+    hashNext();
+}
+
+QString MirrorManifest::update( const QString& sourcePath, const QByteArray& fingerprint, const QString& outputPath )
+{
+    load();
+
+    QFileInfo sourceInfo( sourcePath );
+    const QString absoluteSourcePath = QDir::cleanPath( sourceInfo.absoluteFilePath() );
+
+    Entry entry;
+    entry.size = sourceInfo.size();
+    entry.modified = sourceInfo.lastModified().toTime_t();
+    entry.outputPath = outputPath;
+
+    QHash<QString,Entry>& fingerprintEntries = entries[fingerprint];
+    const QString previousOutputPath = fingerprintEntries.value( absoluteSourcePath ).outputPath;
+    fingerprintEntries.insert( absoluteSourcePath, entry );
+    changed = true;
+
+    // reading the whole file would block the user interface
+    HashJob job;
+    job.fingerprint = fingerprint;
+    job.sourcePath = absoluteSourcePath;
+    job.verify = false;
+    hashQueue.append( job );
+    hashNext();
+
+    return ( previousOutputPath != outputPath ) ? previousOutputPath : QString();
+}
+
+QString MirrorManifest::outputPath( const QString& sourcePath, const QByteArray& fingerprint )
+{
+    load();
+
+    if( !entries.contains(fingerprint) )
+        return QString();
+
+    return entries[fingerprint].value( QDir::cleanPath(QFileInfo(sourcePath).absoluteFilePath()) ).outputPath;
+}
+
+void MirrorManifest::hashNext()
+{
+    if( hashWatcher.isRunning() || hashQueue.isEmpty() )
+        return;
+
+    hashing = hashQueue.takeFirst();
+    hashWatcher.setFuture( QtConcurrent::run(&MirrorManifest::contentHash,hashing.sourcePath) );
+}
+
+void MirrorManifest::hashFinished()
+{
+    if( hashing.sourcePath.isEmpty() )
+        return;
+
+    const HashJob job = hashing;
+    hashing = HashJob();
+
+    const QByteArray hash = hashWatcher.result();
+    const QFileInfo sourceInfo( job.sourcePath );
+
+    // the entry may have been replaced or removed in the meantime
+    Entry *entry = 0;
+    if( !hash.isEmpty() && entries.contains(job.fingerprint) && entries[job.fingerprint].contains(job.sourcePath) )
+        entry = &entries[job.fingerprint][job.sourcePath];
+
+    if( job.verify )
+    {
+        const bool upToDate = entry && entry->hash == hash && entry->size == sourceInfo.size();
+        if( upToDate )
+        {
+            entry->modified = sourceInfo.lastModified().toTime_t();
+            changed = true;
+        }
+        emit verified( job.sourcePath, job.fingerprint, upToDate );
+    }
+    else if( entry && entry->size == sourceInfo.size() && entry->modified == sourceInfo.lastModified().toTime_t() )
+    {
+        entry->hash = hash;
+        changed = true;
+    }
+
+    hashNext();
+}
+
+bool MirrorManifest::isOutputUsed( const QString& outputPath, const QString& sourcePath )
+{
+    load();
+
+    const QString absoluteSourcePath = QDir::cleanPath( QFileInfo(sourcePath).absoluteFilePath() );
+    for( QHash< QByteArray, QHash<QString,Entry> >::const_iterator fingerprintIt = entries.constBegin(); fingerprintIt != entries.constEnd(); ++fingerprintIt )
+    {
+        for( QHash<QString,Entry>::const_iterator it = fingerprintIt.value().constBegin(); it != fingerprintIt.value().constEnd(); ++it )
+        {
+            if( it.value().outputPath == outputPath && it.key() != absoluteSourcePath )
+                return true;
+        }
+    }
+
+    return false;
+}
+
+QList< QPair<QString,QString> > MirrorManifest::orphans( const QString& directory, const QByteArray& fingerprint, const QSet<QString>& existingFiles )
+{
+    load();
+
+    QList< QPair<QString,QString> > orphanList;
+
+    if( !entries.contains(fingerprint) )
+        return orphanList;
+
+    const QString prefix = QDir::cleanPath( QFileInfo(directory).absoluteFilePath() ) + "/";
+    const QHash<QString,Entry>& fingerprintEntries = entries[fingerprint];
+    for( QHash<QString,Entry>::const_iterator it = fingerprintEntries.constBegin(); it != fingerprintEntries.constEnd(); ++it )
+    {
+        if( it.key().startsWith(prefix) && !existingFiles.contains(it.key()) )
+            orphanList.append( qMakePair(it.key(),it.value().outputPath) );
+    }
+
+    return orphanList;
+}
+
+void MirrorManifest::remove( const QString& sourcePath, const QByteArray& fingerprint )
+{
+    load();
+
+    if( entries.contains(fingerprint) && entries[fingerprint].remove(QDir::cleanPath(QFileInfo(sourcePath).absoluteFilePath())) > 0 )
+        changed = true;
+}
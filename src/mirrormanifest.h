@@ -0,0 +1,115 @@
+
+#ifndef MIRRORMANIFEST_H
+#define MIRRORMANIFEST_H
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QPair>
+#include <QSet>
+#include <QStringList>
+
+class ConversionOptions;
+class QFileInfo;
+
+
+/**
+ * @short Remembers which source files have been converted with which options, used for mirroring a music library
+ *
+ * The manifest maps (conversion options fingerprint, source file) to the size, the
+ * modification time and the content hash of the source file and the path of the
+ * output file, so unchanged files can be skipped without reading them.
+ * The content hashes of converted files are calculated one after another in a worker thread,
+ * source files whose time stamp has changed are compared with their recorded hash in the same thread.
+ */
+class MirrorManifest : public QObject
+{
+    Q_OBJECT
+public:
+    enum State {
+        //! The source file has already been converted and hasn't changed
+        UpToDate,
+        //! The source file needs to be converted
+        Changed,
+        //! Only the time stamp has changed, use verify() to compare the content
+        TimeStampChanged
+    };
+
+    struct Entry
+    {
+        qint64 size;
+        uint modified;
+        QByteArray hash;
+        QString outputPath;
+    };
+
+    explicit MirrorManifest( QObject *parent );
+    ~MirrorManifest();
+
+    /** Writes the manifest to disc if it has been changed */
+    void save();
+
+    /** Returns the fingerprint of @p conversionOptions, files converted with options of the same fingerprint produce the same output */
+    static QByteArray fingerprint( const ConversionOptions *conversionOptions );
+
+    /** Returns UpToDate if the source file @p sourceInfo has already been converted with @p fingerprint, hasn't changed since and the output file still exists, doesn't read the file */
+    State state( const QFileInfo& sourceInfo, const QByteArray& fingerprint );
+
+    /** Compares the content of @p sourcePath with the recorded content hash in the worker thread and emits verified() */
+    void verify( const QString& sourcePath, const QByteArray& fingerprint );
+
+    /** Records that @p sourcePath has been converted to @p outputPath, returns the previous output path if it has changed */
+    QString update( const QString& sourcePath, const QByteArray& fingerprint, const QString& outputPath );
+
+    /** Returns the output path recorded for converting @p sourcePath with @p fingerprint or an empty string */
+    QString outputPath( const QString& sourcePath, const QByteArray& fingerprint );
+
+    /** Returns all entries (source path and output path) below @p directory whose source is not in @p existingFiles */
+    QList< QPair<QString,QString> > orphans( const QString& directory, const QByteArray& fingerprint, const QSet<QString>& existingFiles );
+
+    /** Returns true if a source file other than @p sourcePath has been converted to @p outputPath */
+    bool isOutputUsed( const QString& outputPath, const QString& sourcePath );
+
+    /** Forgets the source file @p sourcePath */
+    void remove( const QString& sourcePath, const QByteArray& fingerprint );
+
+    /** Returns the MD5 sum of the content of @p fileName */
+    static QByteArray contentHash( const QString& fileName );
+
+signals:
+    /** The content of @p sourcePath has been compared with the recorded content hash, @p upToDate is false if it has changed */
+    void verified( const QString& sourcePath, const QByteArray& fingerprint, bool upToDate );
+
+private slots:
+    void hashFinished();
+
+private:
+    /** Loads the manifest on first use, so it doesn't slow down the start if mirroring isn't used */
+    void load();
+    /** Starts hashing the next file of hashQueue */
+    void hashNext();
+
+    /** QHash< fingerprint, QHash< source path, entry > > */
+    QHash< QByteArray, QHash<QString,Entry> > entries;
+
+    struct HashJob
+    {
+        HashJob() : verify( false ) {}
+
+        QByteArray fingerprint;
+        QString sourcePath;
+        /** compare the hash with the recorded one instead of recording it */
+        bool verify;
+    };
+
+    /** the files whose content hash is missing or needs to be compared */
+    QList<HashJob> hashQueue;
+    HashJob hashing;
+    QFutureWatcher<QByteArray> hashWatcher;
+
+    QString fileName;
+    bool loaded;
+    bool changed;
+};
+
+#endif // MIRRORMANIFEST_H
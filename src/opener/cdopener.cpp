@@ -110,6 +110,7 @@ CDOpener::CDOpener( Config *_config, const QString& _device, QWidget *parent, Qt
     cdDrive( 0 ),
     cdParanoia( 0 ),
     cddb( 0 ),
+    discInfoCache( 0 ),
     cdTextFound( false ),
     cddbFound( false )
 {
@@ -424,6 +425,8 @@ CDOpener::CDOpener( Config *_config, const QString& _device, QWidget *parent, Qt
     cddb = new KCDDB::Client();
     connect( cddb, SIGNAL(finished(KCDDB::Result)), this, SLOT(lookup_cddb_done(KCDDB::Result)) );
 
+    discInfoCache = new DiscInfoCache();
+
 
     // set up timeout timer
     timeoutTimer.setSingleShot( true );
@@ -510,6 +513,9 @@ CDOpener::~CDOpener()
 
     if( cddb )
         delete cddb;
+
+    if( discInfoCache )
+        delete discInfoCache;
 }
 
 void CDOpener::setProfile( const QString& profile )
@@ -669,20 +675,37 @@ bool CDOpener::openCdDevice( const QString& _device )
     adjustComposerColumn();
 
 
-    // request cddb data
-    requestCddb( true );
+    // discs that have been opened before don't need to be looked up again
+    discId = DiscInfoCache::discId( trackOffsets() );
+    DiscInfoCache::Disc disc;
+    if( discInfoCache->find(discId,&disc) && disc.tracks.count() == trackTotal )
+    {
+        applyDiscInfo( disc );
+        fadeOut();
+    }
+    else
+    {
+        // request cddb data
+        requestCddb( true );
+    }
 
     return true;
 }
 
-void CDOpener::requestCddb( bool autoRequest )
+QList<int> CDOpener::verificationOffsets()
 {
-    lOverlayLabel->setText( i18n("Please wait, trying to download CDDB data ...") );
+    // the lead-out of Enhanced CDs is the end of the data session, so the length of the last audio track
+    // can't be calculated from it and AccurateRip identifies these discs by the data track, too
+    if( cdda_audio_tracks(cdDrive) != cdda_tracks(cdDrive) )
+        return QList<int>();
 
-    timeoutTimer.start( autoRequest ? 10000 : 20000 );
+    return trackOffsets();
+}
 
+QList<int> CDOpener::trackOffsets()
+{
     // cddb needs offsets +150 frames (2 seconds * 75 frames per second)
-    KCDDB::TrackOffsetList offsets;
+    QList<int> offsets;
     for( int i=1; i<=cdda_tracks(cdDrive); i++ )
     {
         if( !(IS_AUDIO(cdDrive,i-1)) )
@@ -692,6 +715,75 @@ void CDOpener::requestCddb( bool autoRequest )
     }
     offsets.append( cdda_disc_lastsector(cdDrive) + 150 + 1 );
 
+    return offsets;
+}
+
+DiscInfoCache::Disc CDOpener::currentDiscInfo()
+{
+    DiscInfoCache::Disc disc;
+    disc.artist = lArtist->text();
+    disc.album = lAlbum->text();
+    disc.genre = cGenre->currentText();
+    disc.year = iYear->value();
+    disc.disc = iDisc->value();
+    disc.discTotal = iDiscTotal->value();
+
+    for( int i=1; i<tags.count(); i++ )
+    {
+        DiscInfoCache::Track track;
+        track.artist = tags.at(i)->artist;
+        track.composer = tags.at(i)->composer;
+        track.title = tags.at(i)->title;
+        track.comment = tags.at(i)->comment;
+        disc.tracks.append( track );
+    }
+
+    return disc;
+}
+
+void CDOpener::applyDiscInfo( const DiscInfoCache::Disc& disc )
+{
+    for( int i=1; i<tags.count() && i<=disc.tracks.count(); i++ )
+    {
+        tags.at(i)->artist = disc.tracks.at(i-1).artist;
+        tags.at(i)->composer = disc.tracks.at(i-1).composer;
+        tags.at(i)->title = disc.tracks.at(i-1).title;
+        tags.at(i)->comment = disc.tracks.at(i-1).comment;
+
+        QTreeWidgetItem *item = trackList->topLevelItem(i-1);
+        item->setText( Column_Artist, tags.at(i)->artist );
+        item->setText( Column_Composer, tags.at(i)->composer );
+        item->setText( Column_Title, tags.at(i)->title );
+    }
+
+    tags.at(0)->album = disc.album;
+    tags.at(0)->artist = disc.artist;
+    tags.at(0)->year = disc.year;
+    tags.at(0)->genre = disc.genre;
+    tags.at(0)->disc = disc.disc;
+    tags.at(0)->discTotal = disc.discTotal;
+
+    lArtist->setText( tags.at(0)->artist );
+    lAlbum->setText( tags.at(0)->album );
+    iDisc->setValue( tags.at(0)->disc );
+    iDiscTotal->setValue( tags.at(0)->discTotal );
+    iYear->setValue( tags.at(0)->year );
+    cGenre->setEditText( tags.at(0)->genre );
+
+    artistChanged( lArtist->text() );
+    adjustComposerColumn();
+}
+
+void CDOpener::requestCddb( bool autoRequest )
+{
+    lOverlayLabel->setText( i18n("Please wait, trying to download CDDB data ...") );
+
+    timeoutTimer.start( autoRequest ? 10000 : 20000 );
+
+    KCDDB::TrackOffsetList offsets;
+    foreach( int offset, trackOffsets() )
+        offsets.append( offset );
+
     cddb->config().reparse();
     cddb->setBlockingMode( false );
     cddb->lookup( offsets );
@@ -775,6 +867,9 @@ void CDOpener::lookup_cddb_done( KCDDB::Result result )
 
     artistChanged( lArtist->text() );
 
+    // remember the chosen entry, so the disc doesn't need to be looked up again
+    discInfoCache->insert( discId, currentDiscInfo() );
+
     fadeOut();
 }
 
@@ -1282,7 +1377,9 @@ void CDOpener::addClicked()
 
         options->accepted();
 
-        emit addTracks( device, tracks, trackCount, tagList, conversionOptions, command );
+        discInfoCache->insert( discId, currentDiscInfo() );
+
+        emit addTracks( device, tracks, trackCount, verificationOffsets(), tagList, conversionOptions, command );
 
         accept();
     }
@@ -2,6 +2,8 @@
 #ifndef CDOPENER_H
 #define CDOPENER_H
 
+#include "discinfocache.h"
+
 #include <KDialog>
 #include <QTimer>
 
@@ -201,6 +203,20 @@ private:
 
     KCDDB::Client *cddb;
 
+    /** the tags of discs that have been opened before */
+    DiscInfoCache *discInfoCache;
+    /** the id of the inserted disc for the cache */
+    QString discId;
+
+    /** Returns the start sectors of the audio tracks and the lead-out as used by cddb */
+    QList<int> trackOffsets();
+    /** Returns the track offsets for verifying the rips with AccurateRip, an empty list for discs with data tracks */
+    QList<int> verificationOffsets();
+    /** Returns the tags of the disc as shown in the dialog */
+    DiscInfoCache::Disc currentDiscInfo();
+    /** Shows the tags @p disc in the dialog */
+    void applyDiscInfo( const DiscInfoCache::Disc& disc );
+
     QList<TagData*> tags; // @0 disc tags
     bool cdTextFound;
     bool cddbFound;
@@ -266,7 +282,7 @@ private slots:
     void fadeAnim();
 
 signals:
-    void addTracks( const QString& device, QList<int> trackList, int tracks, QList<TagData*> tagList, ConversionOptions *conversionOptions, const QString& command );
+    void addTracks( const QString& device, QList<int> trackList, int tracks, QList<int> discOffsets, QList<TagData*> tagList, ConversionOptions *conversionOptions, const QString& command );
     void addDisc( const QString& device, ConversionOptions *conversionOptions );
     //void openCuesheetEditor( const QString& content );
 };
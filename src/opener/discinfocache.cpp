@@ -0,0 +1,143 @@
+
+#include "discinfocache.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QStringList>
+
+#include <KStandardDirs>
+
+
+#define DISC_INFO_CACHE_VERSION 1
+
+// the least recently used discs get dropped above this number
+#define MaximumDiscs 2000
+
+
+QDataStream& operator<<( QDataStream& stream, const DiscInfoCache::Track& track )
+{
+    return stream << track.artist << track.composer << track.title << track.comment;
+}
+
+QDataStream& operator>>( QDataStream& stream, DiscInfoCache::Track& track )
+{
+    return stream >> track.artist >> track.composer >> track.title >> track.comment;
+}
+
+QDataStream& operator<<( QDataStream& stream, const DiscInfoCache::Disc& disc )
+{
+    return stream << disc.artist << disc.album << disc.genre << (qint32)disc.year << (qint32)disc.disc << (qint32)disc.discTotal << disc.tracks << disc.lastUsed;
+}
+
+QDataStream& operator>>( QDataStream& stream, DiscInfoCache::Disc& disc )
+{
+    qint32 year, number, total;
+    stream >> disc.artist >> disc.album >> disc.genre >> year >> number >> total >> disc.tracks >> disc.lastUsed;
+    disc.year = year;
+    disc.disc = number;
+    disc.discTotal = total;
+    return stream;
+}
+
+
+DiscInfoCache::DiscInfoCache()
+{
+    fileName = KStandardDirs::locateLocal( "data", "soundkonverter/disc_info_cache.dat" );
+    loaded = false;
+    changed = false;
+}
+
+DiscInfoCache::~DiscInfoCache()
+{
+    if( changed )
+        save();
+}
+
+QString DiscInfoCache::discId( const QList<int>& offsets )
+{
+    // the complete table of contents, the 32 bit cddb id isn't unique
+    QStringList list;
+    foreach( int offset, offsets )
+        list.append( QString::number(offset) );
+
+    return list.join( "," );
+}
+
+bool DiscInfoCache::find( const QString& discId, Disc *disc )
+{
+    load();
+
+    if( !discs.contains(discId) )
+        return false;
+
+    // the use time is written with the next insert or when the cache gets destroyed
+    discs[discId].lastUsed = QDateTime::currentDateTime();
+    changed = true;
+
+    *disc = discs.value( discId );
+
+    return true;
+}
+
+void DiscInfoCache::insert( const QString& discId, const Disc& disc )
+{
+    load();
+
+    discs[discId] = disc;
+    discs[discId].lastUsed = QDateTime::currentDateTime();
+
+    while( discs.count() > MaximumDiscs )
+    {
+        QMap<QString,Disc>::iterator oldest = discs.begin();
+        for( QMap<QString,Disc>::iterator it = discs.begin(); it != discs.end(); ++it )
+        {
+            if( it.value().lastUsed < oldest.value().lastUsed )
+                oldest = it;
+        }
+        discs.erase( oldest );
+    }
+
+    save();
+}
+
+void DiscInfoCache::load()
+{
+    if( loaded )
+        return;
+
+    loaded = true;
+
+    QFile file( fileName );
+    if( !file.open(QIODevice::ReadOnly) )
+        return;
+
+    QDataStream stream( &file );
+    stream.setVersion( QDataStream::Qt_4_6 );
+
+    qint32 version;
+    stream >> version;
+    if( version != DISC_INFO_CACHE_VERSION )
+        return;
+
+    stream >> discs;
+
+    if( stream.status() != QDataStream::Ok )
+        discs.clear();
+}
+
+void DiscInfoCache::save()
+{
+    QFile file( fileName );
+    if( !file.open(QIODevice::WriteOnly) )
+        return;
+
+    QDataStream stream( &file );
+    stream.setVersion( QDataStream::Qt_4_6 );
+
+    stream << (qint32)DISC_INFO_CACHE_VERSION;
+    stream << discs;
+
+    file.close();
+
+    changed = false;
+}
@@ -0,0 +1,64 @@
+
+#ifndef DISCINFOCACHE_H
+#define DISCINFOCACHE_H
+
+#include <QDateTime>
+#include <QList>
+#include <QMap>
+#include <QString>
+
+
+/**
+ * @short Remembers the tags of audio CDs, so discs that are inserted again don't need a CDDB lookup
+ *
+ * The discs are identified by their table of contents. The cache holds the tags that have been
+ * chosen or edited the last time, the least recently used discs get dropped if it grows too big.
+ */
+class DiscInfoCache
+{
+public:
+    struct Track
+    {
+        QString artist;
+        QString composer;
+        QString title;
+        QString comment;
+    };
+
+    struct Disc
+    {
+        QString artist;
+        QString album;
+        QString genre;
+        int year;
+        int disc;
+        int discTotal;
+        QList<Track> tracks;
+        QDateTime lastUsed;
+    };
+
+    DiscInfoCache();
+    ~DiscInfoCache();
+
+    /** Returns the id of a disc with the track start sectors @p offsets, the last offset is the lead-out */
+    static QString discId( const QList<int>& offsets );
+
+    /** Copies the cached tags of @p discId to @p disc and marks it as used, returns false if the disc is unknown */
+    bool find( const QString& discId, Disc *disc );
+    /** Stores the tags @p disc of @p discId and writes the cache to disc */
+    void insert( const QString& discId, const Disc& disc );
+
+private:
+    /** Loads the cache on first use */
+    void load();
+    void save();
+
+    /** QMap< disc id, tags > */
+    QMap<QString,Disc> discs;
+
+    QString fileName;
+    bool loaded;
+    bool changed;
+};
+
+#endif // DISCINFOCACHE_H
@@ -1,6 +1,7 @@
 
 #include "outputdirectory.h"
 #include "filelistitem.h"
+#include "outputpathtemplate.h"
 #include "core/conversionoptions.h"
 #include "config.h"
 
@@ -24,6 +25,9 @@
 #include <kmountpoint.h>
 
 
+QSet<QString> OutputDirectory::existingDirectories;
+
+
 OutputDirectory::OutputDirectory( Config *_config, QWidget *parent )
     : QWidget( parent ),
     config( _config )
@@ -120,8 +124,6 @@ QString OutputDirectory::filesystemForDirectory( const QString& dir )
 
 KUrl OutputDirectory::calcPath( FileListItem *fileListItem, Config *config, const QStringList& usedOutputNames )
 {
-    QRegExp regEx( "%[abcdfgnpsty]{1,1}", Qt::CaseInsensitive );
-
     const ConversionOptions *options = config->conversionOptionsManager()->getConversionOptions(fileListItem->conversionOptionsId);
     if( !options )
         return KUrl();
@@ -154,131 +156,14 @@ KUrl OutputDirectory::calcPath( FileListItem *fileListItem, Config *config, cons
 
         url = changeExtension( KUrl(path), extension );
 
-        if( config->data.general.conflictHandling == Config::Data::General::NewFileName )
+        if( config->data.general.conflictHandling == Config::Data::General::NewFileName && !isMirrorOutput(url,fileListItem,config,usedOutputNames) )
             url = uniqueFileName( url, usedOutputNames );
 
         return url;
     }
     else if( options->outputDirectoryMode == MetaData )
     {
-        path = options->outputDirectory;
-
-        // TODO a little bit redundant, adding %f if file name wasn't set properly
-        // TODO these restrictions could be a little bit over the top
-        if( path.right(1) == "/" )
-            path += "%f";
-        else if( path.lastIndexOf(regEx) < path.lastIndexOf("/") )
-            path += "/%f";
-
-        const int fileNameBegin = path.lastIndexOf("/");
-        if( fileListItem->tags == 0 ||
-            ( path.mid(fileNameBegin).contains("%n") && fileListItem->tags->track == 0 ) ||
-            ( path.mid(fileNameBegin).contains("%t") && fileListItem->tags->title.isEmpty() )
-          )
-        {
-            path = path.left( fileNameBegin ) + "/%f";
-        }
-
-        path.replace( "\\[", "$quared_bracket_open$" );
-        path.replace( "\\]", "$quared_bracket_close$" );
-
-        QRegExp reg( "\\[(.*)%([abcdfgnpsty])(.*)\\]", Qt::CaseInsensitive );
-        reg.setMinimal( true );
-        while( path.indexOf(reg) != -1 )
-        {
-            if( fileListItem->tags &&
-                (
-                  ( reg.cap(2) == "a" && !fileListItem->tags->artist.isEmpty() ) ||
-                  ( reg.cap(2) == "z" && !fileListItem->tags->albumArtist.isEmpty() ) ||
-                  ( reg.cap(2) == "b" && !fileListItem->tags->album.isEmpty() ) ||
-                  ( reg.cap(2) == "c" && !fileListItem->tags->comment.isEmpty() ) ||
-                  ( reg.cap(2) == "d" && fileListItem->tags->disc != 0 ) ||
-                  ( reg.cap(2) == "g" && !fileListItem->tags->genre.isEmpty() ) ||
-                  ( reg.cap(2) == "n" && fileListItem->tags->track != 0 ) ||
-                  ( reg.cap(2) == "p" && !fileListItem->tags->composer.isEmpty() ) ||
-                  ( reg.cap(2) == "t" && !fileListItem->tags->title.isEmpty() ) ||
-                  ( reg.cap(2) == "y" && fileListItem->tags->year != 0 )
-                )
-              )
-            {
-                path.replace( reg, "\\1%\\2\\3" );
-            }
-            else
-            {
-                path.replace( reg, "" );
-            }
-        }
-
-        path.replace( "$quared_bracket_open$", "[" );
-        path.replace( "$quared_bracket_close$", "]" );
-
-        while( path.contains("//") )
-            path.replace( "//", "/" );
-
-        path.replace( "%a", "$replace_by_artist$" );
-        path.replace( "%z", "$replace_by_albumartist$" );
-        path.replace( "%b", "$replace_by_album$" );
-        path.replace( "%c", "$replace_by_comment$" );
-        path.replace( "%d", "$replace_by_disc$" );
-        path.replace( "%g", "$replace_by_genre$" );
-        path.replace( "%n", "$replace_by_track$" );
-        path.replace( "%p", "$replace_by_composer$" );
-        path.replace( "%t", "$replace_by_title$" );
-        path.replace( "%y", "$replace_by_year$" );
-        path.replace( "%f", "$replace_by_filename$" );
-        path.replace( "%s", "$replace_by_sourcedir$" );
-
-        QString artist = ( fileListItem->tags == 0 || fileListItem->tags->artist.isEmpty() ) ? i18n("Unknown Artist") : fileListItem->tags->artist;
-        artist.replace("/",",");
-        path.replace( "$replace_by_artist$", artist );
-
-        QString albumArtist;
-        if( fileListItem->tags )
-        {
-            albumArtist = fileListItem->tags->albumArtist.isEmpty() ? fileListItem->tags->artist : fileListItem->tags->albumArtist;
-        }
-        if( albumArtist.isEmpty() )
-        {
-            albumArtist = i18n("Unknown Artist");
-        }
-        albumArtist.replace("/",",");
-        path.replace( "$replace_by_albumartist$", albumArtist );
-
-        QString album = ( fileListItem->tags == 0 || fileListItem->tags->album.isEmpty() ) ? i18n("Unknown Album") : fileListItem->tags->album;
-        album.replace("/",",");
-        path.replace( "$replace_by_album$", album );
-
-        QString comment = ( fileListItem->tags == 0 || fileListItem->tags->comment.isEmpty() ) ? i18n("No Comment") : fileListItem->tags->comment;
-        comment.replace("/",",");
-        path.replace( "$replace_by_comment$", comment );
-
-        QString disc = ( fileListItem->tags == 0 ) ? "0" : QString().sprintf("%i",fileListItem->tags->disc);
-        path.replace( "$replace_by_disc$", disc );
-
-        QString genre = ( fileListItem->tags == 0 || fileListItem->tags->genre.isEmpty() ) ? i18n("Unknown Genre") : fileListItem->tags->genre;
-        genre.replace("/",",");
-        path.replace( "$replace_by_genre$", genre );
-
-        QString track = ( fileListItem->tags == 0 ) ? "00" : QString().sprintf("%02i",fileListItem->tags->track);
-        path.replace( "$replace_by_track$", track );
-
-        QString composer = ( fileListItem->tags == 0 || fileListItem->tags->composer.isEmpty() ) ? i18n("Unknown Composer") : fileListItem->tags->composer;
-        composer.replace("/",",");
-        path.replace( "$replace_by_composer$", composer );
-
-        QString title = ( fileListItem->tags == 0 || fileListItem->tags->title.isEmpty() ) ? i18n("Unknown Title") : fileListItem->tags->title;
-        title.replace("/",",");
-        path.replace( "$replace_by_title$", title );
-
-        QString year = ( fileListItem->tags == 0 ) ? "0000" : QString().sprintf("%04i",fileListItem->tags->year);
-        path.replace( "$replace_by_year$", year );
-
-        QString filename = fileName.left( fileName.lastIndexOf(".") );
-        filename.replace("/",",");
-        path.replace( "$replace_by_filename$", filename );
-
-        QString sourcedir = fileListItem->url.directory();
-        path.replace( "$replace_by_sourcedir$", sourcedir );
+        path = OutputPathTemplate::compiled( options->outputDirectory ).render( fileListItem, fileName );
 
         if( config->data.general.useVFATNames || options->outputFilesystem == "vfat" )
             path = vfatPath( path );
@@ -288,7 +173,7 @@ KUrl OutputDirectory::calcPath( FileListItem *fileListItem, Config *config, cons
 
         url = KUrl( path + "." + extension );
 
-        if( config->data.general.conflictHandling == Config::Data::General::NewFileName )
+        if( config->data.general.conflictHandling == Config::Data::General::NewFileName && !isMirrorOutput(url,fileListItem,config,usedOutputNames) )
             url = uniqueFileName( url, usedOutputNames );
 
         return url;
@@ -313,7 +198,7 @@ KUrl OutputDirectory::calcPath( FileListItem *fileListItem, Config *config, cons
 
         url = changeExtension( KUrl(path), extension );
 
-        if( config->data.general.conflictHandling == Config::Data::General::NewFileName )
+        if( config->data.general.conflictHandling == Config::Data::General::NewFileName && !isMirrorOutput(url,fileListItem,config,usedOutputNames) )
             url = uniqueFileName( url, usedOutputNames );
 
         return url;
@@ -327,13 +212,28 @@ KUrl OutputDirectory::calcPath( FileListItem *fileListItem, Config *config, cons
 
         url = changeExtension( KUrl(path), extension );
 
-        if( config->data.general.conflictHandling == Config::Data::General::NewFileName )
+        if( config->data.general.conflictHandling == Config::Data::General::NewFileName && !isMirrorOutput(url,fileListItem,config,usedOutputNames) )
             url = uniqueFileName( url, usedOutputNames );
 
         return url;
     }
 }
 
+bool OutputDirectory::isMirrorOutput( const KUrl& url, FileListItem *fileListItem, Config *config, const QStringList& usedOutputNames )
+{
+    if( !config->data.general.mirrorSync || !fileListItem->local || fileListItem->track != -1 )
+        return false;
+
+    // never replace the source file or the output of a file that is being converted
+    const QString outputPath = url.toLocalFile();
+    if( outputPath == fileListItem->url.toLocalFile() || usedOutputNames.contains(outputPath) )
+        return false;
+
+    const QByteArray fingerprint = MirrorManifest::fingerprint( config->conversionOptionsManager()->getConversionOptions(fileListItem->conversionOptionsId) );
+
+    return config->mirrorManifest()->outputPath( fileListItem->url.toLocalFile(), fingerprint ) == outputPath;
+}
+
 KUrl OutputDirectory::changeExtension( const KUrl& url, const QString& extension )
 {
     KUrl changedUrl = url;
@@ -364,23 +264,65 @@ KUrl OutputDirectory::makePath( const KUrl& url )
 {
     QFileInfo fileInfo( url.toLocalFile() );
 
-    QStringList directories = fileInfo.absoluteDir().absolutePath().split( "/" );
-    QString mkDir;
+    if( !makeDirectory(fileInfo.absoluteDir().absolutePath()) )
+        return KUrl();
+
+    return url;
+}
+
+void OutputDirectory::invalidatePath( const KUrl& url )
+{
+    QFileInfo fileInfo( url.toLocalFile() );
+    forgetDirectory( fileInfo.absoluteDir().absolutePath() );
+}
+
+void OutputDirectory::forgetDirectory( const QString& directory )
+{
+    // forget the directory, its parents and its sub directories
+    QSet<QString>::iterator it = existingDirectories.begin();
+    while( it != existingDirectories.end() )
+    {
+        if( *it == directory || directory.startsWith(*it + "/") || (*it).startsWith(directory + "/") )
+            it = existingDirectories.erase( it );
+        else
+            ++it;
+    }
+}
+
+bool OutputDirectory::makeDirectory( const QString& directory )
+{
+    if( directory.isEmpty() || existingDirectories.contains(directory) )
+        return true;
+
+    // walk up to the first directory that exists
+    QStringList missingDirectories;
+    QString path = directory;
+    while( !path.isEmpty() && !existingDirectories.contains(path) && !QFileInfo(path).isDir() )
+    {
+        missingDirectories.prepend( path );
+        path = path.left( path.lastIndexOf("/") );
+    }
+
+    // if a directory exists, all of its parents exist as well
+    while( !path.isEmpty() && !existingDirectories.contains(path) )
+    {
+        existingDirectories.insert( path );
+        path = path.left( path.lastIndexOf("/") );
+    }
+
     QDir dir;
-    foreach( const QString& directory, directories )
+    foreach( const QString& mkDir, missingDirectories )
     {
-        mkDir += "/" + directory;
-        dir.setPath( mkDir );
-        if( !dir.exists() )
+        // the directory might have been created by someone else in the meantime
+        if( !dir.mkdir(mkDir) && !QFileInfo(mkDir).isDir() )
         {
-            if( !dir.mkdir(mkDir) )
-            {
-                return KUrl();
-            }
+            forgetDirectory( directory );
+            return false;
         }
+        existingDirectories.insert( mkDir );
     }
 
-    return url;
+    return true;
 }
 
 // from amarok 2.3.0
@@ -390,23 +332,35 @@ QString OutputDirectory::vfatPath( const QString& path )
 {
     QString s = path;
 
-    if( QDir::separator() == '/' ) // we are on *nix, \ is a valid character in file or directory names, NOT the dir separator
-        s.replace( '\\', '_' );
-    else
-        s.replace( '/', '_' ); // on windows we have to replace / instead
+    static QChar charMap[128];
+    static bool charMapInitialized = false;
+    if( !charMapInitialized )
+    {
+        for( int i = 0; i < 128; i++ )
+        {
+            QChar c = QChar( i );
+            if( c < QChar(0x20) || c == QChar(0x7F) // 0x7F = 127 = DEL control character
+                || c=='*' || c=='?' || c=='<' || c=='>'
+                || c=='|' || c=='"' || c==':' )
+                c = '_';
+            else if( c == '[' )
+                c = '(';
+            else if ( c == ']' )
+                c = ')';
+            else if( QDir::separator() == '/' && c == '\\' ) // we are on *nix, \ is a valid character in file or directory names, NOT the dir separator
+                c = '_';
+            else if( QDir::separator() != '/' && c == '/' ) // on windows we have to replace / instead
+                c = '_';
+            charMap[ i ] = c;
+        }
+        charMapInitialized = true;
+    }
 
     for( int i = 0; i < s.length(); i++ )
     {
-        QChar c = s[ i ];
-        if( c < QChar(0x20) || c == QChar(0x7F) // 0x7F = 127 = DEL control character
-            || c=='*' || c=='?' || c=='<' || c=='>'
-            || c=='|' || c=='"' || c==':' )
-            c = '_';
-        else if( c == '[' )
-            c = '(';
-        else if ( c == ']' )
-            c = ')';
-        s[ i ] = c;
+        const ushort c = s.at( i ).unicode();
+        if( c < 128 )
+            s[ i ] = charMap[ c ];
     }
 
     /* beware of reserved device names */
@@ -458,17 +412,29 @@ QString OutputDirectory::ntfsPath( const QString& path )
 {
     QString s = path;
 
-    if( QDir::separator() == '/' ) // we are on *nix, \ is a valid character in file or directory names, NOT the dir separator
-        s.replace( '\\', '_' );
-    else
-        s.replace( '/', '_' ); // on windows we have to replace / instead
+    static QChar charMap[128];
+    static bool charMapInitialized = false;
+    if( !charMapInitialized )
+    {
+        for( int i = 0; i < 128; i++ )
+        {
+            QChar c = QChar( i );
+            if( c=='*' || c=='?' || c=='<' || c=='>' || c=='|' || c=='"' || c==':' )
+                c = '_';
+            else if( QDir::separator() == '/' && c == '\\' ) // we are on *nix, \ is a valid character in file or directory names, NOT the dir separator
+                c = '_';
+            else if( QDir::separator() != '/' && c == '/' ) // on windows we have to replace / instead
+                c = '_';
+            charMap[ i ] = c;
+        }
+        charMapInitialized = true;
+    }
 
     for( int i = 0; i < s.length(); i++ )
     {
-        QChar c = s[ i ];
-        if( c=='*' || c=='?' || c=='<' || c=='>' || c=='|' || c=='"' || c==':' )
-            c = '_';
-        s[ i ] = c;
+        const ushort c = s.at( i ).unicode();
+        if( c < 128 )
+            s[ i ] = charMap[ c ];
     }
 
     /* max path length of Windows API */
@@ -4,6 +4,7 @@
 #define OUTPUTDIRECTORY_H
 
 #include <QWidget>
+#include <QSet>
 #include <KUrl>
 
 class FileListItem;
@@ -44,7 +45,11 @@ public:
     static KUrl calcPath( FileListItem *fileListItem, Config *config, const QStringList& usedOutputNames = QStringList() );
     static KUrl changeExtension( const KUrl& url, const QString& extension );
     static KUrl uniqueFileName( const KUrl& url, const QStringList& usedOutputNames );
+    /** Returns true if @p url is the output of an earlier conversion of @p fileListItem in mirror mode, so it can be replaced instead of being renamed */
+    static bool isMirrorOutput( const KUrl& url, FileListItem *fileListItem, Config *config, const QStringList& usedOutputNames = QStringList() );
     static KUrl makePath( const KUrl& url );
+    /** Forgets that the directory of @p url exists, so it will be checked again the next time (e.g. after writing to it has failed) */
+    static void invalidatePath( const KUrl& url );
     static QString vfatPath( const QString& path );
     static QString ntfsPath( const QString& path );
 
@@ -64,6 +69,14 @@ private:
 
     static QString filesystemForDirectory( const QString& dir = "" );
 
+    /** Creates @p directory and all missing parent directories */
+    static bool makeDirectory( const QString& directory );
+    /** Removes @p directory, its parents and its sub directories from existingDirectories */
+    static void forgetDirectory( const QString& directory );
+
+    /** all directories that are known to exist, so they don't need to be checked for every file */
+    static QSet<QString> existingDirectories;
+
     KComboBox *cMode;
     KComboBox *cDir;
     KPushButton *pDirSelect;
@@ -0,0 +1,309 @@
+
+#include "outputpathtemplate.h"
+#include "filelistitem.h"
+
+#include <QHash>
+#include <QRegExp>
+
+#include <KLocale>
+
+#include <cstring>
+
+
+// all wildcards that can be used in an output path pattern
+static const char *wildcards = "azbcdgnptyfs";
+
+static bool isWildcard( QChar c )
+{
+    const char latin1 = c.toLatin1();
+    return latin1 != 0 && strchr( wildcards, latin1 ) != 0;
+}
+
+static bool isEscapedBracket( const QString& pattern, int i )
+{
+    return pattern.at(i) == '\\' && i + 1 < pattern.length() && ( pattern.at(i+1) == '[' || pattern.at(i+1) == ']' );
+}
+
+/** returns the first wildcard in the optional group beginning at @p groupBegin or 0 if it's not a valid group */
+static char groupWildcard( const QString& pattern, int groupBegin )
+{
+    char wildcard = 0;
+
+    for( int i=groupBegin+1; i<pattern.length(); i++ )
+    {
+        if( isEscapedBracket(pattern,i) )
+        {
+            i++;
+        }
+        else if( pattern.at(i) == ']' )
+        {
+            return wildcard;
+        }
+        else if( pattern.at(i) == '%' && i + 1 < pattern.length() && isWildcard(pattern.at(i+1)) )
+        {
+            if( wildcard == 0 )
+                wildcard = pattern.at(i+1).toLatin1();
+
+            i++;
+        }
+    }
+
+    return 0; // no closing bracket
+}
+
+
+OutputPathTemplate::OutputPathTemplate()
+{
+    fileNameUsesTrack = false;
+    fileNameUsesTitle = false;
+}
+
+OutputPathTemplate::OutputPathTemplate( const QString& pattern )
+{
+    QRegExp regEx( "%[abcdfgnpsty]{1,1}", Qt::CaseInsensitive );
+
+    QString path = pattern;
+
+    // TODO a little bit redundant, adding %f if file name wasn't set properly
+    // TODO these restrictions could be a little bit over the top
+    if( path.right(1) == "/" )
+        path += "%f";
+    else if( path.lastIndexOf(regEx) < path.lastIndexOf("/") )
+        path += "/%f";
+
+    const int fileNameBegin = path.lastIndexOf("/");
+    fileNameUsesTrack = path.mid(fileNameBegin).contains("%n");
+    fileNameUsesTitle = path.mid(fileNameBegin).contains("%t");
+
+    program = compile( path );
+    fileNameProgram = compile( path.left(fileNameBegin) + "/%f" );
+
+    unknownArtist = i18n("Unknown Artist");
+    unknownAlbum = i18n("Unknown Album");
+    noComment = i18n("No Comment");
+    unknownGenre = i18n("Unknown Genre");
+    unknownComposer = i18n("Unknown Composer");
+    unknownTitle = i18n("Unknown Title");
+}
+
+OutputPathTemplate::~OutputPathTemplate()
+{}
+
+OutputPathTemplate OutputPathTemplate::compiled( const QString& pattern )
+{
+    static QHash<QString,OutputPathTemplate> templates;
+
+    if( !templates.contains(pattern) )
+        templates.insert( pattern, OutputPathTemplate(pattern) );
+
+    return templates.value( pattern );
+}
+
+QVector<OutputPathTemplate::Token> OutputPathTemplate::compile( const QString& pattern )
+{
+    QVector<Token> tokens;
+    QString literal;
+    int groupBegin = -1;
+
+    Token token;
+    token.wildcard = 0;
+    token.groupEnd = -1;
+
+    for( int i=0; i<pattern.length(); i++ )
+    {
+        const QChar c = pattern.at(i);
+
+        if( isEscapedBracket(pattern,i) )
+        {
+            literal += pattern.at(++i);
+            continue;
+        }
+
+        Token::Type type;
+        if( c == '%' && i + 1 < pattern.length() && isWildcard(pattern.at(i+1)) )
+        {
+            type = Token::Wildcard;
+            token.wildcard = pattern.at(++i).toLatin1();
+        }
+        else if( c == '[' && groupBegin == -1 && groupWildcard(pattern,i) != 0 )
+        {
+            type = Token::GroupBegin;
+            token.wildcard = groupWildcard( pattern, i );
+        }
+        else if( c == ']' && groupBegin != -1 )
+        {
+            type = Token::GroupEnd;
+            token.wildcard = 0;
+        }
+        else
+        {
+            literal += c;
+            continue;
+        }
+
+        if( !literal.isEmpty() )
+        {
+            // multiple slashes in the pattern are merged, slashes from the meta data are not
+            while( literal.contains("//") )
+                literal.replace( "//", "/" );
+
+            Token literalToken;
+            literalToken.type = Token::Literal;
+            literalToken.text = literal;
+            literalToken.wildcard = 0;
+            literalToken.groupEnd = -1;
+            tokens.append( literalToken );
+            literal.clear();
+        }
+
+        token.type = type;
+        if( type == Token::GroupBegin )
+        {
+            groupBegin = tokens.count();
+        }
+        else if( type == Token::GroupEnd )
+        {
+            tokens[groupBegin].groupEnd = tokens.count();
+            groupBegin = -1;
+        }
+        tokens.append( token );
+    }
+
+    if( !literal.isEmpty() )
+    {
+        while( literal.contains("//") )
+            literal.replace( "//", "/" );
+
+        token.type = Token::Literal;
+        token.text = literal;
+        token.wildcard = 0;
+        tokens.append( token );
+    }
+
+    return tokens;
+}
+
+bool OutputPathTemplate::hasValue( char wildcard, const TagData *tags )
+{
+    if( wildcard == 'f' || wildcard == 's' )
+        return true;
+
+    if( !tags )
+        return false;
+
+    switch( wildcard )
+    {
+        case 'a': return !tags->artist.isEmpty();
+        case 'z': return !tags->albumArtist.isEmpty();
+        case 'b': return !tags->album.isEmpty();
+        case 'c': return !tags->comment.isEmpty();
+        case 'd': return tags->disc != 0;
+        case 'g': return !tags->genre.isEmpty();
+        case 'n': return tags->track != 0;
+        case 'p': return !tags->composer.isEmpty();
+        case 't': return !tags->title.isEmpty();
+        case 'y': return tags->year != 0;
+    }
+
+    return false;
+}
+
+QString OutputPathTemplate::value( char wildcard, const FileListItem *fileListItem, const QString& fileName ) const
+{
+    const TagData *tags = fileListItem->tags;
+    QString value;
+
+    switch( wildcard )
+    {
+        case 'a':
+            value = ( tags == 0 || tags->artist.isEmpty() ) ? unknownArtist : tags->artist;
+            break;
+        case 'z':
+            if( tags )
+                value = tags->albumArtist.isEmpty() ? tags->artist : tags->albumArtist;
+            if( value.isEmpty() )
+                value = unknownArtist;
+            break;
+        case 'b':
+            value = ( tags == 0 || tags->album.isEmpty() ) ? unknownAlbum : tags->album;
+            break;
+        case 'c':
+            value = ( tags == 0 || tags->comment.isEmpty() ) ? noComment : tags->comment;
+            break;
+        case 'd':
+            return ( tags == 0 ) ? "0" : QString().sprintf("%i",tags->disc);
+        case 'g':
+            value = ( tags == 0 || tags->genre.isEmpty() ) ? unknownGenre : tags->genre;
+            break;
+        case 'n':
+            return ( tags == 0 ) ? "00" : QString().sprintf("%02i",tags->track);
+        case 'p':
+            value = ( tags == 0 || tags->composer.isEmpty() ) ? unknownComposer : tags->composer;
+            break;
+        case 't':
+            value = ( tags == 0 || tags->title.isEmpty() ) ? unknownTitle : tags->title;
+            break;
+        case 'y':
+            return ( tags == 0 ) ? "0000" : QString().sprintf("%04i",tags->year);
+        case 'f':
+            value = fileName.left( fileName.lastIndexOf(".") );
+            break;
+        case 's':
+            return fileListItem->url.directory();
+    }
+
+    value.replace( "/", "," );
+
+    return value;
+}
+
+QString OutputPathTemplate::render( const FileListItem *fileListItem, const QString& fileName ) const
+{
+    const TagData *tags = fileListItem->tags;
+
+    const bool useFileName = ( tags == 0 ||
+                               ( fileNameUsesTrack && tags->track == 0 ) ||
+                               ( fileNameUsesTitle && tags->title.isEmpty() ) );
+    const QVector<Token>& tokens = useFileName ? fileNameProgram : program;
+
+    QString path;
+    bool endsWithLiteralSlash = false;
+
+    for( int i=0; i<tokens.count(); i++ )
+    {
+        const Token& token = tokens.at(i);
+
+        switch( token.type )
+        {
+            case Token::Literal:
+            {
+                // merge slashes that only meet because an optional group has been removed
+                const int begin = ( endsWithLiteralSlash && token.text.at(0) == '/' ) ? 1 : 0;
+                if( token.text.length() > begin )
+                {
+                    path += token.text.mid( begin );
+                    endsWithLiteralSlash = token.text.endsWith( '/' );
+                }
+                break;
+            }
+            case Token::Wildcard:
+            {
+                path += value( token.wildcard, fileListItem, fileName );
+                endsWithLiteralSlash = false;
+                break;
+            }
+            case Token::GroupBegin:
+            {
+                if( !hasValue(token.wildcard,tags) )
+                    i = token.groupEnd;
+                break;
+            }
+            case Token::GroupEnd:
+            {
+                break;
+            }
+        }
+    }
+
+    return path;
+}
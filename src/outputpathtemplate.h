@@ -0,0 +1,67 @@
+
+#ifndef OUTPUTPATHTEMPLATE_H
+#define OUTPUTPATHTEMPLATE_H
+
+#include <QString>
+#include <QVector>
+
+class FileListItem;
+class TagData;
+
+
+/**
+ * @short A meta data output path pattern, parsed once and rendered for every file
+ *
+ * The pattern (e.g. "~/music/%b/[%d - ]%n - %t") is translated into a list of
+ * literal and wildcard tokens, so rendering the output path of a file
+ * doesn't need any regular expressions or string replacements.
+ */
+class OutputPathTemplate
+{
+public:
+    OutputPathTemplate();
+    explicit OutputPathTemplate( const QString& pattern );
+    ~OutputPathTemplate();
+
+    /** Returns the compiled template for @p pattern, the template gets compiled on first use only */
+    static OutputPathTemplate compiled( const QString& pattern );
+
+    /** Renders the path (without extension) for @p fileListItem, @p fileName is the original file name */
+    QString render( const FileListItem *fileListItem, const QString& fileName ) const;
+
+private:
+    struct Token
+    {
+        enum Type {
+            Literal,
+            Wildcard,
+            GroupBegin, // optional group, skipped if the wildcard is empty
+            GroupEnd
+        } type;
+        QString text;       // the text of a literal
+        char wildcard;      // the wildcard of a Wildcard or the decisive wildcard of a GroupBegin
+        int groupEnd;       // the index of the matching GroupEnd for a GroupBegin
+    };
+
+    static QVector<Token> compile( const QString& pattern );
+    static bool hasValue( char wildcard, const TagData *tags );
+    QString value( char wildcard, const FileListItem *fileListItem, const QString& fileName ) const;
+
+    /** the program for the whole pattern */
+    QVector<Token> program;
+    /** the program with the file name part replaced by %f, used if the file name can't be built from the tags */
+    QVector<Token> fileNameProgram;
+    /** does the file name part of the pattern use the track number or the title? */
+    bool fileNameUsesTrack;
+    bool fileNameUsesTitle;
+
+    /** translated placeholders for empty tags */
+    QString unknownArtist;
+    QString unknownAlbum;
+    QString noComment;
+    QString unknownGenre;
+    QString unknownComposer;
+    QString unknownTitle;
+};
+
+#endif // OUTPUTPATHTEMPLATE_H
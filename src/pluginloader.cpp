@@ -12,6 +12,7 @@
 #include "pluginloader.h"
 #include "logger.h"
 #include "config.h"
+#include "startuptrace.h"
 
 #include <QSet>
 #include <QFile>
@@ -109,6 +110,8 @@ void PluginLoader::addFormatInfo( const QString& codecName, BackendPlugin *plugi
 
 void PluginLoader::load()
 {
+    StartupTrace::Span loadSpan( "PluginLoader::load" );
+
     QTime overallTime;
     overallTime.start();
     QTime createInstanceTime;
@@ -119,12 +122,16 @@ void PluginLoader::load()
 
     logger->log( 1000, "\nloading plugins ..." );
 
+    // most of the time no backend has been installed or removed since the last start
+    BackendPlugin::loadBinaryCache();
+
     offers = KServiceTypeTrader::self()->query("soundKonverter/CodecPlugin");
 
     if( !offers.isEmpty() )
     {
         for( int i=0; i<offers.size(); i++ )
         {
+            StartupTrace::Span pluginSpan( offers.at(i)->library(), "plugin" );
             createInstanceTime.start();
             QVariantList allArgs;
             allArgs << offers.at(i)->storageId() << "";
@@ -185,6 +192,7 @@ void PluginLoader::load()
     {
         for( int i=0; i<offers.size(); i++ )
         {
+            StartupTrace::Span pluginSpan( offers.at(i)->library(), "plugin" );
             createInstanceTime.start();
             QVariantList allArgs;
             allArgs << offers.at(i)->storageId() << "";
@@ -246,6 +254,7 @@ void PluginLoader::load()
     {
         for( int i=0; i<offers.size(); i++ )
         {
+            StartupTrace::Span pluginSpan( offers.at(i)->library(), "plugin" );
             createInstanceTime.start();
             QVariantList allArgs;
             allArgs << offers.at(i)->storageId() << "";
@@ -282,6 +291,7 @@ void PluginLoader::load()
     {
         for( int i=0; i<offers.size(); i++ )
         {
+            StartupTrace::Span pluginSpan( offers.at(i)->library(), "plugin" );
             createInstanceTime.start();
             QVariantList allArgs;
             allArgs << offers.at(i)->storageId() << "";
@@ -313,6 +323,8 @@ void PluginLoader::load()
 
     conversionFilterPipeTrunks = conversionPipeTrunks + filterPipeTrunks;
 
+    BackendPlugin::saveBinaryCache();
+
     logger->log( 1000, QString("... all plugins loaded (took %1 ms, creating instances: %2 ms)").arg(overallTime.elapsed()).arg(createInstanceTimeSum) + "\n" );
 }
 
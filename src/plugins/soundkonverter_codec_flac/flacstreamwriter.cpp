@@ -0,0 +1,399 @@
+
+#include "flacstreamwriter.h"
+
+#include <string.h>
+
+
+// reserve some space so the tags can be written without rewriting the whole file
+#define PaddingSize 8192
+#define StreamInfoSize 34
+#define MetadataSize ( 4 + 4 + StreamInfoSize + 4 + PaddingSize )
+// a seek point every 10 seconds like flac does by default
+#define SeekPointInterval 10
+#define SeekPointSize 18
+// the seek table may take up to half of the padding, longer files get fewer seek points
+#define MaxSeekPoints ( ( PaddingSize / 2 - 4 ) / SeekPointSize )
+
+
+namespace
+{
+    struct FrameHeader
+    {
+        int length;             // including the crc
+        bool variableBlocking;
+        qint64 number;          // frame number for fixed, sample number for variable blocking
+        int numberOffset;       // the position of the coded number
+        int numberLength;
+        int blockSize;
+    };
+
+    quint8 crc8( const uchar *data, int size )
+    {
+        quint8 crc = 0;
+        for( int i=0; i<size; i++ )
+        {
+            crc ^= data[i];
+            for( int bit=0; bit<8; bit++ )
+                crc = ( crc & 0x80 ) ? ( crc << 1 ) ^ 0x07 : ( crc << 1 );
+        }
+        return crc;
+    }
+
+    class Crc16
+    {
+    public:
+        Crc16()
+        {
+            for( int i=0; i<256; i++ )
+            {
+                quint16 crc = i << 8;
+                for( int bit=0; bit<8; bit++ )
+                    crc = ( crc & 0x8000 ) ? ( crc << 1 ) ^ 0x8005 : ( crc << 1 );
+                table[i] = crc;
+            }
+        }
+
+        quint16 update( quint16 crc, uchar byte ) const
+        {
+            return ( crc << 8 ) ^ table[( crc >> 8 ) ^ byte];
+        }
+
+        quint16 calculate( const uchar *data, int size ) const
+        {
+            quint16 crc = 0;
+            for( int i=0; i<size; i++ )
+                crc = update( crc, data[i] );
+            return crc;
+        }
+
+    private:
+        quint16 table[256];
+    };
+
+    const Crc16 crc16;
+
+    /** Decodes the frame header at @p data, returns false if there's no valid header */
+    bool parseHeader( const uchar *data, qint64 available, FrameHeader *header )
+    {
+        if( available < 6 || data[0] != 0xFF || ( data[1] & 0xFE ) != 0xF8 )
+            return false;
+
+        const int blockSizeCode = data[2] >> 4;
+        const int sampleRateCode = data[2] & 0x0F;
+        const int channelCode = data[3] >> 4;
+        if( blockSizeCode == 0 || sampleRateCode == 15 || channelCode > 10 || ( data[3] & 0x01 ) )
+            return false;
+
+        header->variableBlocking = data[1] & 0x01;
+        header->numberOffset = 4;
+
+        // the number is coded like utf-8, but with up to 36 bits
+        int length;
+        if( ( data[4] & 0x80 ) == 0x00 )
+            length = 1;
+        else if( ( data[4] & 0xE0 ) == 0xC0 )
+            length = 2;
+        else if( ( data[4] & 0xF0 ) == 0xE0 )
+            length = 3;
+        else if( ( data[4] & 0xF8 ) == 0xF0 )
+            length = 4;
+        else if( ( data[4] & 0xFC ) == 0xF8 )
+            length = 5;
+        else if( ( data[4] & 0xFE ) == 0xFC )
+            length = 6;
+        else if( data[4] == 0xFE )
+            length = 7;
+        else
+            return false;
+
+        header->numberLength = length;
+        header->number = ( length == 1 ) ? data[4] : ( length == 7 ? 0 : data[4] & ( 0x3F >> ( length - 1 ) ) );
+        int position = 5;
+        for( int i=1; i<length; i++ )
+        {
+            if( position >= available || ( data[position] & 0xC0 ) != 0x80 )
+                return false;
+            header->number = ( header->number << 6 ) | ( data[position] & 0x3F );
+            position++;
+        }
+
+        if( blockSizeCode == 1 )
+        {
+            header->blockSize = 192;
+        }
+        else if( blockSizeCode <= 5 )
+        {
+            header->blockSize = 576 << ( blockSizeCode - 2 );
+        }
+        else if( blockSizeCode == 6 )
+        {
+            if( position + 1 > available )
+                return false;
+            header->blockSize = data[position] + 1;
+            position += 1;
+        }
+        else if( blockSizeCode == 7 )
+        {
+            if( position + 2 > available )
+                return false;
+            header->blockSize = ( ( data[position] << 8 ) | data[position+1] ) + 1;
+            position += 2;
+        }
+        else
+        {
+            header->blockSize = 256 << ( blockSizeCode - 8 );
+        }
+
+        if( sampleRateCode == 12 )
+            position += 1;
+        else if( sampleRateCode == 13 || sampleRateCode == 14 )
+            position += 2;
+
+        if( position + 1 > available || crc8(data,position) != data[position] )
+            return false;
+
+        header->length = position + 1;
+
+        return true;
+    }
+
+    void writeNumber( QByteArray *data, qint64 number )
+    {
+        if( number < 0x80 )
+        {
+            data->append( (char)number );
+            return;
+        }
+
+        int length = 2;
+        while( length < 7 && number >= ( Q_INT64_C(1) << ( 5 * length + 1 ) ) )
+            length++;
+
+        const uchar first = ( length == 7 ) ? 0xFE : (uchar)( ( 0xFF00 >> length ) & 0xFF );
+        data->append( (char)( first | ( length == 7 ? 0 : number >> ( 6 * ( length - 1 ) ) ) ) );
+        for( int i=length-2; i>=0; i-- )
+            data->append( (char)( 0x80 | ( ( number >> ( 6 * i ) ) & 0x3F ) ) );
+    }
+}
+
+
+FlacStreamWriter::FlacStreamWriter()
+    : formatKnown( false ),
+    blockSize( 0 ),
+    minFrameSize( 0 ),
+    maxFrameSize( 0 ),
+    frameNumber( 0 ),
+    samples( 0 ),
+    lastBlockShort( false ),
+    audioSize( 0 )
+{}
+
+FlacStreamWriter::~FlacStreamWriter()
+{}
+
+bool FlacStreamWriter::open( const QString& fileName )
+{
+    file.setFileName( fileName );
+    if( !file.open(QIODevice::WriteOnly | QIODevice::Truncate) )
+        return false;
+
+    // the metadata gets written by close()
+    const QByteArray metadata( MetadataSize, 0 );
+    return file.write( metadata ) == metadata.size();
+}
+
+bool FlacStreamWriter::appendSegment( const uchar *data, qint64 size )
+{
+    if( size < 4 + 4 + StreamInfoSize || qstrncmp(reinterpret_cast<const char*>(data),"fLaC",4) != 0 )
+        return false;
+
+    // skip the metadata blocks, the first one is always the STREAMINFO block
+    qint64 position = 4;
+    const uchar *streamInfo = data + position + 4;
+    bool lastBlock = false;
+    while( !lastBlock )
+    {
+        if( position + 4 > size )
+            return false;
+
+        lastBlock = data[position] & 0x80;
+        position += 4 + ( ( data[position+1] << 16 ) | ( data[position+2] << 8 ) | data[position+3] );
+    }
+
+    const uchar segmentFormat[4] = { streamInfo[10], streamInfo[11], streamInfo[12], (uchar)( streamInfo[13] & 0xF0 ) };
+    if( !formatKnown )
+    {
+        memcpy( format, segmentFormat, 4 );
+        formatKnown = true;
+    }
+    else if( memcmp(format,segmentFormat,4) != 0 )
+    {
+        return false;
+    }
+
+    FrameHeader header;
+    if( !parseHeader(data + position, size - position, &header) )
+        return false;
+
+    while( position < size )
+    {
+        // the frame ends where the next header starts and the crc of the frame matches
+        const qint64 frameStart = position;
+        const qint64 expectedNumber = header.variableBlocking ? header.number + header.blockSize : header.number + 1;
+        FrameHeader nextHeader;
+        bool nextFound = false;
+        quint16 crc = 0;
+        for( position = frameStart; position < size; position++ )
+        {
+            if( data[position] == 0xFF && crc == 0 && position > frameStart + header.length && parseHeader(data + position, size - position, &nextHeader) && nextHeader.number == expectedNumber )
+            {
+                nextFound = true;
+                break;
+            }
+            crc = crc16.update( crc, data[position] );
+        }
+
+        if( !nextFound && crc != 0 )
+            return false;
+
+        if( !appendFrame(data + frameStart, position - frameStart) )
+            return false;
+
+        if( nextFound )
+            header = nextHeader;
+    }
+
+    return true;
+}
+
+bool FlacStreamWriter::appendFrame( const uchar *data, int size )
+{
+    FrameHeader header;
+    if( !parseHeader(data, size, &header) || size < header.length + 2 )
+        return false;
+
+    // only the last frame of the stream may be shorter than the others
+    if( lastBlockShort )
+        return false;
+
+    if( blockSize == 0 )
+        blockSize = header.blockSize;
+    else if( header.blockSize > blockSize )
+        return false;
+
+    if( header.blockSize < blockSize )
+        lastBlockShort = true;
+
+    frameBuffer.resize( 0 );
+    frameBuffer.append( reinterpret_cast<const char*>(data), header.numberOffset );
+    writeNumber( &frameBuffer, header.variableBlocking ? samples : frameNumber );
+    const int extraOffset = header.numberOffset + header.numberLength;
+    frameBuffer.append( reinterpret_cast<const char*>(data) + extraOffset, header.length - 1 - extraOffset );
+    frameBuffer.append( (char)crc8(reinterpret_cast<const uchar*>(frameBuffer.constData()),frameBuffer.size()) );
+    frameBuffer.append( reinterpret_cast<const char*>(data) + header.length, size - header.length - 2 );
+    const quint16 crc = crc16.calculate( reinterpret_cast<const uchar*>(frameBuffer.constData()), frameBuffer.size() );
+    frameBuffer.append( (char)( crc >> 8 ) );
+    frameBuffer.append( (char)( crc & 0xFF ) );
+
+    const int sampleRate = ( format[0] << 12 ) | ( format[1] << 4 ) | ( format[2] >> 4 );
+    if( sampleRate > 0 && samples >= (qint64)seekPoints.count() * SeekPointInterval * sampleRate )
+    {
+        SeekPoint point;
+        point.sample = samples;
+        point.offset = audioSize;
+        point.frameSamples = header.blockSize;
+        seekPoints.append( point );
+    }
+
+    if( file.write(frameBuffer) != frameBuffer.size() )
+        return false;
+
+    audioSize += frameBuffer.size();
+
+    if( minFrameSize == 0 || frameBuffer.size() < minFrameSize )
+        minFrameSize = frameBuffer.size();
+    if( frameBuffer.size() > maxFrameSize )
+        maxFrameSize = frameBuffer.size();
+
+    frameNumber++;
+    samples += header.blockSize;
+
+    return true;
+}
+
+bool FlacStreamWriter::close( const QByteArray& md5 )
+{
+    if( !file.isOpen() )
+        return false;
+
+    if( !formatKnown || md5.size() != 16 )
+    {
+        file.close();
+        return false;
+    }
+
+    QByteArray metadata( MetadataSize, 0 );
+    uchar *d = reinterpret_cast<uchar*>(metadata.data());
+
+    memcpy( d, "fLaC", 4 );
+
+    // STREAMINFO
+    d[4] = 0x00;
+    d[7] = StreamInfoSize;
+    uchar *info = d + 8;
+    info[0] = blockSize >> 8;
+    info[1] = blockSize;
+    info[2] = blockSize >> 8;
+    info[3] = blockSize;
+    info[4] = minFrameSize >> 16;
+    info[5] = minFrameSize >> 8;
+    info[6] = minFrameSize;
+    info[7] = maxFrameSize >> 16;
+    info[8] = maxFrameSize >> 8;
+    info[9] = maxFrameSize;
+    info[10] = format[0];
+    info[11] = format[1];
+    info[12] = format[2];
+    info[13] = format[3] | ( ( samples >> 32 ) & 0x0F );
+    info[14] = samples >> 24;
+    info[15] = samples >> 16;
+    info[16] = samples >> 8;
+    info[17] = samples;
+    memcpy( info + 18, md5.constData(), 16 );
+
+    // SEEKTABLE, every n-th point is used if there are too many
+    const int step = ( seekPoints.count() + MaxSeekPoints - 1 ) / MaxSeekPoints;
+    const int pointCount = step > 0 ? ( seekPoints.count() + step - 1 ) / step : 0;
+    const int seekTableSize = pointCount * SeekPointSize;
+    uchar *seekTable = info + StreamInfoSize;
+    seekTable[0] = 0x03;
+    seekTable[1] = seekTableSize >> 16;
+    seekTable[2] = seekTableSize >> 8;
+    seekTable[3] = seekTableSize & 0xFF;
+    uchar *point = seekTable + 4;
+    for( int i=0; i<seekPoints.count(); i+=step )
+    {
+        const SeekPoint& seekPoint = seekPoints.at(i);
+        for( int j=0; j<8; j++ )
+        {
+            point[j] = seekPoint.sample >> ( 56 - 8 * j );
+            point[8+j] = seekPoint.offset >> ( 56 - 8 * j );
+        }
+        point[16] = seekPoint.frameSamples >> 8;
+        point[17] = seekPoint.frameSamples;
+        point += SeekPointSize;
+    }
+
+    // PADDING, the last metadata block, gets what's left of the reserved space
+    const int paddingSize = PaddingSize - 4 - seekTableSize;
+    uchar *padding = point;
+    padding[0] = 0x81;
+    padding[1] = paddingSize >> 16;
+    padding[2] = paddingSize >> 8;
+    padding[3] = paddingSize & 0xFF;
+
+    const bool success = file.seek( 0 ) && file.write( metadata ) == metadata.size() && file.flush();
+    file.close();
+
+    return success;
+}
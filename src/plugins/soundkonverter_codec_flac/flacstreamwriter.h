@@ -0,0 +1,64 @@
+
+#ifndef FLACSTREAMWRITER_H
+#define FLACSTREAMWRITER_H
+
+#include <QFile>
+
+
+/**
+ * @short Joins separately encoded flac files into one stream
+ *
+ * The audio frames of all segments are copied behind each other, their frame numbers get
+ * renumbered and the checksums of the frames recalculated. The STREAMINFO and SEEKTABLE blocks
+ * get written last, since they contain the total length, the frame sizes and offsets and the
+ * MD5 sum of the audio. The seek table takes its space from the padding.
+ * All segments except the last one must contain a multiple of the fixed block size.
+ */
+class FlacStreamWriter
+{
+public:
+    FlacStreamWriter();
+    ~FlacStreamWriter();
+
+    /** Creates @p fileName and reserves the space for the metadata */
+    bool open( const QString& fileName );
+    /** Appends the audio frames of the flac file @p data, returns false if it isn't a valid flac file or if its format differs */
+    bool appendSegment( const uchar *data, qint64 size );
+    /** Writes the STREAMINFO block with the MD5 sum @p md5 of the unencoded audio and the SEEKTABLE block */
+    bool close( const QByteArray& md5 );
+
+    /** The number of samples per channel written so far */
+    qint64 sampleCount() const { return samples; }
+
+private:
+    /** Copies the frame @p data with a new frame number */
+    bool appendFrame( const uchar *data, int size );
+
+    struct SeekPoint
+    {
+        qint64 sample;
+        /** the position of the frame relative to the first frame */
+        qint64 offset;
+        int frameSamples;
+    };
+
+    QFile file;
+
+    bool formatKnown;
+    /** the sample rate, channels and bits per sample as stored in the STREAMINFO block */
+    uchar format[4];
+    int blockSize;
+    int minFrameSize;
+    int maxFrameSize;
+    qint64 frameNumber;
+    qint64 samples;
+    bool lastBlockShort;
+    /** the number of bytes of all frames written so far */
+    qint64 audioSize;
+    /** the first frame of every SeekPointInterval seconds */
+    QList<SeekPoint> seekPoints;
+
+    QByteArray frameBuffer;
+};
+
+#endif // FLACSTREAMWRITER_H
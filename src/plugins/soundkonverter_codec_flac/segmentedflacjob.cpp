@@ -0,0 +1,314 @@
+
+#include "segmentedflacjob.h"
+#include "flacstreamwriter.h"
+#include "../../core/wavfile.h"
+
+#include <KLocale>
+#include <KProcess>
+#include <KStandardDirs>
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QtConcurrentRun>
+
+
+// the number of frames that get hashed at once
+#define Md5BlockSize (64*1024)
+// the share of the encoding in the total progress, the rest is joining the segments
+#define EncodeShare 0.95f
+
+
+// the segment files of different jobs must not collide, the encoders create them only after the job has been started
+static int jobCounter = 0;
+
+
+SegmentedFlacJob::SegmentedFlacJob( const QString& _binary, const QStringList& _arguments, const QString& _inputFile, const QString& _outputFile, qint64 frameCount, int blockSize, int segmentCount, QObject *parent )
+    : QObject( parent ),
+    binary( _binary ),
+    arguments( _arguments ),
+    inputFile( _inputFile ),
+    outputFile( _outputFile ),
+    runningProcesses( 0 ),
+    joining( false ),
+    error( NoError ),
+    joinProgress( 0 ),
+    canceled( 0 )
+{
+    connect( &md5Watcher, SIGNAL(finished()), this, SLOT(md5Finished()) );
+    connect( &joinWatcher, SIGNAL(finished()), this, SLOT(joinFinished()) );
+
+    // all segments except the last one must end on a block boundary
+    const qint64 blocks = ( frameCount + blockSize - 1 ) / blockSize;
+    const qint64 segmentLength = qMax( (qint64)1, ( blocks + segmentCount - 1 ) / segmentCount ) * blockSize;
+
+    const int jobNumber = jobCounter++;
+    int fileNumber = 0;
+
+    for( qint64 start=0; start<frameCount; start+=segmentLength )
+    {
+        // the segments are temporary files, they don't belong into the output directory
+        QString segmentFile;
+        do {
+            segmentFile = KStandardDirs::locateLocal( "tmp", QString("soundkonverter_temp_flacsegment_%1_%2.flac").arg(jobNumber).arg(fileNumber) );
+            fileNumber++;
+        } while( QFile::exists(segmentFile) );
+
+        QStringList segment = arguments;
+        segment += "--blocksize=" + QString::number(blockSize);
+        segment += "--no-padding";
+        segment += "--no-seektable";
+        segment += "--skip=" + QString::number(start);
+        if( start + segmentLength < frameCount )
+            segment += "--until=" + QString::number(start + segmentLength);
+        segment += inputFile;
+        segment += "-o";
+        segment += segmentFile;
+
+        segmentFiles += segmentFile;
+        segmentArguments += segment;
+    }
+
+    segmentProgress.fill( 0.0f, segmentFiles.count() );
+}
+
+SegmentedFlacJob::~SegmentedFlacJob()
+{
+    canceled = 1;
+
+    foreach( KProcess *process, processes )
+    {
+        process->disconnect( this );
+        process->kill();
+        process->waitForFinished();
+    }
+
+    md5Watcher.waitForFinished();
+    joinWatcher.waitForFinished();
+
+    cleanUp();
+}
+
+void SegmentedFlacJob::start()
+{
+    md5Watcher.setFuture( QtConcurrent::run(this,&SegmentedFlacJob::calculateMd5) );
+
+    for( int i=0; i<segmentArguments.count(); i++ )
+    {
+        KProcess *process = new KProcess( this );
+        process->setOutputChannelMode( KProcess::MergedChannels );
+        connect( process, SIGNAL(readyRead()), this, SLOT(processOutput()) );
+        connect( process, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(processExit(int,QProcess::ExitStatus)) );
+        process->setProgram( binary, segmentArguments.at(i) );
+        process->start();
+
+        processes.append( process );
+        runningProcesses++;
+    }
+}
+
+void SegmentedFlacJob::kill()
+{
+    canceled = 1;
+
+    foreach( KProcess *process, processes )
+        process->kill();
+}
+
+QStringList SegmentedFlacJob::commands() const
+{
+    QStringList list;
+
+    foreach( const QStringList& segment, segmentArguments )
+    {
+        QStringList command;
+        command += binary;
+        foreach( const QString& argument, segment )
+            command += argument.contains(" ") ? "\"" + argument + "\"" : argument;
+
+        list += command.join(" ");
+    }
+
+    return list;
+}
+
+float SegmentedFlacJob::progress() const
+{
+    float encoded = 0.0f;
+    foreach( float segment, segmentProgress )
+        encoded += segment;
+
+    if( !segmentProgress.isEmpty() )
+        encoded /= segmentProgress.count();
+
+    return encoded * EncodeShare + (int)joinProgress / 10.0f * ( 1.0f - EncodeShare );
+}
+
+QString SegmentedFlacJob::errorString() const
+{
+    switch( error )
+    {
+        case NoError:
+            return QString();
+        case InputError:
+            return i18n("Can't read the input file");
+        case OutputError:
+            return i18n("Can't join the encoded segments");
+        case EncoderError:
+            return encoderOutput;
+        case Canceled:
+            return i18n("Canceled");
+    }
+    return QString();
+}
+
+void SegmentedFlacJob::processOutput()
+{
+    KProcess *process = qobject_cast<KProcess*>(sender());
+    const int index = processes.indexOf( process );
+    if( index < 0 )
+        return;
+
+    const QString output = process->readAllStandardOutput().data();
+
+    // 01-Unknown.wav: 98% complete, ratio=0,479
+    QRegExp regEnc("(\\d+)% complete");
+    if( output.lastIndexOf(regEnc) >= 0 )
+        segmentProgress[index] = (float)regEnc.cap(1).toInt();
+
+    // keep the messages of the encoder for the log in case it fails
+    encoderOutput = output.trimmed().isEmpty() ? encoderOutput : output.trimmed();
+}
+
+void SegmentedFlacJob::processExit( int exitCode, QProcess::ExitStatus exitStatus )
+{
+    runningProcesses--;
+
+    if( ( exitCode != 0 || exitStatus != QProcess::NormalExit ) && error == NoError )
+    {
+        error = (int)canceled ? Canceled : EncoderError;
+        kill();
+    }
+
+    tryJoin();
+}
+
+void SegmentedFlacJob::md5Finished()
+{
+    tryJoin();
+}
+
+void SegmentedFlacJob::tryJoin()
+{
+    if( joining || runningProcesses > 0 || !md5Watcher.isFinished() )
+        return;
+
+    joining = true;
+
+    if( error == NoError )
+    {
+        md5 = md5Watcher.result();
+
+        if( (int)canceled )
+            error = Canceled;
+        else if( md5.isEmpty() )
+            error = InputError;
+    }
+
+    if( error != NoError )
+    {
+        cleanUp();
+        QFile::remove( outputFile );
+        emit finished( this );
+        return;
+    }
+
+    joinWatcher.setFuture( QtConcurrent::run(this,&SegmentedFlacJob::join) );
+}
+
+void SegmentedFlacJob::joinFinished()
+{
+    error = joinWatcher.result();
+
+    cleanUp();
+
+    if( error != NoError )
+        QFile::remove( outputFile );
+
+    emit finished( this );
+}
+
+void SegmentedFlacJob::cleanUp()
+{
+    foreach( const QString& segmentFile, segmentFiles )
+        QFile::remove( segmentFile );
+}
+
+QByteArray SegmentedFlacJob::calculateMd5()
+{
+    WavFile input;
+    if( !input.openRead(inputFile) || input.sampleFormat() != WavFile::Integer )
+        return QByteArray();
+
+    // flac hashes the samples as signed little endian integers
+    const bool isUnsigned = ( input.bitsPerSample() == 8 );
+    const int frameSize = input.bitsPerSample() / 8 * input.channels();
+
+    QCryptographicHash hash( QCryptographicHash::Md5 );
+    QByteArray buffer( Md5BlockSize * frameSize, 0 );
+
+    while( true )
+    {
+        if( (int)canceled )
+            return QByteArray();
+
+        const int count = input.readRaw( buffer.data(), Md5BlockSize );
+        if( count < 0 )
+            return QByteArray();
+        if( count == 0 )
+            break;
+
+        if( isUnsigned )
+        {
+            char *data = buffer.data();
+            for( int i=0; i<count*frameSize; i++ )
+                data[i] ^= 0x80;
+        }
+
+        hash.addData( buffer.constData(), count * frameSize );
+    }
+
+    return hash.result();
+}
+
+SegmentedFlacJob::Error SegmentedFlacJob::join()
+{
+    FlacStreamWriter writer;
+    if( !writer.open(outputFile) )
+        return OutputError;
+
+    for( int i=0; i<segmentFiles.count(); i++ )
+    {
+        if( (int)canceled )
+            return Canceled;
+
+        QFile segment( segmentFiles.at(i) );
+        if( !segment.open(QIODevice::ReadOnly) )
+            return OutputError;
+
+        uchar *data = segment.map( 0, segment.size() );
+        if( !data )
+            return OutputError;
+
+        const bool appended = writer.appendSegment( data, segment.size() );
+        segment.unmap( data );
+        if( !appended )
+            return OutputError;
+
+        joinProgress = ( i + 1 ) * 1000 / segmentFiles.count();
+    }
+
+    if( !writer.close(md5) )
+        return OutputError;
+
+    return NoError;
+}
@@ -0,0 +1,100 @@
+
+#ifndef SEGMENTEDFLACJOB_H
+#define SEGMENTEDFLACJOB_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QFutureWatcher>
+#include <QProcess>
+#include <QStringList>
+#include <QVector>
+
+class KProcess;
+
+
+/**
+ * @short Encodes a long wav file with several flac processes at once
+ *
+ * Every process encodes one segment of the input file into a temporary flac file. While they
+ * run, the MD5 sum of the audio gets calculated in a separate thread. Finally the frames of
+ * all segments get joined into the output file by FlacStreamWriter.
+ * All segments except the last one are a multiple of the block size long, so the joined
+ * stream is the same as if it had been encoded by a single process.
+ */
+class SegmentedFlacJob : public QObject
+{
+    Q_OBJECT
+public:
+    enum Error
+    {
+        NoError = 0,
+        InputError,
+        OutputError,
+        EncoderError,
+        Canceled
+    };
+
+    /**
+     * @p arguments are the options passed to every flac process,
+     * @p frameCount is the length of the input file in samples per channel
+     */
+    SegmentedFlacJob( const QString& _binary, const QStringList& _arguments, const QString& _inputFile, const QString& _outputFile, qint64 frameCount, int blockSize, int segmentCount, QObject *parent );
+    /** Kills the encoders and waits for the worker threads to return */
+    ~SegmentedFlacJob();
+
+    void start();
+    void kill();
+
+    /** The number of flac processes */
+    int segmentCount() const { return segmentFiles.count(); }
+    /** The command lines of the flac processes */
+    QStringList commands() const;
+
+    /** The progress in percent */
+    float progress() const;
+    bool success() const { return error == NoError; }
+    QString errorString() const;
+
+signals:
+    void finished( SegmentedFlacJob *job );
+
+private slots:
+    void processOutput();
+    void processExit( int exitCode, QProcess::ExitStatus exitStatus );
+    void md5Finished();
+    void joinFinished();
+
+private:
+    /** Starts joining the segments as soon as all encoders and the MD5 calculation have finished */
+    void tryJoin();
+    void cleanUp();
+
+    /** Runs in a worker thread, returns an empty array on failure */
+    QByteArray calculateMd5();
+    /** Runs in a worker thread */
+    Error join();
+
+    QString binary;
+    QStringList arguments;
+    QString inputFile;
+    QString outputFile;
+
+    QList<KProcess*> processes;
+    QStringList segmentFiles;
+    QList<QStringList> segmentArguments;
+    QVector<float> segmentProgress;
+    int runningProcesses;
+    bool joining;
+
+    Error error;
+    QString encoderOutput;
+    QByteArray md5;
+
+    /** per mille */
+    QAtomicInt joinProgress;
+    QAtomicInt canceled;
+    QFutureWatcher<QByteArray> md5Watcher;
+    QFutureWatcher<Error> joinWatcher;
+};
+
+#endif // SEGMENTEDFLACJOB_H
@@ -3,7 +3,17 @@
 
 #include "soundkonverter_codec_flac.h"
 #include "../../core/conversionoptions.h"
+#include "../../core/wavfile.h"
 #include "flaccodecwidget.h"
+#include "segmentedflacjob.h"
+
+#include <KLocale>
+
+
+// files longer than this get encoded in segments by several flac processes (in seconds)
+#define MinimumSegmentedLength 600
+// shorter segments don't pay off the overhead of joining them (in seconds)
+#define MinimumSegmentLength 120
 
 
 soundkonverter_codec_flac::soundkonverter_codec_flac( QObject *parent, const QStringList& args  )
@@ -74,6 +84,32 @@ void soundkonverter_codec_flac::showInfo( QWidget *parent )
     Q_UNUSED(parent)
 }
 
+bool soundkonverter_codec_flac::kill( int id )
+{
+    if( !jobs.contains(id) )
+        return CodecPlugin::kill( id );
+
+    jobs.value(id)->kill();
+    emit log( id, "<pre>\t" + i18n("Killing process on user request") + "</pre>" );
+    return true;
+}
+
+float soundkonverter_codec_flac::progress( int id )
+{
+    if( !jobs.contains(id) )
+        return CodecPlugin::progress( id );
+
+    return jobs.value(id)->progress();
+}
+
+int soundkonverter_codec_flac::threadCount( int id )
+{
+    if( !jobs.contains(id) )
+        return CodecPlugin::threadCount( id );
+
+    return jobs.value(id)->segmentCount();
+}
+
 CodecWidget *soundkonverter_codec_flac::newCodecWidget()
 {
     FlacCodecWidget *widget = new FlacCodecWidget();
@@ -82,6 +118,13 @@ CodecWidget *soundkonverter_codec_flac::newCodecWidget()
 
 int soundkonverter_codec_flac::convert( const KUrl& inputFile, const KUrl& outputFile, const QString& inputCodec, const QString& outputCodec, const ConversionOptions *_conversionOptions, TagData *tags, bool replayGain )
 {
+    if( _conversionOptions && inputCodec == "wav" && outputCodec == "flac" )
+    {
+        const int id = convertSegmented( inputFile, outputFile, _conversionOptions, replayGain );
+        if( id >= 0 )
+            return id;
+    }
+
     QStringList command = convertCommand( inputFile, outputFile, inputCodec, outputCodec, _conversionOptions, tags, replayGain );
     if( command.isEmpty() )
         return BackendPlugin::UnknownError;
@@ -103,6 +146,78 @@ int soundkonverter_codec_flac::convert( const KUrl& inputFile, const KUrl& outpu
     return newItem->id;
 }
 
+int soundkonverter_codec_flac::convertSegmented( const KUrl& inputFile, const KUrl& outputFile, const ConversionOptions *conversionOptions, bool replayGain )
+{
+    // the replay gain has to be calculated over the whole file
+    if( !inputFile.isLocalFile() || !outputFile.isLocalFile() || ( conversionOptions->replaygain && replayGain ) )
+        return -1;
+
+    if( threadLimit < 2 )
+        return -1;
+
+    WavFile input;
+    if( !input.openRead(inputFile.toLocalFile()) || input.sampleFormat() != WavFile::Integer || input.bitsPerSample() > 24 )
+        return -1;
+
+    if( input.frameCount() < (qint64)MinimumSegmentedLength * input.sampleRate() )
+        return -1;
+
+    const int segmentCount = (int)qMin( (qint64)threadLimit, input.frameCount() / ( (qint64)MinimumSegmentLength * input.sampleRate() ) );
+    if( segmentCount < 2 )
+        return -1;
+
+    int compressionLevel = 5;
+    QStringList arguments;
+    arguments += "-V";
+    if( conversionOptions->pluginName == global_plugin_name )
+    {
+        compressionLevel = (int)conversionOptions->compressionLevel;
+        arguments += "--compression-level-"+QString::number(compressionLevel);
+    }
+
+    // the same block size flac uses for the compression level, so the output doesn't change
+    const int blockSize = ( compressionLevel <= 2 ) ? 1152 : 4096;
+
+    CodecPluginItem *newItem = new CodecPluginItem( this );
+    newItem->id = lastId++;
+    newItem->process = 0;
+
+    SegmentedFlacJob *job = new SegmentedFlacJob( binaries["flac"], arguments, inputFile.toLocalFile(), outputFile.toLocalFile(), input.frameCount(), blockSize, segmentCount, newItem );
+    connect( job, SIGNAL(finished(SegmentedFlacJob*)), this, SLOT(segmentedFinished(SegmentedFlacJob*)) );
+    jobs.insert( newItem->id, job );
+    job->start();
+
+    foreach( const QString& command, job->commands() )
+        logCommand( newItem->id, command );
+
+    backendItems.append( newItem );
+    return newItem->id;
+}
+
+void soundkonverter_codec_flac::segmentedFinished( SegmentedFlacJob *job )
+{
+    const int id = jobs.key( job );
+    jobs.remove( id );
+
+    if( job->success() )
+        logOutput( id, i18n("Joined the encoded segments") );
+    else
+        logOutput( id, job->errorString() );
+
+    for( int i=0; i<backendItems.size(); i++ )
+    {
+        if( backendItems.at(i)->id == id )
+        {
+            emit jobFinished( id, job->success() ? 0 : 1 );
+
+            backendItems.at(i)->deleteLater();
+            backendItems.removeAt(i);
+
+            return;
+        }
+    }
+}
+
 QStringList soundkonverter_codec_flac::convertCommand( const KUrl& inputFile, const KUrl& outputFile, const QString& inputCodec, const QString& outputCodec, const ConversionOptions *_conversionOptions, TagData *tags, bool replayGain )
 {
     Q_UNUSED(inputCodec)
@@ -5,6 +5,7 @@
 #include "../../core/codecplugin.h"
 
 class ConversionOptions;
+class SegmentedFlacJob;
 
 
 class soundkonverter_codec_flac : public CodecPlugin
@@ -25,12 +26,25 @@ public:
     void showConfigDialog( ActionType action, const QString& codecName, QWidget *parent );
     bool hasInfo();
     void showInfo( QWidget *parent );
+    bool kill( int id );
+    float progress( int id );
+    int threadCount( int id );
 
     CodecWidget *newCodecWidget();
 
     int convert( const KUrl& inputFile, const KUrl& outputFile, const QString& inputCodec, const QString& outputCodec, const ConversionOptions *_conversionOptions, TagData *tags = 0, bool replayGain = false );
     QStringList convertCommand( const KUrl& inputFile, const KUrl& outputFile, const QString& inputCodec, const QString& outputCodec, const ConversionOptions *_conversionOptions, TagData *tags = 0, bool replayGain = false );
     float parseOutput( const QString& output );
+
+private:
+    /** Starts a segmented encode if @p inputFile is long enough and more than one thread may be used, returns the job id or -1 */
+    int convertSegmented( const KUrl& inputFile, const KUrl& outputFile, const ConversionOptions *conversionOptions, bool replayGain );
+
+    /** QMap< job id, segmented encode > */
+    QMap<int,SegmentedFlacJob*> jobs;
+
+private slots:
+    void segmentedFinished( SegmentedFlacJob *job );
 };
 
 K_EXPORT_SOUNDKONVERTER_CODEC( flac, soundkonverter_codec_flac )
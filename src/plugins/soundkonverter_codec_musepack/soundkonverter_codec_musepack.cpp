@@ -31,9 +31,9 @@ QString soundkonverter_codec_musepack::name() const
 
 void soundkonverter_codec_musepack::scanForBackends( const QStringList& directoryList )
 {
-    binaries["mppenc"] = KStandardDirs::findExe( "mppenc" ); // sv7
+    binaries["mppenc"] = findExe( "mppenc" ); // sv7
     if( binaries["mppenc"].isEmpty() )
-        binaries["mppenc"] = KStandardDirs::findExe( "mpcenc" ); // sv8
+        binaries["mppenc"] = findExe( "mpcenc" ); // sv8
 
     if( binaries["mppenc"].isEmpty() )
     {
@@ -52,9 +52,9 @@ void soundkonverter_codec_musepack::scanForBackends( const QStringList& director
         }
     }
 
-    binaries["mppdec"] = KStandardDirs::findExe( "mppdec" ); // sv7
+    binaries["mppdec"] = findExe( "mppdec" ); // sv7
     if( binaries["mppdec"].isEmpty() )
-        binaries["mppdec"] = KStandardDirs::findExe( "mpcdec" ); // sv8
+        binaries["mppdec"] = findExe( "mpcdec" ); // sv8
 
     if( binaries["mppdec"].isEmpty() )
     {
@@ -10,6 +10,8 @@ NormalizeFilterOptions::NormalizeFilterOptions()
     pluginName = global_plugin_name;
 
     data.normalize = false;
+    data.mode = Rms;
+    data.level = -12.0;
 }
 
 NormalizeFilterOptions::~NormalizeFilterOptions()
@@ -22,13 +24,15 @@ bool NormalizeFilterOptions::equals( FilterOptions *_other )
 
     NormalizeFilterOptions *other = dynamic_cast<NormalizeFilterOptions*>(_other);
 
-    return ( FilterOptions::equals( _other ) && data.normalize == other->data.normalize );
+    return ( FilterOptions::equals( _other ) && data.normalize == other->data.normalize && data.mode == other->data.mode && data.level == other->data.level );
 }
 
 QDomElement NormalizeFilterOptions::toXml( QDomDocument document, const QString& elementName ) const
 {
     QDomElement filterOptions = FilterOptions::toXml( document,elementName );
     filterOptions.setAttribute("normalize",data.normalize);
+    filterOptions.setAttribute("mode",data.mode);
+    filterOptions.setAttribute("level",data.level);
 
     return filterOptions;
 }
@@ -37,6 +41,11 @@ bool NormalizeFilterOptions::fromXml( QDomElement filterOptions )
 {
     FilterOptions::fromXml( filterOptions );
     data.normalize = filterOptions.attribute("normalize").toInt();
+    // profiles of older versions only contain the normalize attribute
+    if( filterOptions.hasAttribute("mode") )
+        data.mode = (Mode)filterOptions.attribute("mode").toInt();
+    if( filterOptions.hasAttribute("level") )
+        data.level = filterOptions.attribute("level").toDouble();
 
     return true;
 }
@@ -48,6 +57,8 @@ FilterOptions* NormalizeFilterOptions::copy() const
     c->cmdArguments = cmdArguments;
 
     c->data.normalize = data.normalize;
+    c->data.mode = data.mode;
+    c->data.level = data.level;
 
     return static_cast<FilterOptions*>(c);
 }
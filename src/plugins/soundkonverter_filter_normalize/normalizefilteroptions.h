@@ -17,8 +17,15 @@ public:
 
     FilterOptions* copy() const;
 
+    enum Mode {
+        Peak = 0,
+        Rms = 1
+    };
+
     struct Data {
         bool normalize;
+        Mode mode;
+        double level; // the target level of the peaks or the RMS in dBFS
     } data;
 };
 
@@ -8,6 +8,8 @@
 #include <QHBoxLayout>
 #include <KLocale>
 #include <QCheckBox>
+#include <QDoubleSpinBox>
+#include <KComboBox>
 
 NormalizeFilterWidget::NormalizeFilterWidget()
     : FilterWidget()
@@ -24,11 +26,32 @@ NormalizeFilterWidget::NormalizeFilterWidget()
     connect( cNormalize, SIGNAL(toggled(bool)), SIGNAL(optionsChanged()) );
     topBox->addWidget( cNormalize );
 
+    cMode = new KComboBox( this );
+    cMode->addItem( i18n("Peak level") );
+    cMode->addItem( i18n("RMS level") );
+    cMode->setToolTip( i18n("Peak level: Amplify the loudest sample to the given level\nRMS level: Amplify the average loudness to the given level without clipping the peaks") );
+    connect( cMode, SIGNAL(activated(int)), SIGNAL(optionsChanged()) );
+    topBox->addWidget( cMode );
+
+    dLevel = new QDoubleSpinBox( this );
+    dLevel->setRange( -60, 0 );
+    dLevel->setDecimals( 1 );
+    dLevel->setSuffix( " " + i18nc("decibel full scale","dBFS") );
+    connect( dLevel, SIGNAL(valueChanged(double)), SIGNAL(optionsChanged()) );
+    topBox->addWidget( dLevel );
+
+    connect( cNormalize, SIGNAL(toggled(bool)), cMode, SLOT(setEnabled(bool)) );
+    connect( cNormalize, SIGNAL(toggled(bool)), dLevel, SLOT(setEnabled(bool)) );
+
     topBox->addStretch();
 
     grid->setRowStretch( 1, 1 );
 
     cNormalize->setChecked( false );
+    cMode->setCurrentIndex( NormalizeFilterOptions::Rms );
+    cMode->setEnabled( false );
+    dLevel->setValue( -12 );
+    dLevel->setEnabled( false );
 }
 
 NormalizeFilterWidget::~NormalizeFilterWidget()
@@ -40,6 +63,8 @@ FilterOptions* NormalizeFilterWidget::currentFilterOptions()
     {
         NormalizeFilterOptions *options = new NormalizeFilterOptions();
         options->data.normalize = cNormalize->isChecked();
+        options->data.mode = (NormalizeFilterOptions::Mode)cMode->currentIndex();
+        options->data.level = dLevel->value();
         return options;
     }
     else
@@ -62,6 +87,8 @@ bool NormalizeFilterWidget::setCurrentFilterOptions( const FilterOptions *_optio
 
     const NormalizeFilterOptions *options = dynamic_cast<const NormalizeFilterOptions*>(_options);
     cNormalize->setChecked( options->data.normalize );
+    cMode->setCurrentIndex( options->data.mode );
+    dLevel->setValue( options->data.level );
 
     return true;
 }
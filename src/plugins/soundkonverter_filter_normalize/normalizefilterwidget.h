@@ -5,6 +5,8 @@
 #include "../../core/codecwidget.h"
 
 class QCheckBox;
+class QDoubleSpinBox;
+class KComboBox;
 
 class NormalizeFilterWidget : public FilterWidget
 {
@@ -18,6 +20,8 @@ public:
 
 private:
     QCheckBox *cNormalize;
+    KComboBox *cMode;
+    QDoubleSpinBox *dLevel;
 };
 
 #endif // NORMALIZEFILTERWIDGET_H
@@ -0,0 +1,212 @@
+
+#include "normalizejob.h"
+#include "../../core/wavfile.h"
+
+#include <KLocale>
+
+#include <QFile>
+#include <QVector>
+#include <QtConcurrentRun>
+
+#include <math.h>
+
+
+// the number of samples that get processed at once
+#define BlockSize (256*1024)
+
+
+namespace
+{
+    void measure( const float *samples, int count, float *peak, double *sumOfSquares )
+    {
+        float blockPeak = *peak;
+        double blockSum = 0.0;
+        for( int i=0; i<count; i++ )
+        {
+            const float value = fabsf( samples[i] );
+            blockPeak = value > blockPeak ? value : blockPeak;
+            blockSum += samples[i] * samples[i];
+        }
+        *peak = blockPeak;
+        *sumOfSquares += blockSum;
+    }
+
+    void applyGain( float *samples, int count, float gain )
+    {
+        for( int i=0; i<count; i++ )
+            samples[i] *= gain;
+    }
+}
+
+
+NormalizeJob::NormalizeJob( const QString& _inputFile, const QString& _outputFile, Mode _mode, double _level, QObject *parent )
+    : QObject( parent ),
+    inputFile( _inputFile ),
+    outputFile( _outputFile ),
+    mode( _mode ),
+    level( _level ),
+    error( NoError ),
+    appliedGain( 0.0 ),
+    progressValue( 0 ),
+    canceled( 0 )
+{
+    connect( &watcher, SIGNAL(finished()), this, SLOT(workerFinished()) );
+}
+
+NormalizeJob::~NormalizeJob()
+{
+    canceled = 1;
+    watcher.waitForFinished();
+}
+
+void NormalizeJob::start()
+{
+    watcher.setFuture( QtConcurrent::run(this,&NormalizeJob::normalize) );
+}
+
+void NormalizeJob::kill()
+{
+    canceled = 1;
+}
+
+float NormalizeJob::progress() const
+{
+    return (int)progressValue / 10.0f;
+}
+
+QString NormalizeJob::errorString() const
+{
+    switch( error )
+    {
+        case NoError:
+            return QString();
+        case InputError:
+            return i18n("Can't read the input file");
+        case OutputError:
+            return i18n("Can't write the output file");
+        case UnsupportedFormat:
+            return i18n("The sample format of the input file is not supported");
+        case Canceled:
+            return i18n("Canceled");
+    }
+    return QString();
+}
+
+void NormalizeJob::workerFinished()
+{
+    const Result result = watcher.result();
+    error = result.error;
+    appliedGain = result.gain;
+
+    if( error != NoError )
+        QFile::remove( outputFile );
+
+    emit finished( this );
+}
+
+NormalizeJob::Result NormalizeJob::normalize()
+{
+    Result result;
+    result.error = NoError;
+    result.gain = 0.0;
+
+    WavFile input;
+    if( !input.openRead(inputFile) )
+    {
+        result.error = QFile::exists(inputFile) ? UnsupportedFormat : InputError;
+        return result;
+    }
+
+    const int framesPerBlock = qMax( 1, BlockSize / input.channels() );
+    QVector<float> samples( framesPerBlock * input.channels() );
+
+    // first pass: measure the levels
+
+    float peak = 0.0f;
+    double sumOfSquares = 0.0;
+
+    while( input.position() < input.frameCount() )
+    {
+        if( (int)canceled )
+        {
+            result.error = Canceled;
+            return result;
+        }
+
+        const int count = input.read( samples.data(), framesPerBlock );
+        if( count <= 0 )
+        {
+            result.error = InputError;
+            return result;
+        }
+
+        measure( samples.constData(), count * input.channels(), &peak, &sumOfSquares );
+
+        progressValue = (int)( input.position() * 500 / input.frameCount() );
+    }
+
+    // calculate the gain, silence stays untouched
+
+    double gain = 1.0;
+    if( peak > 0.0f )
+    {
+        const double target = pow( 10.0, level / 20.0 );
+
+        if( mode == Peak )
+        {
+            gain = target / peak;
+        }
+        else
+        {
+            const double rms = sqrt( sumOfSquares / ( input.frameCount() * input.channels() ) );
+            // never clip the peaks
+            gain = qMin( target / rms, 1.0 / peak );
+        }
+    }
+    result.gain = 20.0 * log10( gain );
+
+    // second pass: write the output file
+
+    WavFile output;
+    if( !input.rewind() || !output.openWrite(outputFile,input.sampleRate(),input.channels(),input.bitsPerSample(),input.sampleFormat()) )
+    {
+        result.error = OutputError;
+        return result;
+    }
+
+    while( input.position() < input.frameCount() )
+    {
+        if( (int)canceled )
+        {
+            result.error = Canceled;
+            return result;
+        }
+
+        const int count = input.read( samples.data(), framesPerBlock );
+        if( count <= 0 )
+        {
+            result.error = InputError;
+            return result;
+        }
+
+        applyGain( samples.data(), count * input.channels(), gain );
+
+        if( !output.write(samples.constData(),count) )
+        {
+            result.error = OutputError;
+            return result;
+        }
+
+        progressValue = 500 + (int)( input.position() * 500 / input.frameCount() );
+    }
+
+    if( !output.close() )
+    {
+        result.error = OutputError;
+        return result;
+    }
+
+    progressValue = 1000;
+
+    return result;
+}
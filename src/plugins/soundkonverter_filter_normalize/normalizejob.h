@@ -0,0 +1,80 @@
+
+#ifndef NORMALIZEJOB_H
+#define NORMALIZEJOB_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QFutureWatcher>
+
+
+/**
+ * @short Normalizes a wav file without an external backend
+ *
+ * The first pass measures the peak and the RMS level of the input file, the second pass
+ * writes the output file with the gain applied. Both passes run in a separate thread and
+ * stream the samples in blocks, the file never gets loaded completely.
+ */
+class NormalizeJob : public QObject
+{
+    Q_OBJECT
+public:
+    enum Mode
+    {
+        Peak = 0,
+        Rms = 1
+    };
+
+    enum Error
+    {
+        NoError = 0,
+        InputError,
+        OutputError,
+        UnsupportedFormat,
+        Canceled
+    };
+
+    NormalizeJob( const QString& _inputFile, const QString& _outputFile, Mode _mode, double _level, QObject *parent );
+    /** Waits for the worker thread to return */
+    ~NormalizeJob();
+
+    void start();
+    void kill();
+
+    /** The progress in percent */
+    float progress() const;
+    bool success() const { return error == NoError; }
+    /** The applied gain in dB, valid after the job has finished successfully */
+    double gain() const { return appliedGain; }
+    QString errorString() const;
+
+signals:
+    void finished( NormalizeJob *job );
+
+private slots:
+    void workerFinished();
+
+private:
+    struct Result
+    {
+        Error error;
+        double gain;
+    };
+
+    /** Runs in the worker thread */
+    Result normalize();
+
+    QString inputFile;
+    QString outputFile;
+    Mode mode;
+    double level;
+
+    Error error;
+    double appliedGain;
+
+    /** per mille */
+    QAtomicInt progressValue;
+    QAtomicInt canceled;
+    QFutureWatcher<Result> watcher;
+};
+
+#endif // NORMALIZEJOB_H
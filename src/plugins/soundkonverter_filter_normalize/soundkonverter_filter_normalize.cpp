@@ -5,8 +5,9 @@
 #include "../../core/conversionoptions.h"
 #include "normalizefilteroptions.h"
 #include "normalizefilterwidget.h"
+#include "normalizejob.h"
 
-#include <QFile>
+#include <KLocale>
 
 
 soundkonverter_filter_normalize::soundkonverter_filter_normalize( QObject *parent, const QStringList& args  )
@@ -14,8 +15,6 @@ soundkonverter_filter_normalize::soundkonverter_filter_normalize( QObject *paren
 {
     Q_UNUSED(args)
 
-    binaries["normalize"] = "";
-
     allCodecs += "wav";
 }
 
@@ -35,8 +34,7 @@ QList<ConversionPipeTrunk> soundkonverter_filter_normalize::codecTable()
     newTrunk.codecFrom = "wav";
     newTrunk.codecTo = "wav";
     newTrunk.rating = 100;
-    newTrunk.enabled = ( binaries["normalize"] != "" );
-    newTrunk.problemInfo = standardMessage( "filter,backend", "normalize", "normalize" ) + "\n" + standardMessage( "install_opensource_backend", "normalize" );
+    newTrunk.enabled = true;
     newTrunk.data.hasInternalReplayGain = false;
     table.append( newTrunk );
 
@@ -68,6 +66,24 @@ void soundkonverter_filter_normalize::showInfo( QWidget *parent )
     Q_UNUSED(parent)
 }
 
+bool soundkonverter_filter_normalize::kill( int id )
+{
+    if( !jobs.contains(id) )
+        return FilterPlugin::kill( id );
+
+    jobs.value(id)->kill();
+    emit log( id, "<pre>\t" + i18n("Killing process on user request") + "</pre>" );
+    return true;
+}
+
+float soundkonverter_filter_normalize::progress( int id )
+{
+    if( !jobs.contains(id) )
+        return FilterPlugin::progress( id );
+
+    return jobs.value(id)->progress();
+}
+
 FilterWidget *soundkonverter_filter_normalize::newFilterWidget()
 {
     NormalizeFilterWidget *widget = new NormalizeFilterWidget();
@@ -87,22 +103,35 @@ return 0;
 
 int soundkonverter_filter_normalize::convert( const KUrl& inputFile, const KUrl& outputFile, const QString& inputCodec, const QString& outputCodec, const ConversionOptions *_conversionOptions, TagData *tags, bool replayGain )
 {
-    QStringList command = convertCommand( inputFile, outputFile, inputCodec, outputCodec, _conversionOptions, tags, replayGain );
-    if( command.isEmpty() )
+    Q_UNUSED( inputCodec );
+    Q_UNUSED( outputCodec );
+    Q_UNUSED( tags );
+    Q_UNUSED( replayGain );
+
+    if( !_conversionOptions )
+        return BackendPlugin::UnknownError;
+
+    const NormalizeFilterOptions *filterOptions = 0;
+    foreach( const FilterOptions *_filterOptions, _conversionOptions->filterOptions )
+    {
+        if( _filterOptions->pluginName == global_plugin_name )
+            filterOptions = dynamic_cast<const NormalizeFilterOptions*>(_filterOptions);
+    }
+
+    if( !filterOptions || !filterOptions->data.normalize )
         return BackendPlugin::UnknownError;
 
     FilterPluginItem *newItem = new FilterPluginItem( this );
     newItem->id = lastId++;
-    newItem->process = new KProcess( newItem );
-    newItem->process->setOutputChannelMode( KProcess::MergedChannels );
-    connect( newItem->process, SIGNAL(readyRead()), this, SLOT(processOutput()) );
-    connect( newItem->process, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(processExit(int,QProcess::ExitStatus)) );
+    newItem->process = 0;
 
-    newItem->process->clearProgram();
-    newItem->process->setShellCommand( command.join(" ") );
-    newItem->process->start();
+    const NormalizeJob::Mode mode = ( filterOptions->data.mode == NormalizeFilterOptions::Peak ) ? NormalizeJob::Peak : NormalizeJob::Rms;
+    NormalizeJob *job = new NormalizeJob( inputFile.toLocalFile(), outputFile.toLocalFile(), mode, filterOptions->data.level, newItem );
+    connect( job, SIGNAL(finished(NormalizeJob*)), this, SLOT(normalizeFinished(NormalizeJob*)) );
+    jobs.insert( newItem->id, job );
+    job->start();
 
-    logCommand( newItem->id, command.join(" ") );
+    logCommand( newItem->id, i18n("Normalizing \"%1\" to %2 dBFS (%3)", inputFile.toLocalFile(), filterOptions->data.level, mode == NormalizeJob::Peak ? i18n("peak level") : i18n("RMS level")) );
 
     backendItems.append( newItem );
     return newItem->id;
@@ -110,36 +139,40 @@ int soundkonverter_filter_normalize::convert( const KUrl& inputFile, const KUrl&
 
 QStringList soundkonverter_filter_normalize::convertCommand( const KUrl& inputFile, const KUrl& outputFile, const QString& inputCodec, const QString& outputCodec, const ConversionOptions *_conversionOptions, TagData *tags, bool replayGain )
 {
+    Q_UNUSED( inputFile );
+    Q_UNUSED( outputFile );
     Q_UNUSED( inputCodec );
     Q_UNUSED( outputCodec );
+    Q_UNUSED( _conversionOptions );
     Q_UNUSED( tags );
     Q_UNUSED( replayGain );
 
-    if( !_conversionOptions )
-        return QStringList();
+    // the gain is known after the whole file has been scanned, so the output can't be streamed
+    return QStringList();
+}
 
-    if( inputFile.isEmpty() || outputFile.isEmpty() )
-        return QStringList();
+void soundkonverter_filter_normalize::normalizeFinished( NormalizeJob *job )
+{
+    const int id = jobs.key( job );
+    jobs.remove( id );
 
-    QStringList command;
+    if( job->success() )
+        logOutput( id, i18n("Applied a gain of %1 dB", QString::number(job->gain(),'f',2)) );
+    else
+        logOutput( id, job->errorString() );
 
-    foreach( const FilterOptions *_filterOptions,_conversionOptions->filterOptions )
+    for( int i=0; i<backendItems.size(); i++ )
     {
-        if( _filterOptions->pluginName == global_plugin_name )
+        if( backendItems.at(i)->id == id )
         {
-            const NormalizeFilterOptions *filterOptions = dynamic_cast<const NormalizeFilterOptions*>(_filterOptions);
-            if( filterOptions->data.normalize )
-            {
-                command += binaries["normalize"];
-                command += "\"" + escapeUrl(outputFile) + "\"";
-
-                if( !command.isEmpty() )
-                    QFile::copy( inputFile.toLocalFile(), outputFile.toLocalFile() );
-            }
+            emit jobFinished( id, job->success() ? 0 : 1 );
+
+            backendItems.at(i)->deleteLater();
+            backendItems.removeAt(i);
+
+            return;
         }
     }
-
-    return command;
 }
 
 float soundkonverter_filter_normalize::parseOutput( const QString& output )
@@ -5,6 +5,7 @@
 #include "../../core/filterplugin.h"
 
 class FilterOptions;
+class NormalizeJob;
 
 
 class soundkonverter_filter_normalize : public FilterPlugin
@@ -25,6 +26,8 @@ public:
     void showConfigDialog( ActionType action, const QString& codecName, QWidget *parent );
     bool hasInfo();
     void showInfo( QWidget *parent );
+    bool kill( int id );
+    float progress( int id );
 
     CodecWidget *newCodecWidget();
     FilterWidget *newFilterWidget();
@@ -34,6 +37,13 @@ public:
     float parseOutput( const QString& output );
 
     FilterOptions *filterOptionsFromXml( QDomElement filterOptions );
+
+private:
+    /** QMap< job id, normalize job > */
+    QMap<int,NormalizeJob*> jobs;
+
+private slots:
+    void normalizeFinished( NormalizeJob *job );
 };
 
 K_EXPORT_SOUNDKONVERTER_FILTER( normalize, soundkonverter_filter_normalize )
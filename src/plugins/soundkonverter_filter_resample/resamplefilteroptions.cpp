@@ -0,0 +1,68 @@
+#include "resamplefilterglobal.h"
+
+#include "resamplefilteroptions.h"
+#include "../../core/conversionoptions.h"
+
+
+ResampleFilterOptions::ResampleFilterOptions()
+{
+    pluginName = global_plugin_name;
+
+    data.sampleRate = 0;
+    data.sampleSize = 0;
+    data.channels = 0;
+    data.dither = true;
+}
+
+ResampleFilterOptions::~ResampleFilterOptions()
+{}
+
+bool ResampleFilterOptions::equals( FilterOptions *_other )
+{
+    if( !_other || _other->pluginName!=pluginName )
+        return false;
+
+    ResampleFilterOptions *other = dynamic_cast<ResampleFilterOptions*>(_other);
+
+    return ( FilterOptions::equals( _other ) &&
+             data.sampleRate == other->data.sampleRate &&
+             data.sampleSize == other->data.sampleSize &&
+             data.channels == other->data.channels &&
+             data.dither == other->data.dither );
+}
+
+QDomElement ResampleFilterOptions::toXml( QDomDocument document, const QString& elementName ) const
+{
+    QDomElement filterOptions = FilterOptions::toXml( document,elementName );
+    filterOptions.setAttribute("sampleRate",data.sampleRate);
+    filterOptions.setAttribute("sampleSize",data.sampleSize);
+    filterOptions.setAttribute("channels",data.channels);
+    filterOptions.setAttribute("dither",data.dither);
+
+    return filterOptions;
+}
+
+bool ResampleFilterOptions::fromXml( QDomElement filterOptions )
+{
+    FilterOptions::fromXml( filterOptions );
+    data.sampleRate = filterOptions.attribute("sampleRate").toInt();
+    data.sampleSize = filterOptions.attribute("sampleSize").toInt();
+    data.channels = filterOptions.attribute("channels").toInt();
+    data.dither = filterOptions.attribute("dither").toInt();
+
+    return true;
+}
+
+FilterOptions* ResampleFilterOptions::copy() const
+{
+    ResampleFilterOptions* c = new ResampleFilterOptions();
+    c->pluginName = pluginName;
+    c->cmdArguments = cmdArguments;
+
+    c->data.sampleRate = data.sampleRate;
+    c->data.sampleSize = data.sampleSize;
+    c->data.channels = data.channels;
+    c->data.dither = data.dither;
+
+    return static_cast<FilterOptions*>(c);
+}
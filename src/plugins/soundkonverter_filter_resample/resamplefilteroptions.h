@@ -0,0 +1,28 @@
+
+#ifndef RESAMPLEFILTEROPTIONS_H
+#define RESAMPLEFILTEROPTIONS_H
+
+#include "../../core/conversionoptions.h"
+
+
+class ResampleFilterOptions : public FilterOptions
+{
+public:
+    ResampleFilterOptions();
+    ~ResampleFilterOptions();
+
+    bool equals( FilterOptions *_other );
+    QDomElement toXml( QDomDocument document, const QString& elementName ) const;
+    bool fromXml( QDomElement filterOptions );
+
+    FilterOptions* copy() const;
+
+    struct Data {
+        int sampleRate; // 0 if disabled
+        int sampleSize; // 0 if disabled
+        short channels; // 0 if disabled
+        bool dither;
+    } data;
+};
+
+#endif // RESAMPLEFILTEROPTIONS_H
@@ -0,0 +1,148 @@
+#include "resamplefilterglobal.h"
+
+#include "resamplefilterwidget.h"
+#include "resamplefilteroptions.h"
+
+#include <QApplication>
+#include <KLocale>
+#include <QCheckBox>
+#include <QLayout>
+
+#include <KComboBox>
+
+
+ResampleFilterWidget::ResampleFilterWidget()
+    : FilterWidget()
+{
+    const int fontHeight = QFontMetrics(QApplication::font()).boundingRect("M").size().height();
+
+    QGridLayout *grid = new QGridLayout( this );
+    grid->setContentsMargins( 0, 0, 0, 0 );
+
+    // set up filter options selection
+
+    QHBoxLayout *topBox = new QHBoxLayout();
+    grid->addLayout( topBox, 0, 0 );
+
+    chSampleRate = new QCheckBox( i18n("Sample rate:"), this );
+    connect( chSampleRate, SIGNAL(toggled(bool)), SIGNAL(optionsChanged()) );
+    topBox->addWidget( chSampleRate );
+    cSampleRate = new KComboBox( this );
+    cSampleRate->addItem( "8000 Hz" );
+    cSampleRate->addItem( "11025 Hz" );
+    cSampleRate->addItem( "12000 Hz" );
+    cSampleRate->addItem( "16000 Hz" );
+    cSampleRate->addItem( "22050 Hz" );
+    cSampleRate->addItem( "24000 Hz" );
+    cSampleRate->addItem( "32000 Hz" );
+    cSampleRate->addItem( "44100 Hz" );
+    cSampleRate->addItem( "48000 Hz" );
+    cSampleRate->addItem( "88200 Hz" );
+    cSampleRate->addItem( "96000 Hz" );
+    cSampleRate->setCurrentIndex( 7 );
+    cSampleRate->setEditable( true );
+    cSampleRate->setEnabled( false );
+    connect( cSampleRate, SIGNAL(activated(int)), SIGNAL(optionsChanged()) );
+    topBox->addWidget( cSampleRate );
+    connect( chSampleRate, SIGNAL(toggled(bool)), cSampleRate, SLOT(setEnabled(bool)) );
+
+    topBox->addSpacing( fontHeight );
+
+    chSampleSize = new QCheckBox( i18n("Sample size:"), this );
+    connect( chSampleSize, SIGNAL(toggled(bool)), SIGNAL(optionsChanged()) );
+    topBox->addWidget( chSampleSize );
+    cSampleSize = new KComboBox( this );
+    cSampleSize->addItem( "8 bit" );
+    cSampleSize->addItem( "16 bit" );
+    cSampleSize->addItem( "24 bit" );
+    cSampleSize->addItem( "32 bit" );
+    cSampleSize->setCurrentIndex( 1 );
+    cSampleSize->setEnabled( false );
+    connect( cSampleSize, SIGNAL(activated(int)), SIGNAL(optionsChanged()) );
+    topBox->addWidget( cSampleSize );
+    chDither = new QCheckBox( i18n("Dither"), this );
+    chDither->setToolTip( i18n("Add a little noise when reducing the sample size in order to avoid distortion of quiet passages") );
+    chDither->setChecked( true );
+    chDither->setEnabled( false );
+    connect( chDither, SIGNAL(toggled(bool)), SIGNAL(optionsChanged()) );
+    topBox->addWidget( chDither );
+    connect( chSampleSize, SIGNAL(toggled(bool)), this, SLOT(sampleSizeToggled(bool)) );
+
+    topBox->addSpacing( fontHeight );
+
+    chChannels = new QCheckBox( i18n("Channels:"), this );
+    connect( chChannels, SIGNAL(toggled(bool)), SIGNAL(optionsChanged()) );
+    topBox->addWidget( chChannels );
+    cChannels = new KComboBox( this );
+    cChannels->addItem( i18n("Mono") );
+    cChannels->addItem( i18n("Stereo") );
+    cChannels->setEnabled( false );
+    connect( cChannels, SIGNAL(activated(int)), SIGNAL(optionsChanged()) );
+    topBox->addWidget( cChannels );
+    connect( chChannels, SIGNAL(toggled(bool)), cChannels, SLOT(setEnabled(bool)) );
+
+    topBox->addStretch();
+
+    grid->setRowStretch( 1, 1 );
+}
+
+ResampleFilterWidget::~ResampleFilterWidget()
+{}
+
+void ResampleFilterWidget::sampleSizeToggled( bool checked )
+{
+    cSampleSize->setEnabled( checked );
+    chDither->setEnabled( checked );
+}
+
+FilterOptions* ResampleFilterWidget::currentFilterOptions()
+{
+    const int sampleRate = cSampleRate->currentText().replace(" Hz","").toInt();
+
+    if( !( chSampleRate->isChecked() && sampleRate > 0 ) && !chSampleSize->isChecked() && !chChannels->isChecked() )
+        return 0;
+
+    ResampleFilterOptions *options = new ResampleFilterOptions();
+    options->data.sampleRate = ( chSampleRate->isChecked() && sampleRate > 0 ) ? sampleRate : 0;
+    options->data.sampleSize = chSampleSize->isChecked() ? cSampleSize->currentText().replace(" bit","").toInt() : 0;
+    options->data.channels = chChannels->isChecked() ? cChannels->currentIndex() + 1 : 0;
+    options->data.dither = chDither->isChecked();
+
+    return options;
+}
+
+bool ResampleFilterWidget::setCurrentFilterOptions( const FilterOptions *_options )
+{
+    if( !_options )
+    {
+        chSampleRate->setChecked( false );
+        chSampleSize->setChecked( false );
+        chChannels->setChecked( false );
+
+        return true;
+    }
+
+    if( _options->pluginName != global_plugin_name )
+        return false;
+
+    const ResampleFilterOptions *options = dynamic_cast<const ResampleFilterOptions*>(_options);
+
+    chSampleRate->setChecked( options->data.sampleRate > 0 );
+    if( options->data.sampleRate > 0 )
+    {
+        cSampleRate->setCurrentItem( QString::number(options->data.sampleRate) + " Hz", true );
+    }
+    chSampleSize->setChecked( options->data.sampleSize > 0 );
+    if( options->data.sampleSize > 0 )
+    {
+        cSampleSize->setCurrentItem( QString::number(options->data.sampleSize) + " bit" );
+    }
+    chDither->setChecked( options->data.dither );
+    chChannels->setChecked( options->data.channels > 0 );
+    if( options->data.channels > 0 )
+    {
+        cChannels->setCurrentIndex( options->data.channels - 1 );
+    }
+
+    return true;
+}
@@ -0,0 +1,33 @@
+
+#ifndef RESAMPLEFILTERWIDGET_H
+#define RESAMPLEFILTERWIDGET_H
+
+#include "../../core/codecwidget.h"
+
+class QCheckBox;
+class KComboBox;
+
+class ResampleFilterWidget : public FilterWidget
+{
+    Q_OBJECT
+public:
+    ResampleFilterWidget();
+    ~ResampleFilterWidget();
+
+    FilterOptions *currentFilterOptions();
+    bool setCurrentFilterOptions( const FilterOptions *_options );
+
+private:
+    QCheckBox *chSampleRate;
+    KComboBox *cSampleRate;
+    QCheckBox *chSampleSize;
+    KComboBox *cSampleSize;
+    QCheckBox *chDither;
+    QCheckBox *chChannels;
+    KComboBox *cChannels;
+
+private slots:
+    void sampleSizeToggled( bool checked );
+};
+
+#endif // RESAMPLEFILTERWIDGET_H
@@ -0,0 +1,271 @@
+
+#include "resamplejob.h"
+#include "resampler.h"
+#include "../../core/wavfile.h"
+
+#include <KLocale>
+
+#include <QFile>
+#include <QtConcurrentRun>
+
+
+// the number of frames that get read at once
+#define BlockSize (64*1024)
+// -3 dB, the level of the center and the surround channels in a downmix
+#define MixLevel 0.7071f
+
+
+namespace
+{
+    /** Generates triangular noise of +-1 LSB that decorrelates the quantization error from the signal */
+    class Dither
+    {
+    public:
+        explicit Dither( int bits )
+            : amplitude( 1.0f / (float)( Q_INT64_C(1) << ( bits - 1 ) ) ),
+            state( 0x9E3779B9u )
+        {}
+
+        void apply( float *samples, int count )
+        {
+            for( int i=0; i<count; i++ )
+                samples[i] += ( uniform() - uniform() ) * amplitude;
+        }
+
+    private:
+        /** uniform between 0 and 1 */
+        float uniform()
+        {
+            // xorshift32
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state * ( 1.0f / 4294967296.0f );
+        }
+
+        const float amplitude;
+        quint32 state;
+    };
+
+    void mix( const float *input, int frames, int inputChannels, const QVector<float>& matrix, int outputChannels, float *output )
+    {
+        for( int i=0; i<frames; i++ )
+        {
+            const float *in = input + i * inputChannels;
+            for( int c=0; c<outputChannels; c++ )
+            {
+                const float *coefficients = matrix.constData() + c * inputChannels;
+                float sum = 0.0f;
+                for( int k=0; k<inputChannels; k++ )
+                    sum += in[k] * coefficients[k];
+                output[i * outputChannels + c] = sum;
+            }
+        }
+    }
+}
+
+
+ResampleJob::ResampleJob( const QString& _inputFile, const QString& _outputFile, int _sampleRate, int _sampleSize, int _channels, bool _dither, QObject *parent )
+    : QObject( parent ),
+    inputFile( _inputFile ),
+    outputFile( _outputFile ),
+    sampleRate( _sampleRate ),
+    sampleSize( _sampleSize ),
+    channels( _channels ),
+    dither( _dither ),
+    error( NoError ),
+    progressValue( 0 ),
+    canceled( 0 )
+{
+    connect( &watcher, SIGNAL(finished()), this, SLOT(workerFinished()) );
+}
+
+ResampleJob::~ResampleJob()
+{
+    canceled = 1;
+    watcher.waitForFinished();
+}
+
+void ResampleJob::start()
+{
+    watcher.setFuture( QtConcurrent::run(this,&ResampleJob::resample) );
+}
+
+void ResampleJob::kill()
+{
+    canceled = 1;
+}
+
+float ResampleJob::progress() const
+{
+    return (int)progressValue / 10.0f;
+}
+
+QString ResampleJob::errorString() const
+{
+    switch( error )
+    {
+        case NoError:
+            return QString();
+        case InputError:
+            return i18n("Can't read the input file");
+        case OutputError:
+            return i18n("Can't write the output file");
+        case UnsupportedFormat:
+            return i18n("The sample format of the input file is not supported");
+        case Canceled:
+            return i18n("Canceled");
+    }
+    return QString();
+}
+
+void ResampleJob::workerFinished()
+{
+    error = watcher.result();
+
+    if( error != NoError )
+        QFile::remove( outputFile );
+
+    emit finished( this );
+}
+
+QVector<float> ResampleJob::mixMatrix( int inputChannels, quint32 inputMask, int outputChannels )
+{
+    QVector<float> matrix( inputChannels * outputChannels, 0.0f );
+
+    if( outputChannels <= 2 && inputChannels > outputChannels )
+    {
+        const quint32 leftSpeakers = WavFile::FrontLeft | WavFile::FrontLeftOfCenter | WavFile::BackLeft | WavFile::SideLeft | WavFile::TopFrontLeft | WavFile::TopBackLeft;
+        const quint32 rightSpeakers = WavFile::FrontRight | WavFile::FrontRightOfCenter | WavFile::BackRight | WavFile::SideRight | WavFile::TopFrontRight | WavFile::TopBackRight;
+
+        // the channels are stored in the order of the bits of the mask, channels without a position are mixed like a center channel
+        QVector<quint32> speakers( inputChannels, 0 );
+        int channel = 0;
+        for( int bit=0; bit<32 && channel<inputChannels; bit++ )
+        {
+            if( inputMask & ( 1u << bit ) )
+                speakers[channel++] = 1u << bit;
+        }
+
+        for( int c=0; c<outputChannels; c++ )
+        {
+            float *coefficients = matrix.data() + c * inputChannels;
+            for( int k=0; k<inputChannels; k++ )
+            {
+                const quint32 speaker = speakers.at(k);
+                const bool front = ( speaker == WavFile::FrontLeft || speaker == WavFile::FrontRight );
+                if( speaker == WavFile::LowFrequency )
+                    coefficients[k] = 0.0f;
+                else if( outputChannels == 1 )
+                    coefficients[k] = front ? 1.0f : MixLevel;
+                else if( speaker & ( c == 0 ? leftSpeakers : rightSpeakers ) )
+                    coefficients[k] = front ? 1.0f : MixLevel;
+                else if( speaker & ( c == 0 ? rightSpeakers : leftSpeakers ) )
+                    coefficients[k] = 0.0f;
+                else
+                    coefficients[k] = MixLevel;
+            }
+
+            // the downmix must not clip
+            float sum = 0.0f;
+            for( int k=0; k<inputChannels; k++ )
+                sum += coefficients[k];
+            if( sum > 0.0f )
+            {
+                for( int k=0; k<inputChannels; k++ )
+                    coefficients[k] /= sum;
+            }
+        }
+    }
+    else
+    {
+        // keep the channels that exist in both layouts, mono gets played on both front speakers
+        for( int c=0; c<outputChannels; c++ )
+        {
+            if( c < inputChannels )
+                matrix[c * inputChannels + c] = 1.0f;
+            else if( inputChannels == 1 && c == 1 )
+                matrix[c * inputChannels] = 1.0f;
+        }
+    }
+
+    return matrix;
+}
+
+ResampleJob::Error ResampleJob::resample()
+{
+    WavFile input;
+    if( !input.openRead(inputFile) )
+        return QFile::exists(inputFile) ? UnsupportedFormat : InputError;
+
+    const int outputRate = ( sampleRate > 0 ) ? sampleRate : input.sampleRate();
+    const int outputChannels = ( channels > 0 ) ? channels : input.channels();
+    const int outputBits = ( sampleSize > 0 ) ? sampleSize : input.bitsPerSample();
+    const WavFile::SampleFormat outputFormat = ( sampleSize > 0 ) ? WavFile::Integer : input.sampleFormat();
+
+    const bool mixChannels = ( outputChannels != input.channels() );
+    const bool changeRate = ( outputRate != input.sampleRate() );
+    // dithering is only necessary if the samples lose precision
+    const bool addDither = dither && outputFormat == WavFile::Integer && outputBits <= 24 && ( outputBits < input.bitsPerSample() || input.sampleFormat() == WavFile::Float || mixChannels || changeRate );
+
+    WavFile output;
+    if( !output.openWrite(outputFile,outputRate,outputChannels,outputBits,outputFormat) )
+        return OutputError;
+
+    const QVector<float> matrix = mixMatrix( input.channels(), input.channelMask(), outputChannels );
+    Resampler resampler( input.sampleRate(), outputRate, outputChannels );
+    Dither noise( outputBits );
+
+    QVector<float> inputSamples( BlockSize * input.channels() );
+    QVector<float> mixedSamples( mixChannels ? BlockSize * outputChannels : 0 );
+    QVector<float> resampledSamples;
+
+    while( true )
+    {
+        if( (int)canceled )
+            return Canceled;
+
+        const int count = input.read( inputSamples.data(), BlockSize );
+        if( count < 0 )
+            return InputError;
+
+        float *samples = inputSamples.data();
+        int frames = count;
+
+        if( mixChannels )
+        {
+            mix( samples, frames, input.channels(), matrix, outputChannels, mixedSamples.data() );
+            samples = mixedSamples.data();
+        }
+
+        if( changeRate )
+        {
+            resampledSamples.resize( 0 );
+            if( count > 0 )
+                resampler.process( samples, frames, &resampledSamples );
+            else
+                resampler.flush( &resampledSamples );
+
+            samples = resampledSamples.data();
+            frames = resampledSamples.size() / outputChannels;
+        }
+
+        if( addDither )
+            noise.apply( samples, frames * outputChannels );
+
+        if( frames > 0 && !output.write(samples,frames) )
+            return OutputError;
+
+        if( count == 0 )
+            break;
+
+        progressValue = (int)( input.position() * 1000 / qMax( (qint64)1, input.frameCount() ) );
+    }
+
+    if( !output.close() )
+        return OutputError;
+
+    progressValue = 1000;
+
+    return NoError;
+}
@@ -0,0 +1,71 @@
+
+#ifndef RESAMPLEJOB_H
+#define RESAMPLEJOB_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QFutureWatcher>
+#include <QVector>
+
+
+/**
+ * @short Converts the sample rate, the sample size and the channels of a wav file without an external backend
+ *
+ * The samples are streamed in blocks through the channel mixer, the resampler and the
+ * quantizer in a separate thread.
+ */
+class ResampleJob : public QObject
+{
+    Q_OBJECT
+public:
+    enum Error
+    {
+        NoError = 0,
+        InputError,
+        OutputError,
+        UnsupportedFormat,
+        Canceled
+    };
+
+    /** @p sampleRate, @p sampleSize and @p channels are 0 if they shouldn't change */
+    ResampleJob( const QString& _inputFile, const QString& _outputFile, int _sampleRate, int _sampleSize, int _channels, bool _dither, QObject *parent );
+    /** Waits for the worker thread to return */
+    ~ResampleJob();
+
+    void start();
+    void kill();
+
+    /** The progress in percent */
+    float progress() const;
+    bool success() const { return error == NoError; }
+    QString errorString() const;
+
+    /** Returns the matrix for mixing @p inputChannels with the speaker positions @p inputMask into @p outputChannels, the coefficients of each output channel are stored consecutively */
+    static QVector<float> mixMatrix( int inputChannels, quint32 inputMask, int outputChannels );
+
+signals:
+    void finished( ResampleJob *job );
+
+private slots:
+    void workerFinished();
+
+private:
+    /** Runs in the worker thread */
+    Error resample();
+
+    QString inputFile;
+    QString outputFile;
+    int sampleRate;
+    int sampleSize;
+    int channels;
+    bool dither;
+
+    Error error;
+
+    /** per mille */
+    QAtomicInt progressValue;
+    QAtomicInt canceled;
+    QFutureWatcher<Error> watcher;
+};
+
+#endif // RESAMPLEJOB_H
@@ -0,0 +1,182 @@
+
+#include "resampler.h"
+
+#include <math.h>
+
+
+// the number of filter taps on each side of a sample if the bandwidth isn't reduced
+#define HalfLength 32
+// the passband ends at this fraction of the lower nyquist frequency
+#define Bandwidth 0.95
+// the kaiser window's beta, gives about 90 dB stop band attenuation
+#define KaiserBeta 9.0
+// the maximum number of precalculated filter phases
+#define MaxPhases 1024
+
+
+namespace
+{
+    qint64 greatestCommonDivisor( qint64 a, qint64 b )
+    {
+        while( b != 0 )
+        {
+            const qint64 t = a % b;
+            a = b;
+            b = t;
+        }
+        return a;
+    }
+
+    /** zeroth order modified bessel function of the first kind */
+    double besselI0( double x )
+    {
+        double sum = 1.0;
+        double term = 1.0;
+        for( int k=1; k<50; k++ )
+        {
+            term *= ( x / ( 2.0 * k ) ) * ( x / ( 2.0 * k ) );
+            sum += term;
+            if( term < sum * 1e-12 )
+                break;
+        }
+        return sum;
+    }
+
+    float dotProduct( const float *a, const float *b, int count )
+    {
+        float sum = 0.0f;
+        for( int i=0; i<count; i++ )
+            sum += a[i] * b[i];
+        return sum;
+    }
+}
+
+
+Resampler::Resampler( int inputRate, int outputRate, int _channels )
+    : channels( _channels ),
+    historyOffset( 0 ),
+    inputFrames( 0 ),
+    outputFrames( 0 )
+{
+    const qint64 divisor = greatestCommonDivisor( inputRate, outputRate );
+    upFactor = outputRate / divisor;
+    downFactor = inputRate / divisor;
+
+    // the cut off frequency relative to the input sample rate
+    const double cutoff = qMin( 1.0, (double)upFactor / downFactor ) * Bandwidth;
+    // keep the transition band narrow when downsampling
+    const int halfTaps = (int)ceil( HalfLength / cutoff );
+    taps = halfTaps * 2;
+    phaseCount = (int)qMin( upFactor, (qint64)MaxPhases );
+
+    filter.resize( phaseCount * taps );
+    const double windowScale = 1.0 / besselI0( KaiserBeta );
+    for( int phase=0; phase<phaseCount; phase++ )
+    {
+        const double fraction = (double)phase / phaseCount;
+        for( int k=0; k<taps; k++ )
+        {
+            // the distance between the input sample and the output sample in input samples
+            const double distance = k - halfTaps + 1 - fraction;
+            const double x = cutoff * distance;
+            const double sinc = ( fabs(x) < 1e-9 ) ? 1.0 : sin( M_PI * x ) / ( M_PI * x );
+            const double position = distance / halfTaps;
+            const double window = ( fabs(position) >= 1.0 ) ? 0.0 : besselI0( KaiserBeta * sqrt(1.0 - position * position) ) * windowScale;
+            filter[phase * taps + k] = cutoff * sinc * window;
+        }
+    }
+
+    // the samples before the start of the file are silent
+    history.resize( channels );
+    for( int c=0; c<channels; c++ )
+    {
+        history[c].fill( 0.0f, halfTaps - 1 );
+    }
+    historyOffset = -( halfTaps - 1 );
+}
+
+Resampler::~Resampler()
+{}
+
+void Resampler::process( const float *input, int frames, QVector<float> *output )
+{
+    for( int c=0; c<channels; c++ )
+    {
+        QVector<float>& channelHistory = history[c];
+        const int start = channelHistory.size();
+        channelHistory.resize( start + frames );
+        float *data = channelHistory.data() + start;
+        for( int i=0; i<frames; i++ )
+            data[i] = input[i * channels + c];
+    }
+    inputFrames += frames;
+
+    generateOutput( output, historyOffset + history.first().size() );
+}
+
+void Resampler::flush( QVector<float> *output )
+{
+    // the samples after the end of the file are silent
+    for( int c=0; c<channels; c++ )
+    {
+        history[c].resize( history[c].size() + taps / 2 + 1 );
+    }
+
+    generateOutput( output, historyOffset + history.first().size() );
+}
+
+void Resampler::generateOutput( QVector<float> *output, qint64 endFrame )
+{
+    const int halfTaps = taps / 2;
+
+    // the last output frame whose filter taps lie before endFrame, one more frame is needed if the nearest phase gets rounded up
+    const qint64 limit = endFrame - halfTaps - ( phaseCount < upFactor ? 1 : 0 );
+    qint64 lastFrame = limit > 0 ? ( limit * upFactor + downFactor - 1 ) / downFactor : 0;
+    // output frames after the end of the input would only contain the filter's decay
+    lastFrame = qMin( lastFrame, ( inputFrames * upFactor + downFactor - 1 ) / downFactor );
+
+    const int count = (int)qMax( (qint64)0, lastFrame - outputFrames );
+    if( count == 0 )
+        return;
+
+    const int outputStart = output->size();
+    output->resize( outputStart + count * channels );
+    float *out = output->data() + outputStart;
+
+    for( int n=0; n<count; n++ )
+    {
+        const qint64 position = ( outputFrames + n ) * downFactor;
+        qint64 frame = position / upFactor;
+        qint64 phase = position % upFactor;
+        if( phaseCount < upFactor )
+        {
+            phase = ( phase * phaseCount + upFactor / 2 ) / upFactor;
+            if( phase == phaseCount )
+            {
+                phase = 0;
+                frame++;
+            }
+        }
+
+        const float *coefficients = filter.constData() + phase * taps;
+        const int first = (int)( frame - halfTaps + 1 - historyOffset );
+        for( int c=0; c<channels; c++ )
+        {
+            out[n * channels + c] = dotProduct( history.at(c).constData() + first, coefficients, taps );
+        }
+    }
+
+    outputFrames += count;
+
+    // drop the input frames that are not needed anymore
+    const qint64 nextFrame = outputFrames * downFactor / upFactor;
+    const int obsolete = (int)qMax( (qint64)0, nextFrame - halfTaps - historyOffset );
+    if( obsolete > 0 )
+    {
+        for( int c=0; c<channels; c++ )
+        {
+            history[c].remove( 0, obsolete );
+        }
+        historyOffset += obsolete;
+    }
+}
@@ -0,0 +1,49 @@
+
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <QVector>
+
+
+/**
+ * @short Polyphase windowed sinc sample rate converter
+ *
+ * The ratio between the sample rates gets reduced to a fraction, every output sample is
+ * calculated with one of the precalculated filter phases. Ratios that would need too many
+ * phases use the nearest phase, the resulting timing error is below 1/MaxPhases samples.
+ */
+class Resampler
+{
+public:
+    Resampler( int inputRate, int outputRate, int channels );
+    ~Resampler();
+
+    /** Resamples @p frames interleaved frames from @p input and appends the result to @p output */
+    void process( const float *input, int frames, QVector<float> *output );
+    /** Appends the remaining frames to @p output, must be called once after the last input frame */
+    void flush( QVector<float> *output );
+
+private:
+    void generateOutput( QVector<float> *output, qint64 endFrame );
+
+    int channels;
+    /** the sample rates divided by their greatest common divisor */
+    qint64 upFactor;
+    qint64 downFactor;
+
+    int taps;
+    int phaseCount;
+    /** phaseCount * taps coefficients */
+    QVector<float> filter;
+
+    /** the input frames that are still needed, one vector per channel */
+    QVector< QVector<float> > history;
+    /** the index of the first frame in history */
+    qint64 historyOffset;
+    /** the number of input frames received so far */
+    qint64 inputFrames;
+    /** the number of output frames generated so far */
+    qint64 outputFrames;
+};
+
+#endif // RESAMPLER_H
@@ -0,0 +1,195 @@
+
+#include "resamplefilterglobal.h"
+
+#include "soundkonverter_filter_resample.h"
+#include "../../core/conversionoptions.h"
+#include "resamplefilteroptions.h"
+#include "resamplefilterwidget.h"
+#include "resamplejob.h"
+
+#include <KLocale>
+
+
+soundkonverter_filter_resample::soundkonverter_filter_resample( QObject *parent, const QStringList& args  )
+    : FilterPlugin( parent )
+{
+    Q_UNUSED(args)
+
+    allCodecs += "wav";
+}
+
+soundkonverter_filter_resample::~soundkonverter_filter_resample()
+{}
+
+QString soundkonverter_filter_resample::name() const
+{
+    return global_plugin_name;
+}
+
+QList<ConversionPipeTrunk> soundkonverter_filter_resample::codecTable()
+{
+    QList<ConversionPipeTrunk> table;
+    ConversionPipeTrunk newTrunk;
+
+    newTrunk.codecFrom = "wav";
+    newTrunk.codecTo = "wav";
+    newTrunk.rating = 90;
+    newTrunk.enabled = true;
+    newTrunk.data.hasInternalReplayGain = false;
+    table.append( newTrunk );
+
+    return table;
+}
+
+bool soundkonverter_filter_resample::isConfigSupported( ActionType action, const QString& codecName )
+{
+    Q_UNUSED(action)
+    Q_UNUSED(codecName)
+
+    return false;
+}
+
+void soundkonverter_filter_resample::showConfigDialog( ActionType action, const QString& codecName, QWidget *parent )
+{
+    Q_UNUSED(action)
+    Q_UNUSED(codecName)
+    Q_UNUSED(parent)
+}
+
+bool soundkonverter_filter_resample::hasInfo()
+{
+    return false;
+}
+
+void soundkonverter_filter_resample::showInfo( QWidget *parent )
+{
+    Q_UNUSED(parent)
+}
+
+bool soundkonverter_filter_resample::kill( int id )
+{
+    if( !jobs.contains(id) )
+        return FilterPlugin::kill( id );
+
+    jobs.value(id)->kill();
+    emit log( id, "<pre>\t" + i18n("Killing process on user request") + "</pre>" );
+    return true;
+}
+
+float soundkonverter_filter_resample::progress( int id )
+{
+    if( !jobs.contains(id) )
+        return FilterPlugin::progress( id );
+
+    return jobs.value(id)->progress();
+}
+
+FilterWidget *soundkonverter_filter_resample::newFilterWidget()
+{
+    ResampleFilterWidget *widget = new ResampleFilterWidget();
+    if( lastUsedFilterOptions )
+    {
+        widget->setCurrentFilterOptions( lastUsedFilterOptions );
+    }
+    return qobject_cast<FilterWidget*>(widget);
+}
+
+CodecWidget *soundkonverter_filter_resample::newCodecWidget()
+{
+    return 0;
+}
+
+int soundkonverter_filter_resample::convert( const KUrl& inputFile, const KUrl& outputFile, const QString& inputCodec, const QString& outputCodec, const ConversionOptions *_conversionOptions, TagData *tags, bool replayGain )
+{
+    Q_UNUSED( inputCodec );
+    Q_UNUSED( outputCodec );
+    Q_UNUSED( tags );
+    Q_UNUSED( replayGain );
+
+    if( !_conversionOptions )
+        return BackendPlugin::UnknownError;
+
+    const ResampleFilterOptions *filterOptions = 0;
+    foreach( const FilterOptions *_filterOptions, _conversionOptions->filterOptions )
+    {
+        if( _filterOptions->pluginName == global_plugin_name )
+            filterOptions = dynamic_cast<const ResampleFilterOptions*>(_filterOptions);
+    }
+
+    if( !filterOptions )
+        return BackendPlugin::UnknownError;
+
+    FilterPluginItem *newItem = new FilterPluginItem( this );
+    newItem->id = lastId++;
+    newItem->process = 0;
+
+    ResampleJob *job = new ResampleJob( inputFile.toLocalFile(), outputFile.toLocalFile(), filterOptions->data.sampleRate, filterOptions->data.sampleSize, filterOptions->data.channels, filterOptions->data.dither, newItem );
+    connect( job, SIGNAL(finished(ResampleJob*)), this, SLOT(resampleFinished(ResampleJob*)) );
+    jobs.insert( newItem->id, job );
+    job->start();
+
+    QStringList settings;
+    if( filterOptions->data.sampleRate > 0 )
+        settings += i18n("sample rate: %1 Hz", filterOptions->data.sampleRate);
+    if( filterOptions->data.sampleSize > 0 )
+        settings += i18n("sample size: %1 bit", filterOptions->data.sampleSize) + ( filterOptions->data.dither ? " (" + i18n("dithered") + ")" : "" );
+    if( filterOptions->data.channels > 0 )
+        settings += i18n("channels: %1", filterOptions->data.channels);
+    logCommand( newItem->id, i18n("Resampling \"%1\" (%2)", inputFile.toLocalFile(), settings.join(", ")) );
+
+    backendItems.append( newItem );
+    return newItem->id;
+}
+
+QStringList soundkonverter_filter_resample::convertCommand( const KUrl& inputFile, const KUrl& outputFile, const QString& inputCodec, const QString& outputCodec, const ConversionOptions *_conversionOptions, TagData *tags, bool replayGain )
+{
+    Q_UNUSED( inputFile );
+    Q_UNUSED( outputFile );
+    Q_UNUSED( inputCodec );
+    Q_UNUSED( outputCodec );
+    Q_UNUSED( _conversionOptions );
+    Q_UNUSED( tags );
+    Q_UNUSED( replayGain );
+
+    // the filter runs inside soundKonverter, there's no command that could be part of a pipe
+    return QStringList();
+}
+
+void soundkonverter_filter_resample::resampleFinished( ResampleJob *job )
+{
+    const int id = jobs.key( job );
+    jobs.remove( id );
+
+    if( !job->success() )
+        logOutput( id, job->errorString() );
+
+    for( int i=0; i<backendItems.size(); i++ )
+    {
+        if( backendItems.at(i)->id == id )
+        {
+            emit jobFinished( id, job->success() ? 0 : 1 );
+
+            backendItems.at(i)->deleteLater();
+            backendItems.removeAt(i);
+
+            return;
+        }
+    }
+}
+
+float soundkonverter_filter_resample::parseOutput( const QString& output )
+{
+    Q_UNUSED( output );
+
+    return -1;
+}
+
+FilterOptions *soundkonverter_filter_resample::filterOptionsFromXml( QDomElement filterOptions )
+{
+    ResampleFilterOptions *options = new ResampleFilterOptions();
+    options->fromXml( filterOptions );
+    return options;
+}
+
+
+#include "soundkonverter_filter_resample.moc"
@@ -0,0 +1,52 @@
+
+#ifndef SOUNDKONVERTER_FILTER_RESAMPLE_H
+#define SOUNDKONVERTER_FILTER_RESAMPLE_H
+
+#include "../../core/filterplugin.h"
+
+class FilterOptions;
+class ResampleJob;
+
+
+class soundkonverter_filter_resample : public FilterPlugin
+{
+    Q_OBJECT
+public:
+    /** Default Constructor */
+    soundkonverter_filter_resample( QObject *parent, const QStringList& args );
+
+    /** Default Destructor */
+    ~soundkonverter_filter_resample();
+
+    QString name() const;
+
+    QList<ConversionPipeTrunk> codecTable();
+
+    bool isConfigSupported( ActionType action, const QString& codecName );
+    void showConfigDialog( ActionType action, const QString& codecName, QWidget *parent );
+    bool hasInfo();
+    void showInfo( QWidget *parent );
+    bool kill( int id );
+    float progress( int id );
+
+    CodecWidget *newCodecWidget();
+    FilterWidget *newFilterWidget();
+
+    int convert( const KUrl& inputFile, const KUrl& outputFile, const QString& inputCodec, const QString& outputCodec, const ConversionOptions *_conversionOptions, TagData *tags = 0, bool replayGain = false );
+    QStringList convertCommand( const KUrl& inputFile, const KUrl& outputFile, const QString& inputCodec, const QString& outputCodec, const ConversionOptions *_conversionOptions, TagData *tags = 0, bool replayGain = false );
+    float parseOutput( const QString& output );
+
+    FilterOptions *filterOptionsFromXml( QDomElement filterOptions );
+
+private:
+    /** QMap< job id, resample job > */
+    QMap<int,ResampleJob*> jobs;
+
+private slots:
+    void resampleFinished( ResampleJob *job );
+};
+
+K_EXPORT_SOUNDKONVERTER_FILTER( resample, soundkonverter_filter_resample )
+
+
+#endif // SOUNDKONVERTER_FILTER_RESAMPLE_H
@@ -6,6 +6,7 @@
 #include "soxfilteroptions.h"
 #include "soxfilterwidget.h"
 #include "soxcodecwidget.h"
+#include "soxeffectgraph.h"
 
 #include <KDialog>
 #include <QHBoxLayout>
@@ -356,6 +357,11 @@ QStringList soundkonverter_filter_sox::convertCommand( const KUrl& inputFile, co
 
     command += binaries["sox"];
     command += "--no-glob";
+    if( !inputFile.isEmpty() )
+    {
+        // the progress can only be calculated if sox knows the length of the input
+        command += "--show-progress";
+    }
     if( conversionOptions->pluginName == name() )
     {
         command += conversionOptions->cmdArguments;
@@ -371,11 +377,6 @@ QStringList soundkonverter_filter_sox::convertCommand( const KUrl& inputFile, co
         command += "--bits";
         command += QString::number(filterOptions->data.sampleSize);
     }
-    if( filterOptions && filterOptions->data.channels )
-    {
-        command += "--channels";
-        command += QString::number(filterOptions->data.channels);
-    }
     if( outputCodec == "flac" && ( conversionOptions->pluginName == global_plugin_name || conversionOptions->pluginName == "FLAC" ) )
     {
         command += "--compression";
@@ -424,49 +425,36 @@ QStringList soundkonverter_filter_sox::convertCommand( const KUrl& inputFile, co
         command += soxCodecName(outputCodec);
     }
     command += "\"" + escapeUrl(outputFile) + "\"";
-    if( filterOptions && filterOptions->data.sampleRate )
-    {
-        command += "rate";
-        if( samplingRateQuality == "quick" )
-            command += "-q";
-        else if( samplingRateQuality == "low" )
-            command += "-l";
-        else if( samplingRateQuality == "medium" )
-            command += "-m";
-        else if( samplingRateQuality == "high" )
-            command += "-h";
-        else if( samplingRateQuality == "very high" )
-            command += "-v";
-        command += QString::number(filterOptions->data.sampleRate);
-    }
-    if( filterOptions )
-    {
-        foreach( const SoxFilterOptions::EffectData& effectData, filterOptions->data.effects )
-        {
-            if( effectData.effectName == "norm" || effectData.effectName == "bass" || effectData.effectName == "treble" )
-            {
-                command += effectData.effectName;
-                command += QString::number(effectData.data.at(0).toDouble());
-            }
-        }
-    }
+
+    QString rateQuality;
+    if( samplingRateQuality == "quick" )
+        rateQuality = "-q";
+    else if( samplingRateQuality == "low" )
+        rateQuality = "-l";
+    else if( samplingRateQuality == "medium" )
+        rateQuality = "-m";
+    else if( samplingRateQuality == "high" )
+        rateQuality = "-h";
+    else if( samplingRateQuality == "very high" )
+        rateQuality = "-v";
+
+    // all effects run in this sox process
+    const SoxEffectGraph effectGraph( filterOptions, rateQuality );
+    command += effectGraph.arguments();
 
     return command;
 }
 
 float soundkonverter_filter_sox::parseOutput( const QString& output )
 {
-    Q_UNUSED( output );
-
-//     // 01-Unknown.wav: 98% complete, ratio=0,479    // encode
-//     // 01-Unknown.wav: 27% complete                 // decode
-//
-//     QRegExp regEnc("(\\d+)% complete");
-//     if( output.contains(regEnc) )
-//     {
-//         return (float)regEnc.cap(1).toInt();
-//     }
-//
+    // In:12.34% 00:00:05.12 [00:00:36.37] Out:226k  [ -====|====- ] Hd:0.0 Clip:0
+
+    QRegExp regProgress("In:(\\d+[.,]\\d+)%");
+    if( output.lastIndexOf(regProgress) != -1 )
+    {
+        return regProgress.cap(1).replace(",",".").toFloat();
+    }
+
     return -1;
 }
 
@@ -0,0 +1,96 @@
+
+#include "soxeffectgraph.h"
+#include "soxfilteroptions.h"
+
+
+SoxEffectGraph::SoxEffectGraph( const SoxFilterOptions *filterOptions, const QString& samplingRateQuality )
+{
+    if( !filterOptions )
+        return;
+
+    if( filterOptions->data.channels )
+    {
+        Node node;
+        node.effect = "channels";
+        node.arguments += QString::number(filterOptions->data.channels);
+        nodes.append( node );
+    }
+
+    if( filterOptions->data.sampleRate )
+    {
+        Node node;
+        node.effect = "rate";
+        if( !samplingRateQuality.isEmpty() )
+            node.arguments += samplingRateQuality;
+        node.arguments += QString::number(filterOptions->data.sampleRate);
+        nodes.append( node );
+    }
+
+    bool normalize = false;
+    double normalizeLevel = 0.0;
+
+    foreach( const SoxFilterOptions::EffectData& effectData, filterOptions->data.effects )
+    {
+        if( effectData.data.isEmpty() )
+            continue;
+
+        if( effectData.effectName == "bass" || effectData.effectName == "treble" )
+        {
+            addGain( effectData.effectName, effectData.data.at(0).toDouble() );
+        }
+        else if( effectData.effectName == "norm" )
+        {
+            // only the last normalization has an effect
+            normalize = true;
+            normalizeLevel = effectData.data.at(0).toDouble();
+        }
+    }
+
+    // equalizer effects without gain do nothing
+    for( int i=0; i<nodes.count(); i++ )
+    {
+        if( ( nodes.at(i).effect == "bass" || nodes.at(i).effect == "treble" ) && nodes.at(i).arguments.first().toDouble() == 0.0 )
+        {
+            nodes.removeAt( i );
+            i--;
+        }
+    }
+
+    if( normalize )
+    {
+        Node node;
+        node.effect = "norm";
+        node.arguments += QString::number(normalizeLevel);
+        nodes.append( node );
+    }
+}
+
+QStringList SoxEffectGraph::arguments() const
+{
+    QStringList arguments;
+
+    foreach( const Node& node, nodes )
+    {
+        arguments += node.effect;
+        arguments += node.arguments;
+    }
+
+    return arguments;
+}
+
+void SoxEffectGraph::addGain( const QString& effect, double gain )
+{
+    for( int i=0; i<nodes.count(); i++ )
+    {
+        if( nodes.at(i).effect == effect )
+        {
+            nodes[i].arguments[0] = QString::number( nodes.at(i).arguments.first().toDouble() + gain );
+            return;
+        }
+    }
+
+    Node node;
+    node.effect = effect;
+    node.arguments += QString::number(gain);
+    nodes.append( node );
+}
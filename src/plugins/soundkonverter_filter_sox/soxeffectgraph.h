@@ -0,0 +1,43 @@
+
+#ifndef SOXEFFECTGRAPH_H
+#define SOXEFFECTGRAPH_H
+
+#include <QStringList>
+
+class SoxFilterOptions;
+
+
+/**
+ * @short The effects of a sox filter, ordered and merged so sox can run them in one process
+ *
+ * The graph is a chain of nodes that sox processes sample block by sample block. Channel
+ * reduction runs before the sample rate conversion so fewer channels have to be resampled,
+ * equalizer effects of the same kind are merged into one node and the normalization runs
+ * last so it accounts for the gain of all other effects.
+ */
+class SoxEffectGraph
+{
+public:
+    struct Node
+    {
+        QString effect;
+        QStringList arguments;
+    };
+
+    /** @p samplingRateQuality is the rate effect's quality option, e.g. "-h" */
+    SoxEffectGraph( const SoxFilterOptions *filterOptions, const QString& samplingRateQuality );
+
+    bool isEmpty() const { return nodes.isEmpty(); }
+    QList<Node> effects() const { return nodes; }
+
+    /** The effects for the sox command line */
+    QStringList arguments() const;
+
+private:
+    /** Adds @p gain to the node of @p effect or appends a new node */
+    void addGain( const QString& effect, double gain );
+
+    QList<Node> nodes;
+};
+
+#endif // SOXEFFECTGRAPH_H
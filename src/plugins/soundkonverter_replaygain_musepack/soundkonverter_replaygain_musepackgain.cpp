@@ -27,9 +27,9 @@ QString soundkonverter_replaygain_musepackgain::name() const
 
 void soundkonverter_replaygain_musepackgain::scanForBackends( const QStringList& directoryList )
 {
-    binaries["replaygain"] = KStandardDirs::findExe( "replaygain" ); // sv7
+    binaries["replaygain"] = findExe( "replaygain" ); // sv7
     if( binaries["replaygain"].isEmpty() )
-        binaries["replaygain"] = KStandardDirs::findExe( "mpcgain" ); // sv8
+        binaries["replaygain"] = findExe( "mpcgain" ); // sv8
 
     if( binaries["replaygain"].isEmpty() )
     {
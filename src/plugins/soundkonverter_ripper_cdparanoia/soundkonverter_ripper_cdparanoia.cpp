@@ -13,6 +13,9 @@
 #include <KLocale>
 #include <KDialog>
 
+#include <solid/device.h>
+#include <solid/block.h>
+
 
 soundkonverter_ripper_cdparanoia::soundkonverter_ripper_cdparanoia( QObject *parent, const QStringList& args  )
     : RipperPlugin( parent )
@@ -21,6 +24,10 @@ soundkonverter_ripper_cdparanoia::soundkonverter_ripper_cdparanoia( QObject *par
 
     configDialogForceReadSpeedCheckBox = 0;
     configDialogForceReadSpeedSpinBox = 0;
+    configDialogDriveComboBox = 0;
+    configDialogDriveReadSpeedSpinBox = 0;
+    configDialogDriveSampleOffsetCheckBox = 0;
+    configDialogDriveSampleOffsetSpinBox = 0;
     configDialogForceEndiannessComboBox = 0;
     configDialogMaximumRetriesSpinBox = 0;
     configDialogEnableParanoiaCheckBox = 0;
@@ -33,6 +40,14 @@ soundkonverter_ripper_cdparanoia::soundkonverter_ripper_cdparanoia( QObject *par
 
     group = conf->group( "Plugin-"+name() );
     forceReadSpeed = group.readEntry( "forceReadSpeed", 0 );
+    const QStringList drives = group.readEntry( "driveReadSpeedDevices", QStringList() );
+    const QList<int> speeds = group.readEntry( "driveReadSpeeds", QList<int>() );
+    for( int i=0; i<drives.count() && i<speeds.count(); i++ )
+        driveReadSpeeds[drives.at(i)] = speeds.at(i);
+    const QStringList offsetDrives = group.readEntry( "driveSampleOffsetDevices", QStringList() );
+    const QList<int> offsets = group.readEntry( "driveSampleOffsets", QList<int>() );
+    for( int i=0; i<offsetDrives.count() && i<offsets.count(); i++ )
+        driveSampleOffsets[offsetDrives.at(i)] = offsets.at(i);
     forceEndianness = group.readEntry( "forceEndianness", 0 );
     maximumRetries = group.readEntry( "maximumRetries", 20 );
     enableParanoia = group.readEntry( "enableParanoia", true );
@@ -95,6 +110,35 @@ void soundkonverter_ripper_cdparanoia::showConfigDialog( ActionType action, cons
         configDialogBox->addLayout( configDialogBox0 );
         connect( configDialogForceReadSpeedCheckBox, SIGNAL( stateChanged(int) ), this, SLOT( configDialogForceReadSpeedChanged(int) ) );
 
+        // each drive of a tower can be limited on its own, e.g. if it gets unreliable at full speed
+        QHBoxLayout *configDialogBoxDrive = new QHBoxLayout();
+        QLabel *configDialogDriveLabel = new QLabel( i18n("Read speed of drive:"), configDialogWidget );
+        configDialogBoxDrive->addWidget( configDialogDriveLabel );
+        configDialogDriveComboBox = new QComboBox( configDialogWidget );
+        configDialogBoxDrive->addWidget( configDialogDriveComboBox );
+        configDialogDriveReadSpeedSpinBox = new QSpinBox( configDialogWidget );
+        configDialogDriveReadSpeedSpinBox->setRange(0, 64);
+        configDialogDriveReadSpeedSpinBox->setSuffix(" x");
+        configDialogDriveReadSpeedSpinBox->setSpecialValueText( i18n("Default") );
+        configDialogBoxDrive->addWidget( configDialogDriveReadSpeedSpinBox );
+        configDialogBox->addLayout( configDialogBoxDrive );
+        connect( configDialogDriveComboBox, SIGNAL( currentIndexChanged(int) ), this, SLOT( configDialogDriveChanged(int) ) );
+        connect( configDialogDriveReadSpeedSpinBox, SIGNAL( valueChanged(int) ), this, SLOT( configDialogDriveReadSpeedChanged(int) ) );
+
+        // the offset of the selected drive as listed in the AccurateRip drive database, a zero offset has to be set explicitly
+        QHBoxLayout *configDialogBoxDriveOffset = new QHBoxLayout();
+        configDialogBoxDriveOffset->addSpacing( 12 );
+        configDialogDriveSampleOffsetCheckBox = new QCheckBox( i18n("Correct read offset:"), configDialogWidget );
+        configDialogDriveSampleOffsetCheckBox->setToolTip( i18n("The read offset of the drive is needed for verifying the ripped tracks with AccurateRip") );
+        configDialogBoxDriveOffset->addWidget( configDialogDriveSampleOffsetCheckBox );
+        configDialogDriveSampleOffsetSpinBox = new QSpinBox( configDialogWidget );
+        configDialogDriveSampleOffsetSpinBox->setRange(-5000, 5000);
+        configDialogDriveSampleOffsetSpinBox->setSuffix(" " + i18n("samples"));
+        configDialogBoxDriveOffset->addWidget( configDialogDriveSampleOffsetSpinBox );
+        configDialogBox->addLayout( configDialogBoxDriveOffset );
+        connect( configDialogDriveSampleOffsetCheckBox, SIGNAL( stateChanged(int) ), this, SLOT( configDialogDriveSampleOffsetChanged() ) );
+        connect( configDialogDriveSampleOffsetSpinBox, SIGNAL( valueChanged(int) ), this, SLOT( configDialogDriveSampleOffsetChanged() ) );
+
         QHBoxLayout *configDialogBox1 = new QHBoxLayout();
         QLabel *configDialogForceEndiannessLabel = new QLabel( i18nc("Byte-Order", "Endianness:"), configDialogWidget );
         configDialogBox1->addWidget( configDialogForceEndiannessLabel );
@@ -129,6 +173,26 @@ void soundkonverter_ripper_cdparanoia::showConfigDialog( ActionType action, cons
     }
     configDialogForceReadSpeedCheckBox->setChecked( forceReadSpeed > 0 );
     configDialogForceReadSpeedSpinBox->setValue( forceReadSpeed );
+    configDialogDriveReadSpeeds = driveReadSpeeds;
+    configDialogDriveSampleOffsets = driveSampleOffsets;
+    QStringList drives = driveReadSpeeds.keys();
+    foreach( const QString& drive, driveSampleOffsets.keys() )
+    {
+        if( !drives.contains(drive) )
+            drives.append( drive );
+    }
+    foreach( const Solid::Device& solidDevice, Solid::Device::listFromType(Solid::DeviceInterface::OpticalDrive, QString()) )
+    {
+        const Solid::Block *block = solidDevice.as<Solid::Block>();
+        if( block && !drives.contains(block->device()) )
+            drives.append( block->device() );
+    }
+    configDialogDriveComboBox->clear();
+    configDialogDriveComboBox->addItems( drives );
+    configDialogDriveComboBox->setEnabled( !drives.isEmpty() );
+    configDialogDriveReadSpeedSpinBox->setEnabled( !drives.isEmpty() );
+    configDialogDriveSampleOffsetCheckBox->setEnabled( !drives.isEmpty() );
+    configDialogDriveChanged( configDialogDriveComboBox->currentIndex() );
     configDialogForceEndiannessComboBox->setCurrentIndex( forceEndianness );
     configDialogMaximumRetriesSpinBox->setValue( maximumRetries );
     configDialogEnableParanoiaCheckBox->setChecked( enableParanoia );
@@ -147,11 +211,57 @@ void soundkonverter_ripper_cdparanoia::configDialogForceReadSpeedChanged( int st
     }
 }
 
+void soundkonverter_ripper_cdparanoia::configDialogDriveChanged( int index )
+{
+    if( configDialog.data() && index >= 0 )
+    {
+        const QString drive = configDialogDriveComboBox->itemText(index);
+        const bool offsetKnown = configDialogDriveSampleOffsets.contains( drive );
+        configDialogDriveReadSpeedSpinBox->setValue( configDialogDriveReadSpeeds.value(drive,0) );
+        // setting the widgets would overwrite the offset of the new drive with the old value
+        configDialogDriveSampleOffsetCheckBox->blockSignals( true );
+        configDialogDriveSampleOffsetSpinBox->blockSignals( true );
+        configDialogDriveSampleOffsetCheckBox->setChecked( offsetKnown );
+        configDialogDriveSampleOffsetSpinBox->setValue( configDialogDriveSampleOffsets.value(drive,0) );
+        configDialogDriveSampleOffsetSpinBox->setEnabled( offsetKnown );
+        configDialogDriveSampleOffsetCheckBox->blockSignals( false );
+        configDialogDriveSampleOffsetSpinBox->blockSignals( false );
+    }
+}
+
+void soundkonverter_ripper_cdparanoia::configDialogDriveReadSpeedChanged( int speed )
+{
+    if( configDialog.data() && configDialogDriveComboBox->currentIndex() >= 0 )
+    {
+        const QString drive = configDialogDriveComboBox->currentText();
+        if( speed > 0 )
+            configDialogDriveReadSpeeds[drive] = speed;
+        else
+            configDialogDriveReadSpeeds.remove( drive );
+    }
+}
+
+void soundkonverter_ripper_cdparanoia::configDialogDriveSampleOffsetChanged()
+{
+    if( configDialog.data() && configDialogDriveComboBox->currentIndex() >= 0 )
+    {
+        const QString drive = configDialogDriveComboBox->currentText();
+        const bool offsetKnown = configDialogDriveSampleOffsetCheckBox->isChecked();
+        if( offsetKnown )
+            configDialogDriveSampleOffsets[drive] = configDialogDriveSampleOffsetSpinBox->value();
+        else
+            configDialogDriveSampleOffsets.remove( drive );
+        configDialogDriveSampleOffsetSpinBox->setEnabled( offsetKnown );
+    }
+}
+
 void soundkonverter_ripper_cdparanoia::configDialogSave()
 {
     if( configDialog.data() )
     {
         forceReadSpeed = configDialogForceReadSpeedCheckBox->isChecked() ? configDialogForceReadSpeedSpinBox->value() : 0;
+        driveReadSpeeds = configDialogDriveReadSpeeds;
+        driveSampleOffsets = configDialogDriveSampleOffsets;
         forceEndianness = configDialogForceEndiannessComboBox->currentIndex();
         maximumRetries = configDialogMaximumRetriesSpinBox->value();
         enableParanoia = configDialogEnableParanoiaCheckBox->isChecked();
@@ -162,6 +272,10 @@ void soundkonverter_ripper_cdparanoia::configDialogSave()
 
         group = conf->group( "Plugin-"+name() );
         group.writeEntry( "forceReadSpeed", forceReadSpeed );
+        group.writeEntry( "driveReadSpeedDevices", driveReadSpeeds.keys() );
+        group.writeEntry( "driveReadSpeeds", driveReadSpeeds.values() );
+        group.writeEntry( "driveSampleOffsetDevices", driveSampleOffsets.keys() );
+        group.writeEntry( "driveSampleOffsets", driveSampleOffsets.values() );
         group.writeEntry( "forceEndianness", forceEndianness );
         group.writeEntry( "maximumRetries", maximumRetries );
         group.writeEntry( "enableParanoia", enableParanoia );
@@ -177,6 +291,11 @@ void soundkonverter_ripper_cdparanoia::configDialogDefault()
     {
         configDialogForceReadSpeedCheckBox->setChecked( false );
         configDialogForceReadSpeedSpinBox->setValue( 1 );
+        configDialogDriveReadSpeeds.clear();
+        configDialogDriveReadSpeedSpinBox->setValue( 0 );
+        configDialogDriveSampleOffsets.clear();
+        configDialogDriveSampleOffsetCheckBox->setChecked( false );
+        configDialogDriveSampleOffsetSpinBox->setValue( 0 );
         configDialogForceEndiannessComboBox->setCurrentIndex( 0 );
         configDialogMaximumRetriesSpinBox->setValue( 20 );
         configDialogEnableParanoiaCheckBox->setChecked( true );
@@ -202,10 +321,11 @@ int soundkonverter_ripper_cdparanoia::rip( const QString& device, int track, int
     command += "--stderr-progress";
     command += "--force-cdrom-device";
     command += device;
-    if( forceReadSpeed > 0 )
+    const int readSpeed = driveReadSpeeds.value( device, forceReadSpeed );
+    if( readSpeed > 0 )
     {
         command += "--force-read-speed";
-        command += QString::number(forceReadSpeed);
+        command += QString::number(readSpeed);
     }
     if( forceEndianness == 1 )
     {
@@ -215,6 +335,11 @@ int soundkonverter_ripper_cdparanoia::rip( const QString& device, int track, int
     {
         command += "--force-cdrom-big-endian";
     }
+    if( driveSampleOffsets.contains(device) )
+    {
+        command += "--sample-offset";
+        command += QString::number(driveSampleOffsets.value(device));
+    }
     command += "--never-skip=" + QString::number(maximumRetries);
     if( !enableExtraParanoia )
     {
@@ -268,6 +393,11 @@ QStringList soundkonverter_ripper_cdparanoia::ripCommand( const QString& device,
     return QStringList();
 }
 
+bool soundkonverter_ripper_cdparanoia::isReadOffsetCorrected( const QString& device )
+{
+    return driveSampleOffsets.contains( device );
+}
+
 float soundkonverter_ripper_cdparanoia::parseOutput( const QString& output, int *fromSector, int *toSector )
 {
     // Ripping from sector       0 (track  1 [0:00.00])
@@ -7,6 +7,7 @@
 #include <KUrl>
 #include <KProcess>
 #include <QList>
+#include <QMap>
 #include <QWeakPointer>
 
 class KDialog;
@@ -36,6 +37,7 @@ public:
 
     int rip( const QString& device, int track, int tracks, const KUrl& outputFile );
     QStringList ripCommand( const QString& device, int track, int tracks, const KUrl& outputFile );
+    bool isReadOffsetCorrected( const QString& device );
     float parseOutput( const QString& output, int *fromSector, int *toSector );
     float parseOutput( const QString& output );
 
@@ -47,12 +49,24 @@ private:
     QWeakPointer<KDialog> configDialog;
     QCheckBox *configDialogForceReadSpeedCheckBox;
     QSpinBox *configDialogForceReadSpeedSpinBox;
+    QComboBox *configDialogDriveComboBox;
+    QSpinBox *configDialogDriveReadSpeedSpinBox;
+    /** the read speeds of the drives as edited in the config dialog */
+    QMap<QString,int> configDialogDriveReadSpeeds;
+    QCheckBox *configDialogDriveSampleOffsetCheckBox;
+    QSpinBox *configDialogDriveSampleOffsetSpinBox;
+    /** the read offsets of the drives as edited in the config dialog */
+    QMap<QString,int> configDialogDriveSampleOffsets;
     QComboBox *configDialogForceEndiannessComboBox;
     QSpinBox *configDialogMaximumRetriesSpinBox;
     QCheckBox *configDialogEnableParanoiaCheckBox;
     QCheckBox *configDialogEnableExtraParanoiaCheckBox;
 
     int forceReadSpeed;
+    /** QMap< device, read speed >, overrides forceReadSpeed for single drives */
+    QMap<QString,int> driveReadSpeeds;
+    /** QMap< device, read offset in samples >, drives without an entry aren't corrected */
+    QMap<QString,int> driveSampleOffsets;
     int forceEndianness;
     int maximumRetries;
     bool enableParanoia;
@@ -60,6 +74,9 @@ private:
 
 private slots:
     void configDialogForceReadSpeedChanged( int state );
+    void configDialogDriveChanged( int index );
+    void configDialogDriveReadSpeedChanged( int speed );
+    void configDialogDriveSampleOffsetChanged();
     void configDialogSave();
     void configDialogDefault();
 };
@@ -0,0 +1,184 @@
+
+#include "prefetcher.h"
+#include "config.h"
+
+#include <kio/job.h>
+#include <kio/jobclasses.h>
+
+#include <KStandardDirs>
+
+#include <QFile>
+#include <QFileInfo>
+
+
+// the number of files that get downloaded at once
+#define MaxConnections 3
+// don't start new downloads if the downloaded but not yet converted files need more than this [MiB]
+#define CacheLimit 1024
+
+
+Prefetcher::Prefetcher( Config *_config, QObject *parent )
+    : QObject( parent ),
+    config( _config ),
+    fileCounter( 0 )
+{}
+
+Prefetcher::~Prefetcher()
+{
+    // cancel() would start the next downloads otherwise
+    queue.clear();
+
+    foreach( const QString& url, entries.keys() )
+    {
+        cancel( url );
+    }
+}
+
+void Prefetcher::prefetch( const KUrl::List& urls )
+{
+    queue.clear();
+
+    foreach( const KUrl& url, urls )
+    {
+        if( !entries.contains(url.url()) )
+            queue.append( url );
+    }
+
+    startDownloads();
+}
+
+bool Prefetcher::contains( const KUrl& url ) const
+{
+    return entries.contains( url.url() );
+}
+
+bool Prefetcher::isFinished( const KUrl& url ) const
+{
+    return entries.contains(url.url()) && entries.value(url.url()).finished;
+}
+
+KUrl Prefetcher::take( const KUrl& url )
+{
+    if( !isFinished(url) )
+        return KUrl();
+
+    const KUrl localUrl = entries.take( url.url() ).localUrl;
+
+    // there's space in the cache again
+    startDownloads();
+
+    return localUrl;
+}
+
+void Prefetcher::cancel( const KUrl& url )
+{
+    queue.removeAll( url );
+
+    if( !entries.contains(url.url()) )
+        return;
+
+    const Entry entry = entries.take( url.url() );
+    if( entry.job.data() )
+        entry.job.data()->kill( KJob::Quietly );
+
+    if( QFile::exists(entry.localUrl.toLocalFile()) )
+        QFile::remove( entry.localUrl.toLocalFile() );
+    if( QFile::exists(entry.localUrl.toLocalFile()+".part") )
+        QFile::remove( entry.localUrl.toLocalFile()+".part" );
+
+    startDownloads();
+}
+
+void Prefetcher::jobFinished( KJob *job )
+{
+    for( QMap<QString,Entry>::iterator it = entries.begin(); it != entries.end(); ++it )
+    {
+        if( it.value().job.data() == job )
+        {
+            const KUrl url( it.key() );
+
+            if( job->error() == 0 )
+            {
+                it.value().finished = true;
+                it.value().size = QFileInfo( it.value().localUrl.toLocalFile() ).size();
+            }
+            else
+            {
+                if( QFile::exists(it.value().localUrl.toLocalFile()) )
+                    QFile::remove( it.value().localUrl.toLocalFile() );
+                entries.erase( it );
+            }
+
+            emit finished( url, job->error() == 0 );
+            break;
+        }
+    }
+
+    startDownloads();
+}
+
+void Prefetcher::startDownloads()
+{
+    while( !queue.isEmpty() && runningCount() < MaxConnections && cacheSize() < (qint64)CacheLimit*1024*1024 )
+    {
+        const KUrl url = queue.takeFirst();
+
+        Entry entry;
+        entry.localUrl = generateLocalUrl( url );
+        entry.finished = false;
+        entry.size = 0;
+        entry.job = KIO::file_copy( url, entry.localUrl, -1, KIO::HideProgressInfo );
+        connect( entry.job.data(), SIGNAL(result(KJob*)), this, SLOT(jobFinished(KJob*)) );
+
+        entries.insert( url.url(), entry );
+    }
+}
+
+KUrl Prefetcher::generateLocalUrl( const KUrl& url )
+{
+    const QString extension = url.fileName().mid( url.fileName().lastIndexOf(".") + 1 );
+
+    // the size of the file is unknown, so only use the shared memory if it can hold the whole cache
+    const bool useSharedMemory = config->data.advanced.useSharedMemoryForTempFiles && config->data.advanced.maxSizeForSharedMemoryTempFiles >= CacheLimit;
+
+    QString localPath;
+    int i = fileCounter;
+    do {
+        const QString fileName = QString("soundkonverter_temp_prefetch_%1.%2").arg(i).arg(extension);
+        localPath = useSharedMemory ? "/dev/shm/" + fileName : KStandardDirs::locateLocal( "tmp", fileName );
+        i++;
+    } while( QFile::exists(localPath) );
+
+    fileCounter = i;
+
+    return KUrl( localPath );
+}
+
+int Prefetcher::runningCount() const
+{
+    int count = 0;
+    foreach( const Entry& entry, entries )
+    {
+        if( !entry.finished )
+            count++;
+    }
+    return count;
+}
+
+qint64 Prefetcher::cacheSize() const
+{
+    qint64 size = 0;
+    foreach( const Entry& entry, entries )
+    {
+        if( entry.finished )
+        {
+            size += entry.size;
+        }
+        else if( entry.job.data() )
+        {
+            // running downloads need their full size, the total size is unknown until the transfer has started
+            size += qMax( entry.job.data()->totalAmount(KJob::Bytes), entry.job.data()->processedAmount(KJob::Bytes) );
+        }
+    }
+    return size;
+}
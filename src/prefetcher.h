@@ -0,0 +1,79 @@
+
+#ifndef PREFETCHER_H
+#define PREFETCHER_H
+
+#include <KUrl>
+
+#include <QObject>
+#include <QMap>
+#include <QWeakPointer>
+
+class Config;
+class KJob;
+
+namespace KIO {
+    class FileCopyJob;
+}
+
+
+/**
+ * @short Downloads remote files before they get converted
+ *
+ * The file list tells the prefetcher which remote files are next in the queue, they are
+ * downloaded in parallel into a local cache, so the conversion doesn't have to wait for
+ * the network. The cache is limited in size, files are only prefetched as long as there's
+ * space left.
+ */
+class Prefetcher : public QObject
+{
+    Q_OBJECT
+public:
+    Prefetcher( Config *_config, QObject *parent );
+    ~Prefetcher();
+
+    /** Starts downloading @p urls in the given order, as far as the connection and cache limits allow */
+    void prefetch( const KUrl::List& urls );
+
+    /** Returns true if @p url is being downloaded or has been downloaded */
+    bool contains( const KUrl& url ) const;
+    /** Returns true if the download of @p url has finished successfully */
+    bool isFinished( const KUrl& url ) const;
+
+    /** Returns the local copy of @p url and removes it from the cache, the caller has to delete the file */
+    KUrl take( const KUrl& url );
+    /** Stops the download of @p url and deletes the local copy */
+    void cancel( const KUrl& url );
+
+signals:
+    /** The download of @p url has finished */
+    void finished( const KUrl& url, bool success );
+
+private slots:
+    void jobFinished( KJob *job );
+
+private:
+    struct Entry
+    {
+        KUrl localUrl;
+        QWeakPointer<KIO::FileCopyJob> job;
+        bool finished;
+        qint64 size;
+    };
+
+    /** Starts the next downloads from the queue */
+    void startDownloads();
+    KUrl generateLocalUrl( const KUrl& url );
+    int runningCount() const;
+    /** Returns the size of the downloaded and the running downloads */
+    qint64 cacheSize() const;
+
+    Config *config;
+
+    /** QMap< remote url, entry > */
+    QMap<QString,Entry> entries;
+    /** urls that should be downloaded as soon as there's a free connection */
+    KUrl::List queue;
+    int fileCounter;
+};
+
+#endif // PREFETCHER_H
@@ -56,6 +56,15 @@ float TrailingAverage::average()
     return _deltaValue / _deltaTime;
 }
 
+float TrailingAverage::time()
+{
+    float _deltaTime = 0;
+    foreach( const float time, deltaTime )
+        _deltaTime += time;
+
+    return _deltaTime;
+}
+
 
 ProgressIndicator::ProgressIndicator( QWidget *parent, Feature features )
     : QWidget( parent ),
@@ -65,6 +74,8 @@ ProgressIndicator::ProgressIndicator( QWidget *parent, Feature features )
     const int fontHeight = QFontMetrics(QApplication::font()).boundingRect("M").size().height();
 
     totalTime = processedTime = 0;
+    lastProcessedTime = 0;
+    expectedSpeed = 0;
 
     QHBoxLayout *box = new QHBoxLayout( this );
     box->setContentsMargins( 0, 0, 0, 0 );
@@ -164,6 +175,11 @@ void ProgressIndicator::finished( bool reset )
     emit progressChanged( i18n("Finished") );
 }
 
+void ProgressIndicator::setExpectedSpeed( float speed )
+{
+    expectedSpeed = speed;
+}
+
 void ProgressIndicator::update( float timeProgress )
 {
     const float currentProcessedTime = processedTime + timeProgress;
@@ -179,13 +195,21 @@ void ProgressIndicator::update( float timeProgress )
 
         if( updateTime.elapsed() >= 1000 )
         {
-            const float deltaTime = updateTime.restart() / 1000;
+            const float deltaTime = updateTime.restart() / 1000.0f;
 
             if( lTime )
             {
                 timeAverage.addData( deltaTime, currentProcessedTime - lastProcessedTime );
+                float speed = timeAverage.average();
+                if( expectedSpeed > 0.0f )
+                {
+                    // the measured speed jumps around at the beginning, so weight it with the expected speed until 30 seconds have been measured
+                    const float measuredTime = timeAverage.time();
+                    const float expectedTime = qMax( 0.0f, 30.0f - measuredTime );
+                    speed = ( speed * measuredTime + expectedSpeed * expectedTime ) / ( measuredTime + expectedTime );
+                }
                 const float remainingProcessTime = totalTime - currentProcessedTime;
-                const float remainingTime = remainingProcessTime / timeAverage.average() + 1;
+                const float remainingTime = remainingProcessTime / speed + 1;
 
                 lTime->setText( "<pre>" + Global::prettyNumber(remainingTime,"s") + "</pre>" );
             }
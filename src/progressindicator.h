@@ -19,6 +19,8 @@ public:
     void setCount( int _count );
     void addData( float _deltaTime, float _deltaValue );
     float average();
+    /** the time span covered by the data */
+    float time();
 
 private:
     int count;
@@ -51,6 +53,8 @@ public slots:
     void finished( bool reset );
 
     void update( float timeProgress );
+    /** The speed that is expected from previous conversions, it's used until enough has been measured */
+    void setExpectedSpeed( float speed );
 
 private:
     QProgressBar *pBar;
@@ -62,6 +66,7 @@ private:
 
     QTime updateTime;
     float lastProcessedTime;
+    float expectedSpeed;
     TrailingAverage timeAverage;
     TrailingAverage speedAverage;
 
@@ -0,0 +1,152 @@
+
+#include "ripverifier.h"
+
+
+// 16 bit stereo
+#define BytesPerSample 4
+#define SamplesPerSector 588
+// the number of samples that get read at once
+#define ReadBlockSize (64*1024)
+
+
+static const quint32 *crcTable()
+{
+    static quint32 table[256];
+    static bool initialized = false;
+
+    if( !initialized )
+    {
+        for( quint32 i=0; i<256; i++ )
+        {
+            quint32 value = i;
+            for( int j=0; j<8; j++ )
+                value = ( value & 1 ) ? ( value >> 1 ) ^ 0xEDB88320 : value >> 1;
+
+            table[i] = value;
+        }
+        initialized = true;
+    }
+
+    return table;
+}
+
+
+RipVerifier::RipVerifier( const QString& fileName, const QList<int>& discOffsets, int track )
+    : file( fileName ),
+    dataOffset( -1 ),
+    samplesRead( 0 ),
+    crc( 0xFFFFFFFF ),
+    arV1( 0 ),
+    arV2( 0 )
+{
+    sampleCount = (qint64)( discOffsets.at(track) - discOffsets.at(track-1) ) * SamplesPerSector;
+
+    checkFrom = ( track == 1 ) ? 5 * SamplesPerSector : 0;
+    checkTo = ( track == discOffsets.count() - 1 ) ? sampleCount - 5 * SamplesPerSector : sampleCount;
+}
+
+RipVerifier::~RipVerifier()
+{}
+
+bool RipVerifier::update()
+{
+    if( !file.isOpen() )
+    {
+        // the ripper hasn't created the file yet
+        if( !file.exists() )
+            return true;
+
+        if( !file.open(QIODevice::ReadOnly) )
+            return false;
+    }
+
+    if( dataOffset < 0 && !readHeader() )
+        return true;
+
+    const qint64 available = qMin( ( file.size() - dataOffset ) / BytesPerSample, sampleCount );
+    if( available <= samplesRead )
+        return true;
+
+    if( !file.seek(dataOffset + samplesRead * BytesPerSample) )
+        return false;
+
+    QByteArray buffer;
+    while( samplesRead < available )
+    {
+        const int count = (int)qMin( available - samplesRead, (qint64)ReadBlockSize );
+        buffer.resize( count * BytesPerSample );
+        if( file.read(buffer.data(),buffer.size()) != buffer.size() )
+            return false;
+
+        process( (const uchar*)buffer.constData(), count );
+    }
+
+    return true;
+}
+
+bool RipVerifier::finish()
+{
+    const bool success = update() && dataOffset >= 0 && samplesRead == sampleCount;
+
+    file.close();
+
+    return success;
+}
+
+bool RipVerifier::readHeader()
+{
+    file.seek( 0 );
+    const QByteArray riff = file.read( 12 );
+    if( riff.size() < 12 )
+        return false;
+
+    if( !riff.startsWith("RIFF") || riff.mid(8,4) != "WAVE" )
+        return false;
+
+    qint64 position = 12;
+    while( file.seek(position) )
+    {
+        const QByteArray chunk = file.read( 8 );
+        if( chunk.size() < 8 )
+            return false;
+
+        const uchar *data = (const uchar*)chunk.constData();
+        const qint64 size = data[4] | data[5] << 8 | data[6] << 16 | (quint32)data[7] << 24;
+
+        if( chunk.startsWith("data") )
+        {
+            dataOffset = position + 8;
+            return true;
+        }
+
+        position += 8 + size + ( size & 1 );
+    }
+
+    return false;
+}
+
+void RipVerifier::process( const uchar *data, int count )
+{
+    const quint32 *table = crcTable();
+
+    for( int i=0; i<count*BytesPerSample; i++ )
+        crc = table[( crc ^ data[i] ) & 0xFF] ^ ( crc >> 8 );
+
+    for( int i=0; i<count; i++ )
+    {
+        // AccurateRip counts the samples from 1
+        const quint32 position = (quint32)( samplesRead + i + 1 );
+        if( position < checkFrom || position > checkTo )
+            continue;
+
+        const uchar *sample = data + i * BytesPerSample;
+        const quint32 value = sample[0] | sample[1] << 8 | sample[2] << 16 | (quint32)sample[3] << 24;
+
+        arV1 += value * position;
+
+        const quint64 product = (quint64)value * position;
+        arV2 += (quint32)product + (quint32)( product >> 32 );
+    }
+
+    samplesRead += count;
+}
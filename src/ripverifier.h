@@ -0,0 +1,56 @@
+
+#ifndef RIPVERIFIER_H
+#define RIPVERIFIER_H
+
+#include <QFile>
+#include <QList>
+
+
+/**
+ * @short Calculates the checksums of a track while it is being ripped
+ *
+ * The ripper writes the track to a wav file, update() reads the samples that have been written
+ * since the last call, so they are still in the page cache and no extra pass is needed.
+ * Besides the CRC32 of the audio data the AccurateRip v1 and v2 checksums get calculated,
+ * which can be compared with the AccurateRip database by AccurateRipDatabase.
+ */
+class RipVerifier
+{
+public:
+    /**
+     * @p discOffsets are the start sectors of all audio tracks of the disc (+150) followed by the lead-out,
+     * @p track is the number of the ripped track
+     */
+    RipVerifier( const QString& fileName, const QList<int>& discOffsets, int track );
+    ~RipVerifier();
+
+    /** Reads the samples that have been written so far, returns false on a read error */
+    bool update();
+    /** Reads the rest of the file, returns false if the track couldn't be read completely */
+    bool finish();
+
+    quint32 crc32() const { return crc ^ 0xFFFFFFFF; }
+    quint32 accurateRipV1() const { return arV1; }
+    quint32 accurateRipV2() const { return arV2; }
+
+private:
+    /** Finds the data chunk, returns false as long as the header hasn't been written completely */
+    bool readHeader();
+    void process( const uchar *data, int count );
+
+    QFile file;
+    /** the position of the samples in the file, -1 if unknown */
+    qint64 dataOffset;
+    /** the number of samples (stereo frames) in the track and the number of samples read so far */
+    qint64 sampleCount;
+    qint64 samplesRead;
+    /** AccurateRip skips the first and last 5 sectors of the disc */
+    qint64 checkFrom;
+    qint64 checkTo;
+
+    quint32 crc;
+    quint32 arV1;
+    quint32 arV2;
+};
+
+#endif // RIPVERIFIER_H
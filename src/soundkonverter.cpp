@@ -12,6 +12,10 @@
 #include "logviewer.h"
 #include "replaygainscanner/replaygainscanner.h"
 #include "aboutplugins.h"
+#include "folderwatcher.h"
+#include "outputdirectory.h"
+#include "core/conversionoptions.h"
+#include "startuptrace.h"
 
 #include <taglib.h>
 
@@ -36,8 +40,12 @@ soundKonverter::soundKonverter()
     : KXmlGuiWindow(),
       logViewer( 0 ),
       systemTray( 0 ),
-      autoclose( false )
+      autoclose( false ),
+      folderWatcher( 0 ),
+      watchConversionOptions( 0 )
 {
+    StartupTrace::Span span( "soundKonverter::soundKonverter" );
+
     // accept dnd
     setAcceptDrops(true);
 
@@ -56,9 +64,15 @@ soundKonverter::soundKonverter()
     #endif
 
     config = new Config( logger, this );
-    config->load();
+    {
+        StartupTrace::Span span( "Config::load" );
+        config->load();
+    }
 
-    m_view = new soundKonverterView( logger, config, cdManager, this );
+    {
+        StartupTrace::Span span( "soundKonverterView::soundKonverterView" );
+        m_view = new soundKonverterView( logger, config, cdManager, this );
+    }
     connect( m_view, SIGNAL(signalConversionStarted()), this, SLOT(conversionStarted()) );
     connect( m_view, SIGNAL(signalConversionStopped(bool)), this, SLOT(conversionStopped(bool)) );
     connect( m_view, SIGNAL(progressChanged(const QString&)), this, SLOT(progressChanged(const QString&)) );
@@ -75,6 +89,7 @@ soundKonverter::soundKonverter()
     // It also applies the saved mainwindow settings, if any, and ask the
     // mainwindow to automatically save settings if changed: window size,
     // toolbar position, icon size, etc.
+    StartupTrace::Span guiSpan( "setupGUI" );
     setupGUI( QSize(70*fontHeight,45*fontHeight), ToolBar | Keys | Save | Create );
 }
 
@@ -88,6 +103,8 @@ soundKonverter::~soundKonverter()
 
     if( systemTray )
         delete systemTray;
+
+    delete watchConversionOptions;
 }
 
 void soundKonverter::saveProperties( KConfigGroup& configGroup )
@@ -265,8 +282,65 @@ void soundKonverter::loadFileList(const QString& fileListPath)
     m_view->loadFileList(fileListPath);
 }
 
+void soundKonverter::watchDirectories( const QStringList& directories, const QString& profile, const QString& format, const QString& directory, const QString& notifyCommand )
+{
+    // the options must be complete, there's nobody to ask when the files arrive
+    ConversionOptions *conversionOptions = m_view->createConversionOptions( profile, format, directory );
+    if( !conversionOptions )
+    {
+        logger->log( 1000, i18n("Cannot watch directories, the profile, the format and the output directory must be given") );
+        KMessageBox::error( this, i18n("The directories can't be watched.\nPlease give a valid profile, format and output directory or the name of a user defined profile.") );
+        return;
+    }
+
+    delete watchConversionOptions;
+    watchConversionOptions = conversionOptions;
+    watchNotifyCommand = notifyCommand;
+
+    if( !folderWatcher )
+    {
+        folderWatcher = new FolderWatcher( config, logger, this );
+        connect( folderWatcher, SIGNAL(filesReady(const KUrl::List&,const QStringList&)), this, SLOT(watchedFilesReady(const KUrl::List&,const QStringList&)) );
+        connect( m_view, SIGNAL(outputFileCreated(const QString&)), folderWatcher, SLOT(ignoreFile(const QString&)) );
+    }
+
+    // the output files are ignored one by one as well, but that doesn't cover the source directory mode
+    QString outputDirectory;
+    if( conversionOptions->outputDirectoryMode == OutputDirectory::Specify || conversionOptions->outputDirectoryMode == OutputDirectory::CopyStructure )
+    {
+        outputDirectory = conversionOptions->outputDirectory;
+    }
+    else if( conversionOptions->outputDirectoryMode == OutputDirectory::MetaData )
+    {
+        // the part of the template before the first placeholder
+        const QString fixedPart = conversionOptions->outputDirectory.left( conversionOptions->outputDirectory.indexOf("%") );
+        outputDirectory = fixedPart.left( fixedPart.lastIndexOf("/") );
+    }
+    folderWatcher->setExcludedDirectory( outputDirectory );
+
+    foreach( const QString& watchDirectory, directories )
+    {
+        folderWatcher->addDirectory( watchDirectory );
+    }
+}
+
+void soundKonverter::watchedFilesReady( const KUrl::List& urls, const QStringList& codecNames )
+{
+    // the codecs have been detected already, add the files grouped by their codec
+    QMap<QString,KUrl::List> codecUrls;
+    for( int i=0; i<urls.count(); i++ )
+        codecUrls[codecNames.at(i)].append( urls.at(i) );
+
+    for( QMap<QString,KUrl::List>::const_iterator it = codecUrls.constBegin(); it != codecUrls.constEnd(); ++it )
+        m_view->addConvertFiles( it.value(), watchConversionOptions, it.key(), watchNotifyCommand );
+
+    m_view->startConversion();
+}
+
 void soundKonverter::startupChecks()
 {
+    StartupTrace::Span span( "soundKonverter::startupChecks" );
+
     // check if codec plugins could be loaded
     if( config->pluginLoader()->getAllCodecPlugins().count() == 0 )
     {
@@ -19,6 +19,8 @@ class Logger;
 class LogViewer;
 class CDManager;
 class ReplayGainScanner;
+class FolderWatcher;
+class ConversionOptions;
 
 #if KDE_IS_VERSION(4,4,0)
     class KStatusNotifierItem;
@@ -56,6 +58,8 @@ public:
     void loadAutosaveFileList();
     void loadFileList(const QString& fileListPath);
     void startupChecks();
+    /** Converts all files that get added to @p directories using the given options */
+    void watchDirectories( const QStringList& directories, const QString& profile, const QString& format, const QString& directory, const QString& notifyCommand );
 
 private slots:
     void showConfigDialog();
@@ -65,6 +69,8 @@ private slots:
     void showMainWindow();
     void showAboutPlugins();
     void progressChanged( const QString& progress );
+    /** New files have arrived in a watched directory */
+    void watchedFilesReady( const KUrl::List& urls, const QStringList& codecNames );
 
     /** The conversion has started */
     void conversionStarted();
@@ -89,6 +95,11 @@ private:
     /// exit soundkonverter after all files have been converted
     bool autoclose;
 
+    FolderWatcher *folderWatcher;
+    /// the options used for files from the watched directories
+    ConversionOptions *watchConversionOptions;
+    QString watchNotifyCommand;
+
     void setupActions();
 
 };
@@ -1,6 +1,7 @@
 
 #include "soundkonverterapp.h"
 #include "soundkonverter.h"
+#include "startuptrace.h"
 
 #include <KCmdLineArgs>
 #include <KStandardDirs>
@@ -38,6 +39,7 @@ int soundKonverterApp::newInstance()
     const QString directory = args->getOption( "output" );
     const QString notifyCommand = args->getOption( "command" );
     const QString fileListPath = args->getOption( "file-list" );
+    const QStringList watchDirectories = args->getOptionList( "watch" );
 
     if( args->isSet( "invisible" ) )
     {
@@ -58,6 +60,7 @@ int soundKonverterApp::newInstance()
         }
         mainWindow->show();
         kapp->processEvents();
+        StartupTrace::Span span( "soundKonverter::loadAutosaveFileList" );
         mainWindow->loadAutosaveFileList();
     }
     else if( !fileListPath.isEmpty() && QFile::exists(fileListPath) )
@@ -76,6 +79,13 @@ int soundKonverterApp::newInstance()
         }
     }
 
+    if( !watchDirectories.isEmpty() )
+    {
+        // keep running while waiting for new files
+        autoclose = false;
+        mainWindow->watchDirectories( watchDirectories, profile, format, directory, notifyCommand );
+    }
+
     if( visible )
         mainWindow->show();
 
@@ -113,7 +123,10 @@ int soundKonverterApp::newInstance()
         mainWindow->startConversion();
 
     if( first )
+    {
         mainWindow->startupChecks();
+        StartupTrace::write();
+    }
 
     first = false;
 
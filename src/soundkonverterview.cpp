@@ -127,14 +127,18 @@ soundKonverterView::soundKonverterView( Logger *_logger, Config *_config, CDMana
     addBox->addWidget( progressIndicator, 0, Qt::AlignVCenter );
     connect( progressIndicator, SIGNAL(progressChanged(const QString&)), this, SIGNAL(progressChanged(const QString&)) );
     connect( fileList, SIGNAL(timeChanged(float)), progressIndicator, SLOT(timeChanged(float)) );
+    connect( fileList, SIGNAL(expectedSpeedChanged(float)), progressIndicator, SLOT(setExpectedSpeed(float)) );
     connect( fileList, SIGNAL(finished(bool)), progressIndicator, SLOT(finished(bool)) );
 
     Convert *convert = new Convert( config, fileList, logger, this );
+    fileList->setConvert( convert );
     connect( fileList, SIGNAL(convertItem(FileListItem*)), convert, SLOT(add(FileListItem*)) );
     connect( fileList, SIGNAL(killItem(FileListItem*)), convert, SLOT(kill(FileListItem*)) );
     connect( fileList, SIGNAL(itemRemoved(FileListItem*)), convert, SLOT(itemRemoved(FileListItem*)) );
+    connect( fileList, SIGNAL(prefetchItems(const QList<FileListItem*>&)), convert, SLOT(prefetch(const QList<FileListItem*>&)) );
     connect( convert, SIGNAL(finished(FileListItem*,FileListItem::ReturnCode,bool)), fileList, SLOT(itemFinished(FileListItem*,FileListItem::ReturnCode,bool)) );
     connect( convert, SIGNAL(rippingFinished(const QString&)), fileList, SLOT(rippingFinished(const QString&)) );
+    connect( convert, SIGNAL(outputFileCreated(const QString&)), this, SIGNAL(outputFileCreated(const QString&)) );
 
     connect( convert, SIGNAL(finishedProcess(int,bool,bool)), logger, SLOT(processCompleted(int,bool,bool)) );
 
@@ -246,11 +250,11 @@ bool soundKonverterView::showCdDialog( const QString& device, QString _profile,
         if( !notifyCommand.isEmpty() )
             dialog->setCommand( notifyCommand );
 
-        connect( dialog, SIGNAL(addTracks(const QString&,QList<int>,int,QList<TagData*>,ConversionOptions*,const QString&)), fileList, SLOT(addTracks(const QString&,QList<int>,int,QList<TagData*>,ConversionOptions*,const QString&)) );
+        connect( dialog, SIGNAL(addTracks(const QString&,QList<int>,int,QList<int>,QList<TagData*>,ConversionOptions*,const QString&)), fileList, SLOT(addTracks(const QString&,QList<int>,int,QList<int>,QList<TagData*>,ConversionOptions*,const QString&)) );
 
         dialog->exec();
 
-        disconnect( dialog, SIGNAL(addTracks(const QString&,QList<int>,int,QList<TagData*>,ConversionOptions*,const QString&)), 0, 0 );
+        disconnect( dialog, SIGNAL(addTracks(const QString&,QList<int>,int,QList<int>,QList<TagData*>,ConversionOptions*,const QString&)), 0, 0 );
 
         if( dialog->result() == QDialog::Accepted )
         {
@@ -401,37 +405,11 @@ void soundKonverterView::addConvertFiles( const KUrl::List& urls, QString _profi
 
         cleanupParameters( &profile, &format );
 
-        const bool isUserProfile = config->data.profiles.contains(profile);
+        ConversionOptions *conversionOptions = createConversionOptions( profile, format, directory );
 
-        if( ( !profile.isEmpty() && !format.isEmpty() && !directory.isEmpty() ) || isUserProfile )
+        if( conversionOptions )
         {
-            ConversionOptions *conversionOptions = 0;
-
-            if( !isUserProfile )
-            {
-                Options *options = new Options( config, "", 0 );
-                options->hide();
-                options->setProfile( profile );
-                options->setFormat( format );
-                options->setOutputDirectory( directory );
-                conversionOptions = options->currentConversionOptions();
-                delete options;
-            }
-            else
-            {
-                conversionOptions = config->data.profiles.value( profile )->copy();
-            }
-
-            if( conversionOptions )
-            {
-                fileList->addFiles( k_urls, conversionOptions, notifyCommand );
-            }
-            else
-            {
-                // FIXME error message, null pointer for conversion options
-//                 KMessageBox::error( this, i18n("Sorry, this shouldn't happen.\n\nPlease report this bug and attach the following error message:\n\nsoundKonverterView::addConvertFiles; Options::currentConversionOptions returned 0"), i18n("Internal error") );
-                KMessageBox::error( this, "Sorry, this shouldn't happen.\n\nPlease report this bug and attach the following error message:\n\nsoundKonverterView::addConvertFiles; conversionOptions=0, isUserProfile="+QString::number(isUserProfile), "Internal error" );
-            }
+            fileList->addFiles( k_urls, conversionOptions, notifyCommand );
         }
         else
         {
@@ -456,6 +434,34 @@ void soundKonverterView::addConvertFiles( const KUrl::List& urls, QString _profi
     fileList->save( false );
 }
 
+void soundKonverterView::addConvertFiles( const KUrl::List& urls, const ConversionOptions *conversionOptions, const QString& codecName, const QString& notifyCommand )
+{
+    fileList->addFiles( urls, conversionOptions->copy(), notifyCommand, codecName );
+
+    fileList->save( false );
+}
+
+ConversionOptions *soundKonverterView::createConversionOptions( QString profile, QString format, const QString& directory )
+{
+    cleanupParameters( &profile, &format );
+
+    if( config->data.profiles.contains(profile) )
+        return config->data.profiles.value( profile )->copy();
+
+    if( profile.isEmpty() || format.isEmpty() || directory.isEmpty() )
+        return 0;
+
+    Options *options = new Options( config, "", 0 );
+    options->hide();
+    options->setProfile( profile );
+    options->setFormat( format );
+    options->setOutputDirectory( directory );
+    ConversionOptions *conversionOptions = options->currentConversionOptions();
+    delete options;
+
+    return conversionOptions;
+}
+
 void soundKonverterView::loadAutosaveFileList()
 {
     fileList->load( false );
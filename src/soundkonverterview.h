@@ -22,6 +22,7 @@ class Logger;
 class CDManager;
 class FileList;
 class OptionsLayer;
+class ConversionOptions;
 
 // class QPainter;
 // class KUrl;
@@ -47,6 +48,10 @@ public:
     ~soundKonverterView();
 
     void addConvertFiles( const KUrl::List& urls, QString _profile, QString _format, const QString& directory, const QString& notifyCommand = "" );
+    /** Adds @p urls, that are all encoded with @p codecName, with a copy of @p conversionOptions */
+    void addConvertFiles( const KUrl::List& urls, const ConversionOptions *conversionOptions, const QString& codecName, const QString& notifyCommand = "" );
+    /** Returns new conversion options for the command line parameters or 0 if they are incomplete */
+    ConversionOptions *createConversionOptions( QString profile, QString format, const QString& directory );
     void loadAutosaveFileList();
     void loadFileList(const QString& fileListPath);
 
@@ -120,6 +125,8 @@ signals:
     void signalConversionStarted();
     void signalConversionStopped( bool failed );
     void showLog( const int logId );
+    /** The conversion output @p path is going to be written */
+    void outputFileCreated( const QString& path );
 };
 
 #endif // _soundKonverterVIEW_H_
@@ -0,0 +1,92 @@
+
+#include "startuptrace.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QList>
+#include <QTextStream>
+
+
+struct TraceEvent
+{
+    QString name;
+    QString category;
+    qint64 begin;   // [µs]
+    qint64 duration;// [µs]
+};
+
+static QString traceFileName;
+static QElapsedTimer traceTimer;
+static QList<TraceEvent> traceEvents;
+
+
+StartupTrace::Span::Span( const QString& _name, const QString& _category )
+    : name( _name ),
+    category( _category ),
+    begin( -1 )
+{
+    if( isEnabled() )
+        begin = traceTimer.nsecsElapsed() / 1000;
+}
+
+StartupTrace::Span::~Span()
+{
+    if( begin < 0 || !isEnabled() )
+        return;
+
+    TraceEvent event;
+    event.name = name;
+    event.category = category;
+    event.begin = begin;
+    event.duration = traceTimer.nsecsElapsed() / 1000 - begin;
+    traceEvents.append( event );
+}
+
+void StartupTrace::enable( const QString& fileName )
+{
+    if( fileName.isEmpty() || isEnabled() )
+        return;
+
+    traceFileName = fileName;
+    traceTimer.start();
+}
+
+bool StartupTrace::isEnabled()
+{
+    return !traceFileName.isEmpty();
+}
+
+static QString escapeJson( QString string )
+{
+    string.replace( "\\", "\\\\" );
+    string.replace( "\"", "\\\"" );
+    string.replace( "\n", "\\n" );
+    return string;
+}
+
+void StartupTrace::write()
+{
+    if( !isEnabled() )
+        return;
+
+    QFile file( traceFileName );
+    if( file.open(QIODevice::WriteOnly | QIODevice::Text) )
+    {
+        const qint64 pid = QCoreApplication::applicationPid();
+
+        QTextStream stream( &file );
+        stream.setCodec( "UTF-8" );
+        stream << "{\"traceEvents\":[\n";
+        for( int i=0; i<traceEvents.count(); i++ )
+        {
+            const TraceEvent& event = traceEvents.at(i);
+            stream << "{\"name\":\"" << escapeJson(event.name) << "\",\"cat\":\"" << escapeJson(event.category) << "\",\"ph\":\"X\",\"ts\":" << event.begin << ",\"dur\":" << event.duration << ",\"pid\":" << pid << ",\"tid\":1}";
+            stream << ( i + 1 < traceEvents.count() ? ",\n" : "\n" );
+        }
+        stream << "],\"displayTimeUnit\":\"ms\"}\n";
+    }
+
+    traceFileName.clear();
+    traceEvents.clear();
+}
@@ -0,0 +1,39 @@
+
+#ifndef STARTUPTRACE_H
+#define STARTUPTRACE_H
+
+#include <QString>
+
+
+/**
+ * @short Records the duration of the startup phases and writes them as a Chrome trace file
+ *
+ * Tracing is enabled with the --trace option or the SOUNDKONVERTER_TRACE environment
+ * variable, both take the path of the file the trace will be written to.
+ * The file can be opened with chrome://tracing or https://ui.perfetto.dev
+ */
+class StartupTrace
+{
+public:
+    /** Measures the time from its construction until it gets destroyed */
+    class Span
+    {
+    public:
+        explicit Span( const QString& _name, const QString& _category = "startup" );
+        ~Span();
+
+    private:
+        QString name;
+        QString category;
+        qint64 begin;
+    };
+
+    /** Enables tracing, the trace will be written to @p fileName */
+    static void enable( const QString& fileName );
+    static bool isEnabled();
+
+    /** Writes all recorded spans to the trace file and disables tracing */
+    static void write();
+};
+
+#endif // STARTUPTRACE_H
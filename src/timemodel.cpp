@@ -0,0 +1,143 @@
+
+#include "timemodel.h"
+#include "core/backendplugin.h"
+#include "core/conversionoptions.h"
+
+#include <QDataStream>
+#include <QFile>
+
+#include <KStandardDirs>
+
+
+#define TIME_MODEL_VERSION 1
+
+// the weight of a new measurement in the moving average
+#define SampleWeight 0.3f
+// ignore measurements of very short files, the start up time of the backends dominates them
+#define MinimumLength 5.0f
+
+
+const float TimeModel::DefaultFactor = 0.02f;
+
+
+TimeModel::TimeModel( QObject *parent )
+    : QObject( parent )
+{
+    fileName = KStandardDirs::locateLocal( "data", "soundkonverter/time_model.dat" );
+    loaded = false;
+    changed = false;
+}
+
+TimeModel::~TimeModel()
+{
+    save();
+}
+
+void TimeModel::load()
+{
+    if( loaded )
+        return;
+
+    loaded = true;
+
+    QFile file( fileName );
+    if( !file.open(QIODevice::ReadOnly) )
+        return;
+
+    QDataStream stream( &file );
+    stream.setVersion( QDataStream::Qt_4_6 );
+
+    qint32 version;
+    stream >> version;
+    if( version != TIME_MODEL_VERSION )
+        return;
+
+    stream >> factors;
+
+    if( stream.status() != QDataStream::Ok )
+        factors.clear();
+}
+
+void TimeModel::save()
+{
+    if( !changed )
+        return;
+
+    QFile file( fileName );
+    if( !file.open(QIODevice::WriteOnly) )
+        return;
+
+    QDataStream stream( &file );
+    stream.setVersion( QDataStream::Qt_4_6 );
+
+    stream << (qint32)TIME_MODEL_VERSION;
+    stream << factors;
+
+    file.close();
+
+    changed = false;
+}
+
+QString TimeModel::stageKey( const ConversionPipeTrunk& trunk, const ConversionOptions *conversionOptions )
+{
+    QString key = QString("%1:%2:%3").arg(trunk.plugin ? trunk.plugin->name() : "").arg(trunk.codecFrom).arg(trunk.codecTo);
+
+    // the speed of encoders depends on the quality
+    if( conversionOptions && trunk.codecTo != "wav" && trunk.codecTo == conversionOptions->codecName )
+    {
+        switch( conversionOptions->qualityMode )
+        {
+            case ConversionOptions::Quality:
+                key += ":q" + QString::number(conversionOptions->quality,'f',1);
+                break;
+            case ConversionOptions::Bitrate:
+                key += ":b" + QString::number(conversionOptions->bitrate);
+                break;
+            case ConversionOptions::Lossless:
+                key += ":lossless";
+                break;
+        }
+    }
+
+    return key;
+}
+
+QString TimeModel::replayGainKey( const QString& pluginName, const QString& codecName )
+{
+    return QString("replaygain:%1:%2").arg(pluginName).arg(codecName);
+}
+
+float TimeModel::stageFactor( const QString& key, float fallback )
+{
+    load();
+
+    return factors.value( key, fallback );
+}
+
+void TimeModel::addStage( const QString& key, float length, float wallTime )
+{
+    if( length < MinimumLength || wallTime <= 0.0f )
+        return;
+
+    addSample( key, wallTime / length );
+}
+
+float TimeModel::estimateLength( qint64 fileSize, bool lossless )
+{
+    // assume CD quality, lossless codecs compress it to about 60 %, lossy files have about 192 kbit/s
+    const float bytesPerSecond = lossless ? 176400 * 0.6f : 192000 / 8;
+
+    return qMax( 1.0f, fileSize / bytesPerSecond );
+}
+
+void TimeModel::addSample( const QString& key, float factor )
+{
+    load();
+
+    if( factors.contains(key) )
+        factors[key] = ( 1.0f - SampleWeight ) * factors.value(key) + SampleWeight * factor;
+    else
+        factors[key] = factor;
+
+    changed = true;
+}
@@ -0,0 +1,59 @@
+
+#ifndef TIMEMODEL_H
+#define TIMEMODEL_H
+
+#include <QObject>
+#include <QHash>
+
+class ConversionOptions;
+struct ConversionPipeTrunk;
+
+
+/**
+ * @short Learns how long the backends need for converting a file, used for estimating the remaining time
+ *
+ * All times are stored as the wall time needed per second of audio. For each conversion
+ * step (backend, codecs and quality) a moving average of the measured times is kept and
+ * saved between starts.
+ */
+class TimeModel : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TimeModel( QObject *parent );
+    ~TimeModel();
+
+    /** The guessed wall time per second of audio for a conversion step until the real one has been learned, 1.0 is about 50x realtime */
+    static const float DefaultFactor;
+
+    /** Writes the model to disc if it has been changed */
+    void save();
+
+    /** Returns the key for the conversion step @p trunk, the quality is only taken into account for encoders */
+    static QString stageKey( const ConversionPipeTrunk& trunk, const ConversionOptions *conversionOptions );
+    /** Returns the key for calculating Replay Gain with @p pluginName */
+    static QString replayGainKey( const QString& pluginName, const QString& codecName );
+
+    /** Returns the learned wall time per second of audio for @p key or @p fallback if nothing has been learned, yet */
+    float stageFactor( const QString& key, float fallback );
+    /** The step @p key took @p wallTime seconds for @p length seconds of audio */
+    void addStage( const QString& key, float length, float wallTime );
+
+    /** Estimates the length of a file whose tags couldn't be read from its size */
+    static float estimateLength( qint64 fileSize, bool lossless );
+
+private:
+    /** Loads the model on first use */
+    void load();
+
+    void addSample( const QString& key, float factor );
+
+    /** QHash< key, wall time per second of audio > */
+    QHash<QString,float> factors;
+
+    QString fileName;
+    bool loaded;
+    bool changed;
+};
+
+#endif // TIMEMODEL_H